@@ -45,3 +45,212 @@ def test_huffman_samples(test):
 	out = b'https://www.example.com'
 	test/module.huffman_decode(j) == out
 	test/module.huffman_encode(out) == j
+
+def test_integer_coding(test):
+	"""
+	# - &<http://httpwg.org/specs/rfc7541.html#integer.representation.examples>
+	"""
+	test/module.integer_encode(10, 5) == b'\x0a'
+	test/module.integer_encode(1337, 5) == b'\x1f\x9a\x0a'
+	test/module.integer_encode(42, 8) == b'\x2a'
+	test/module.integer_encode(10, 5, 0xE0) == b'\xea'
+
+	test/module.integer_decode(b'\xea', 0, 5) == (10, 1)
+	test/module.integer_decode(b'\x00\x1f\x9a\x0a', 1, 5) == (1337, 4)
+
+	for i in range(0, 70000, 7):
+		test/module.integer_decode(module.integer_encode(i, 6), 0, 6) == (i, len(module.integer_encode(i, 6)))
+
+	# Unbounded continuation.
+	test/module.CompressionError ^ (lambda: module.integer_decode(b'\x1f' + b'\xff' * 8 + b'\x01', 0, 5))
+
+# RFC 7541 C.4; requests with Huffman coding.
+requests = [
+	(
+		[(b':method', b'GET'), (b':scheme', b'http'), (b':path', b'/'), (b':authority', b'www.example.com')],
+		bytes.fromhex('828684418cf1e3c2e5f23a6ba0ab90f4ff'),
+		57,
+	),
+	(
+		[(b':method', b'GET'), (b':scheme', b'http'), (b':path', b'/'), (b':authority', b'www.example.com'),
+			(b'cache-control', b'no-cache')],
+		bytes.fromhex('828684be5886a8eb10649cbf'),
+		110,
+	),
+	(
+		[(b':method', b'GET'), (b':scheme', b'https'), (b':path', b'/index.html'),
+			(b':authority', b'www.example.com'), (b'custom-key', b'custom-value')],
+		bytes.fromhex('828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf'),
+		164,
+	),
+]
+
+# RFC 7541 C.6; responses with Huffman coding and a 256 byte table.
+responses = [
+	(
+		[(b':status', b'302'), (b'cache-control', b'private'),
+			(b'date', b'Mon, 21 Oct 2013 20:13:21 GMT'), (b'location', b'https://www.example.com')],
+		bytes.fromhex(
+			'488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff'
+			'6e919d29ad171863c78f0b97c8e9ae82ae43d3'
+		),
+		222,
+	),
+	(
+		[(b':status', b'307'), (b'cache-control', b'private'),
+			(b'date', b'Mon, 21 Oct 2013 20:13:21 GMT'), (b'location', b'https://www.example.com')],
+		bytes.fromhex('4883640effc1c0bf'),
+		222,
+	),
+	(
+		[(b':status', b'200'), (b'cache-control', b'private'),
+			(b'date', b'Mon, 21 Oct 2013 20:13:22 GMT'), (b'location', b'https://www.example.com'),
+			(b'content-encoding', b'gzip'),
+			(b'set-cookie', b'foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1')],
+		bytes.fromhex(
+			'88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7'
+			'821dd7f2e6c7b335dfdfcd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed'
+			'4ee5b1063d5007'
+		),
+		215,
+	),
+]
+
+def test_Decoder_vectors(test):
+	d = module.Decoder()
+	for headers, block, size in requests:
+		test/d.decode(block) == headers
+		test/d.table.size == size
+
+	d = module.Decoder(256)
+	for headers, block, size in responses:
+		test/d.decode(block) == headers
+		test/d.table.size == size
+
+def test_Encoder_vectors(test):
+	e = module.Encoder()
+	for headers, block, size in requests:
+		test/e.encode(headers) == block
+		test/e.table.size == size
+
+	e = module.Encoder(256, never_indexed=())
+	for headers, block, size in responses:
+		test/e.encode(headers) == block
+		test/e.table.size == size
+
+def test_Encoder_never_indexed(test):
+	"""
+	# - &module.Encoder.never_indexed
+	"""
+	e = module.Encoder()
+	d = module.Decoder()
+	h = [(b'authorization', b'secret'), (b'authorization', b'secret')]
+
+	block = e.encode(h)
+	test/e.table.size == 0
+	test/(block[0] & 0xF0) == 0x10
+	test/d.decode(block) == h
+	test/d.table.size == 0
+
+def test_Table_eviction(test):
+	"""
+	# - &module.Table
+	"""
+	t = module.Table(100)
+	t.insert(b'a', b'1') # 34
+	t.insert(b'b', b'2')
+	test/t.get(62) == (b'b', b'2')
+	test/t.get(63) == (b'a', b'1')
+
+	# Third entry evicts the first.
+	t.insert(b'c', b'3')
+	test/t.size == 68
+	test/t.get(62) == (b'c', b'3')
+	test/t.get(63) == (b'b', b'2')
+	test/module.CompressionError ^ (lambda: t.get(64))
+
+	test/t.search(b'b', b'2') == (63, True)
+	test/t.search(b'b', b'x') == (63, False)
+	test/t.search(b':path', b'/') == (4, True)
+
+	# Oversized entry empties the table.
+	t.insert(b'd', b'x' * 100)
+	test/t.size == 0
+	test/len(t) == 0
+
+	t.insert(b'a', b'1')
+	t.resize(0)
+	test/t.size == 0
+
+def test_Decoder_size_updates(test):
+	"""
+	# - &module.Decoder.resize
+	"""
+	d = module.Decoder()
+	d.decode(requests[0][1])
+	test/d.table.size == 57
+
+	# Update to zero followed by the original size.
+	test/d.decode(b'\x20\x3f\xe1\x1f' + b'\x82') == [(b':method', b'GET')]
+	test/d.table.size == 0
+
+	# Updates must precede fields.
+	test/module.CompressionError ^ (lambda: d.decode(b'\x82\x20'))
+
+	# Updates may not exceed the local limit.
+	d.resize(256)
+	test/module.CompressionError ^ (lambda: d.decode(b'\x3f\xe1\x1f'))
+
+	e = module.Encoder()
+	e.resize(0)
+	e.resize(256)
+	block = e.encode([(b':method', b'GET')])
+	test/block == b'\x20\x3f\xe1\x01\x82'
+	test/d.decode(block) == [(b':method', b'GET')]
+
+def test_Decoder_invalid(test):
+	d = module.Decoder()
+	test/module.CompressionError ^ (lambda: d.decode(b'\x80'))
+	test/module.CompressionError ^ (lambda: d.decode(b'\xff\x7f'))
+	test/module.CompressionError ^ (lambda: d.decode(b'\x41\x85'))
+
+def test_huffman_invalid(test):
+	# Padding longer than seven bits.
+	test/module.CompressionError ^ (lambda: module.huffman_decode(b'\xff'))
+	# Padding not of EOS.
+	test/module.CompressionError ^ (lambda: module.huffman_decode(b'\x00'))
+	# Explicit EOS.
+	test/module.CompressionError ^ (lambda: module.huffman_decode(b'\xff\xff\xff\xfc'))
+	test/module.huffman_decode(b'') == b''
+
+def test_huffman_native(test):
+	"""
+	# - &module.hdecode
+	# - &module.hencode
+	"""
+	if module.hdecode is module.huffman_decode:
+		test.skip("native huffman implementation not available")
+
+	import random
+	r = random.Random(0)
+	for x in samples + [bytes(r.randrange(256) for i in range(r.randrange(64))) for j in range(512)]:
+		coded = module.huffman_encode(x)
+		test/module.hencode(x) == coded
+		test/module.hlength(x) == len(coded)
+		test/module.hdecode(coded) == x
+
+	for x in [b'\xff', b'\x00', b'\xff\xff\xff\xfc']:
+		test/ValueError ^ (lambda: module.hdecode(x))
+
+def test_hpack_performance(test):
+	"""
+	# Measure header block coding with the selected Huffman implementation.
+	"""
+	headers = requests[2][0] + responses[2][0]
+	e = module.Encoder()
+	d = module.Decoder()
+
+	def cycle():
+		d.decode(e.encode(headers))
+
+	test.time(cycle, count=2000, time=1)
@@ -73,6 +73,60 @@ def test_Disassembler_bypass(test):
 	test/x == events
 	test/state.send(b'More') == [(module.ev_bypass, b'More')]
 
+def test_Disassembler_response_persistence(test):
+	"""
+	Check that HTTP/1.1 responses persist unless the connection is closed
+	and that HTTP/1.0 responses only persist with keep-alive.
+	"""
+	def response(version, *fields):
+		return version + b" 200 OK\r\n" + b"".join(fields) + b"Content-Length: 0\r\n\r\n"
+
+	state = module.disassembly(disposition='client')
+	events = state.send(response(b'HTTP/1.1') + response(b'HTTP/1.1'))
+	test/[x[0] for x in events].count(module.ev_rline) == 2
+	test/(module.ev_bypass in [x[0] for x in events]) == False
+
+	state = module.disassembly(disposition='client')
+	ka = b"Connection: Keep-Alive\r\n"
+	events = state.send(response(b'HTTP/1.0', ka) + response(b'HTTP/1.0'))
+	test/[x[0] for x in events].count(module.ev_rline) == 2
+	test/state.send(b'More') == [(module.ev_bypass, b'More')]
+
+	state = module.disassembly(disposition='client')
+	close = b"Connection: close\r\n"
+	events = state.send(response(b'HTTP/1.1', close) + b'BYPASS')
+	test/events[-1] == (module.ev_bypass, b'BYPASS')
+
+def test_Disassembler_empty_headers(test):
+	"""
+	Check that a message without headers does not consume
+	the headers of a pipelined message.
+	"""
+	data = b"GET / HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nHost: x\r\n\r\n"
+	state = module.disassembly()
+	events = state.send(data)
+	test/events == [
+		(module.ev_rline, (b'GET', b'/', b'HTTP/1.1')),
+		module.EOH,
+		module.EOM,
+		(module.ev_bypass, b"GET /b HTTP/1.1\r\nHost: x\r\n\r\n"),
+	]
+
+def test_Disassembler_size_range(test):
+	"""
+	Check that negative and overflowing sizes are not interpreted.
+	"""
+	for cl in (b'-5', b'99999999999999999999'):
+		state = module.disassembly()
+		events = state.send(b"GET / HTTP/1.1\r\nContent-Length: " + cl + b"\r\n\r\n")
+		test/events[-2][0] == module.ev_violation
+		test/events[-2][1][1] == 'invalid-header'
+		test/events[-1][0] == module.ev_bypass
+
+	state = module.disassembly()
+	events = state.send(b"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n-2\r\nab\r\n")
+	test/events[-2] == (module.ev_violation, ('protocol', 'chunk-field', b'-2'))
+
 def test_Disassembler_chunked_1(test):
 	"""
 	Test one chunk.
@@ -432,6 +486,40 @@ def test_Disassembler_invalid_content_length(test):
 	test/x == events
 	test/state.send(b'More') == [(module.ev_bypass, b'More')]
 
+def test_Tokenization_invalid_header(test):
+	"""
+	# - &module.Tokenization
+
+	# Check that a header line without a field separator is a violation
+	# whether the header set is complete or arrives incrementally.
+	"""
+	data = b"GET / HTTP/1.1\r\nHost: host\r\nInvalid\r\nOther: x\r\n\r\nBYPASS"
+	violation = (module.ev_violation,
+		('protocol', 'invalid-header', "header field has no separator", b'Invalid'))
+
+	state = module.Tokenization()
+	state.__next__()
+	events = state.send(data)
+	test/events == [
+		(module.ev_rline, (b'GET', b'/', b'HTTP/1.1')),
+		violation,
+		(module.ev_bypass, b"Invalid\r\nOther: x\r\n\r\nBYPASS"),
+	]
+	test/state.send(b'More') == [(module.ev_bypass, b'More')]
+
+	state = module.Tokenization()
+	state.__next__()
+	events = state.send(data[:36])
+	test/events == [
+		(module.ev_rline, (b'GET', b'/', b'HTTP/1.1')),
+		(module.ev_headers, [(b'Host', b'host')]),
+	]
+	events = state.send(data[36:])
+	test/events == [
+		violation,
+		(module.ev_bypass, b"Invalid\r\nOther: x\r\n\r\nBYPASS"),
+	]
+
 def test_Disassembler_invalid_chunk_field(test):
 	output = []
 	data = b"""GET / HTTP/1.1\r
@@ -646,3 +734,127 @@ def test_assemble_ooo(test):
 	g = module.assembly()
 	r = g.send([(module.ev_content, b'data')])
 	test/r == (b'data',)
+
+def test_assemble_template(test):
+	"""
+	# - &module.Template
+	# - &module.Fields
+	"""
+	t = module.Template([(b'Server', b'fault.io')], slots=[(b'X-Slot', lambda: b'value')])
+	test/t.t_block == b'Server: fault.io\r\n'
+	test/t.fields() == [(b'Server', b'fault.io'), (b'X-Slot', b'value')]
+
+	f = module.Fields(t, [(b'Content-Length', b'0')])
+	test/f.complete() == t.fields() + [(b'Content-Length', b'0')]
+
+	g = module.assembly()
+	r = g.send([
+		(module.ev_rline, (b'HTTP/1.1', b'200', b'OK')),
+		(module.ev_headers, f),
+		module.EOH,
+	])
+	test/b''.join(r) == b''.join([
+		b'HTTP/1.1 200 OK\r\n',
+		b'Server: fault.io\r\n',
+		b'X-Slot: value\r\n',
+		b'Content-Length: 0\r\n',
+		b'\r\n',
+	])
+
+	# Template without message specific fields.
+	r = g.send([(module.ev_headers, module.Fields(t)), module.EOH])
+	test/b''.join(r) == b'Server: fault.io\r\nX-Slot: value\r\n\r\n'
+
+def test_assemble_date(test):
+	"""
+	# - &module.date
+	"""
+	now = [784111777.5]
+	d = module.date(time=(lambda: now[0]), cache=[None, b''])
+	test/d == b'Sun, 06 Nov 1994 08:49:37 GMT'
+
+	cache = [None, b'']
+	first = module.date(time=(lambda: now[0]), cache=cache)
+	now[0] += 0.4
+	test/module.date(time=(lambda: now[0]), cache=cache) is first
+	now[0] += 1
+	test/module.date(time=(lambda: now[0]), cache=cache) == b'Sun, 06 Nov 1994 08:49:38 GMT'
+
+def test_assemble_pipelined(test):
+	"""
+	# Validate that multiple messages are assembled into a single buffer
+	# and that wire transfers are passed through.
+	"""
+	g = module.assembly()
+	message = [
+		(module.ev_rline, (b'HTTP/1.1', b'204', b'NO CONTENT')),
+		module.EOH,
+		module.EOM,
+	]
+	r = g.send(message * 3)
+	test/len(r) == 1
+	test/r[0] == b'HTTP/1.1 204 NO CONTENT\r\n\r\n' * 3
+
+	r = g.send(message + [(module.ev_wire, [b'raw', b'data'])])
+	test/list(r) == [b'HTTP/1.1 204 NO CONTENT\r\n\r\n', b'raw', b'data']
+
+	r = g.send([(module.ev_wire, [b'raw'])] + message)
+	test/list(r) == [b'raw', b'HTTP/1.1 204 NO CONTENT\r\n\r\n']
+
+differential_messages = [
+	b"GET / HTTP/1.0\r\nHost: host\r\n\r\n",
+	b"\r\nGET /index HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: 5\r\n\r\nABCDE"
+		b"POST /data HTTP/1.1\r\nConnection: keep-alive\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+		b"5\r\nfffff\r\n3;ext=1\r\nabc\r\n0\r\nTrailer: value\r\nOther:  x \r\n\r\n"
+		b"GET / HTTP/1.1\r\nHost: host\r\n\r\nBYPASS",
+	b"HTTP/1.1 200 OK\r\nContent-Length: 2\r\nContent-Length: 2\r\n\r\nOK",
+	b"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked, gzip\r\nConnection: keep-alive\r\n\r\n",
+	b"GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n",
+	b"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+	b"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabXX",
+	b"GET / HTTP/1.1\r\nHost: host\r\nInvalid\r\nOther: x\r\n\r\nBYPASS",
+	b"HTTP/1.1 200 OK\r\nInvalid\r\n\r\n",
+	b"GET / HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nHost: x\r\n\r\n",
+	b"GET / HTTP/1.1\r\nContent-Length: -5\r\n\r\nABCDE",
+	b"GET / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n",
+	b"GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n-2\r\nab\r\n",
+]
+
+def differential(test, config, data, size):
+	"""
+	# Compare the events produced by the Python and native implementations.
+	"""
+	py = module.Tokenization(**config)
+	py.__next__()
+	native = module.Disassembler(**config)
+	native.__next__()
+
+	for i in range(0, len(data), size):
+		part = data[i:i+size]
+		expect = py.send(part)
+		events = native.send(part)
+		test/events == expect
+
+def test_Disassembler_differential(test):
+	"""
+	# - &module.Disassembler
+	# - &module.Tokenization
+
+	# Validate that the native tokenization produces the same events
+	# as the Python implementation regardless of fragmentation.
+	"""
+	if module.Disassembler is module.Tokenization:
+		test.skip("native tokenization not available")
+
+	configurations = [
+		{},
+		{'disposition': 'client'},
+		{'constraints': module.Limits(max_header_size=24, max_line_size=12)},
+		{'constraints': module.Limits(max_headers=1, max_trailers=0, max_chunk_line_size=4)},
+		{'constraints': module.Limits(max_header_set_size=8, max_trailer_size=6)},
+	]
+
+	for config in configurations:
+		for data in differential_messages:
+			for size in range(1, len(data) + 1):
+				differential(test, config, data, size)
@@ -0,0 +1,234 @@
+"""
+# Validate the HTTP/2 connection state machine using a client and server pair.
+"""
+from ...internet import http2 as module
+
+request = [
+	(b':method', b'GET'),
+	(b':scheme', b'https'),
+	(b':authority', b'fault.io'),
+	(b':path', b'/'),
+]
+
+def transfer(source, target):
+	return target.receive(b''.join(source.transmit()))
+
+def pair(**server):
+	c = module.Connection('client')
+	s = module.Connection('server', **server)
+	transfer(c, s)
+	transfer(s, c)
+	transfer(c, s)
+	return c, s
+
+def test_frame(test):
+	f = module.frame(module.ft_ping, module.ff_ack, 0, b'\x00' * 8)
+	test/len(f) == 17
+	test/f[:9] == b'\x00\x00\x08\x06\x01\x00\x00\x00\x00'
+
+def test_settings(test):
+	"""
+	# Validate that the settings exchange is acknowledged and applied.
+	"""
+	c, s = pair(settings={module.st_max_frame_size: 1 << 15})
+	test/c.c_remote[module.st_max_frame_size] == (1 << 15)
+	test/s.c_remote[module.st_initial_window_size] == (1 << 20)
+	test/c.pending == False
+	test/s.pending == False
+
+def test_request_response(test):
+	c, s = pair()
+	sid = c.open()
+	test/sid == 1
+	c.headers(sid, request, end=True)
+
+	events = transfer(c, s)
+	test/events == [(module.ev_headers, 1, request, True)]
+
+	s.headers(sid, [(b':status', b'200')])
+	s.data(sid, b'body', True)
+	events = transfer(s, c)
+	test/events[0] == (module.ev_headers, 1, [(b':status', b'200')], False)
+	test/events[1] == (module.ev_data, 1, b'body', True)
+	test/c.c_streams == {}
+	test/s.c_streams == {}
+
+def test_end_stream_merge(test):
+	"""
+	# Validate that END_STREAM is set on unsent HEADERS when no data follows.
+	"""
+	c, s = pair()
+	sid = c.open()
+	c.headers(sid, request)
+	c.data(sid, b'', True)
+
+	frames = b''.join(c.transmit())
+	test/frames[3] == module.ft_headers
+	test/(frames[4] & module.ff_end_stream) == module.ff_end_stream
+	events = s.receive(frames)
+	test/events == [(module.ev_headers, 1, request, True)]
+
+def test_flow_control(test):
+	"""
+	# Validate that a body larger than the initial windows is delivered
+	# once window updates have been exchanged.
+	"""
+	c, s = pair()
+	sid = c.open()
+	c.headers(sid, request, end=True)
+	transfer(c, s)
+
+	body = bytes(range(256)) * 1024
+	s.headers(sid, [(b':status', b'200')])
+	s.data(sid, body, True)
+
+	received = []
+	for x in range(32):
+		received.extend(transfer(s, c))
+		transfer(c, s)
+		if not s.pending:
+			break
+
+	data = [x for x in received if x[0] == module.ev_data]
+	test/b''.join(x[2] for x in data) == body
+	test/data[-1][3] == True
+	for x in data:
+		test/len(x[2]) <= c.c_local[module.st_max_frame_size]
+
+def test_consumed_window(test):
+	"""
+	# Validate that windows are only replenished once received data is consumed.
+	"""
+	window = 1 << 15
+	c, s = pair(settings={module.st_initial_window_size: window})
+	sid = c.open()
+	c.headers(sid, request)
+	c.data(sid, b'x' * (window * 2), True)
+
+	def received():
+		return sum(len(x[2]) for x in transfer(c, s) if x[0] == module.ev_data)
+
+	test/received() == window
+	test/s.pending == False
+	test/received() == 0
+
+	# Returned to the peer once half of the window has been consumed.
+	s.consumed(sid, window // 4)
+	test/s.pending == False
+	s.consumed(sid, window // 4)
+	test/s.pending == True
+	transfer(s, c)
+	test/received() == window // 2
+
+def test_data_idle_stream(test):
+	"""
+	# Validate that DATA on an idle stream is a connection error.
+	"""
+	c, s = pair()
+	events = s.receive(module.frame(module.ft_data, 0, 1, b'data'))
+	test/events == [(module.ev_goaway, 0, module.ec_protocol_error)]
+	test/s.c_closed == True
+
+	# Closed streams are stream errors.
+	c, s = pair()
+	sid = c.open()
+	c.headers(sid, request, end=True)
+	transfer(c, s)
+	events = s.receive(module.frame(module.ft_data, 0, sid, b'data'))
+	test/events == [(module.ev_reset, sid, module.ec_stream_closed)]
+
+def test_continuation(test):
+	"""
+	# Validate that header blocks larger than a frame are split and reassembled.
+	"""
+	c, s = pair()
+	sid = c.open()
+	large = request + [(b'x-large-%d' % i, b'v' * 1024) for i in range(32)]
+	c.headers(sid, large, end=True)
+
+	frames = b''.join(c.transmit())
+	test/frames.count(bytes([module.ft_continuation])) > 0
+	events = s.receive(frames)
+	test/events == [(module.ev_headers, 1, large, True)]
+
+def test_ping(test):
+	c, s = pair()
+	c.c_output.append(module.frame(module.ft_ping, 0, 0, b'12345678'))
+	test/transfer(c, s) == []
+
+	frames = b''.join(s.transmit())
+	test/frames == module.frame(module.ft_ping, module.ff_ack, 0, b'12345678')
+
+def test_invalid_preface(test):
+	s = module.Connection('server')
+	events = s.receive(b'GET / HTTP/1.1\r\n\r\n')
+	test/events == [(module.ev_goaway, 0, module.ec_protocol_error)]
+	test/s.c_closed == True
+
+	frames = b''.join(s.transmit())
+	test/frames[-14] == module.ft_goaway
+
+def test_concurrency_limit(test):
+	"""
+	# Validate that streams exceeding the advertised limit are refused.
+	"""
+	c, s = pair(settings={module.st_max_concurrent_streams: 1})
+	first = c.open()
+	c.headers(first, request)
+	second = c.open()
+	c.headers(second, request)
+
+	events = transfer(c, s)
+	test/events[0][:2] == (module.ev_headers, first)
+	test/events[1] == (module.ev_reset, second, module.ec_refused_stream)
+
+	events = transfer(s, c)
+	test/events == [(module.ev_reset, second, module.ec_refused_stream)]
+
+def test_interleaving(test):
+	"""
+	# Validate that concurrent streams share the connection.
+	"""
+	c, s = pair()
+	sids = []
+	for i in range(2):
+		sid = c.open()
+		c.headers(sid, request, end=True)
+		sids.append(sid)
+	transfer(c, s)
+
+	for sid in sids:
+		s.headers(sid, [(b':status', b'200')])
+		s.data(sid, b'x' * (1 << 16), True)
+
+	events = [x for x in transfer(s, c) if x[0] == module.ev_data]
+	test/set(x[1] for x in events[:4]) == set(sids)
+
+def test_continuation_flood(test):
+	"""
+	# Validate that a header block is refused once it exceeds the header list size.
+	"""
+	c, s = pair(settings={module.st_max_header_list_size: 1024})
+	test/s.c_local[module.st_max_header_list_size] == 1024
+
+	sid = c.open()
+	s.receive(module.frame(module.ft_headers, 0, sid, b'\x82'))
+	fragment = module.frame(module.ft_continuation, 0, sid, b'\x00' * 256)
+	for x in range(3):
+		test/s.receive(fragment) == []
+	test/s.c_continuation_size == 769
+
+	events = s.receive(fragment)
+	test/events == [(module.ev_goaway, 0, module.ec_enhance_your_calm)]
+	test/s.c_closed == True
+
+def test_header_list_size(test):
+	"""
+	# Validate that decoded header lists are limited.
+	"""
+	c, s = pair(settings={module.st_max_header_list_size: 1024})
+	sid = c.open()
+	c.headers(sid, request + [(b'x-large', b'v' * 1024)], end=True)
+
+	events = transfer(c, s)
+	test/events == [(module.ev_goaway, 0, module.ec_enhance_your_calm)]
@@ -157,6 +157,68 @@ def test_Range(test):
 	# text/html;level=1 should have precedence over text/* and text/html
 	test/selection == (text_html, text_html_foo, 100)
 
+def test_Index(test):
+	"""
+	# Validate negotiation using a precomputed index of offered types.
+	"""
+	emptyset = frozenset()
+	text_plain = library.Type(('text','plain',emptyset))
+	text_xml = library.Type(('text','xml',emptyset))
+	app_json = library.Type(('application','json',emptyset))
+	text_any = library.Type(('text','*',emptyset))
+
+	index = library.Index([text_plain, text_xml, app_json])
+	test/index.query(library.any_range) == (text_plain, library.any_type, 100)
+
+	# Offered order selects between equal qualities.
+	r = library.Range.from_bytes(b'application/json,text/xml')
+	test/index.query(r) == (text_xml, text_xml, 100)
+
+	r = library.Range.from_bytes(b'application/xml,text/*;q = 0.5,text/xml')
+	test/index.query(r) == (text_xml, text_xml, 100)
+	test/library.Index([text_plain]).query(r) == (text_plain, text_any, 50)
+
+	r = library.Range.from_bytes(b'application/json;q=0.4,text/*;q = 0.5,text/xml;q=0.2')
+	test/index.query(r) == (text_plain, text_any, 50)
+
+	# The most specific entry determines the quality.
+	r = library.Range.from_bytes(b'text/*,text/plain;q=0.1')
+	test/index.query(r) == (text_xml, text_any, 100)
+	r = library.Range.from_bytes(b'*/*;q=0.5,text/plain;q=0')
+	test/index.query(r) == (text_xml, library.any_type, 50)
+
+	r = library.Range.from_bytes(b'image/png')
+	test/index.query(r) == None
+
+	html_l1 = library.Type(('text','html',frozenset([('level','1')])))
+	r = library.Range.from_bytes(b'text/html,text/html ;  level=\n	1  ,text/*')
+	test/library.Index([html_l1]).query(r) == (html_l1, html_l1, 100)
+
+	# Offered patterns.
+	r = library.Range.from_bytes(b'text/html')
+	test/library.Index([text_any]).query(r)[0] == text_any
+
+def test_Index_consistency(test):
+	"""
+	# Validate that &library.Index agrees with &library.Range.query
+	# when a single type is offered.
+	"""
+	offered = [library.type_from_string(x) for x in [
+		'text/html', 'text/plain', 'application/json', 'image/png', 'text/xml;level=1',
+	]]
+	ranges = [
+		b'text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8',
+		b'application/json',
+		b'text/*;q=0.5,text/plain',
+		b'image/*,*/*;q=0.1',
+		b'text/xml',
+	]
+	for x in ranges:
+		r = library.range_from_bytes(x)
+		test/library.range_from_bytes(x) is r
+		for t in offered:
+			test/library.Index([t]).query(r) == r.query(t)
+
 def test_file_type(test):
 	test/library.file_type('foo.svg') == library.Type.from_string('image/svg+xml')
 	test/library.file_type('foo.tar.gz') == library.Type.from_string('application/gzip')
@@ -531,6 +531,47 @@ def test_join_split_path(test):
 		s = module.split_path(us)
 		test/s == x
 
+def test_decode_percent_escapes(test):
+	d = module.decode_percent_escapes
+	test/d('') == ''
+	test/d('plain') == 'plain'
+	test/d('%41%2f%2F') == 'A//'
+	test/d('a%20b') == 'a b'
+	test/d('\u00e9%41') == '\u00e9A'
+	test/d('%E9') == '\u00e9'
+	# Irregular escapes interpreted by the Python implementation.
+	test/d('%4') == '\x04'
+	test/ValueError ^ (lambda: d('%zz'))
+
+def test_percent_native(test):
+	"""
+	# Validate that the native implementation is consistent with &module._decode_parts.
+	"""
+	try:
+		from ...internet import percent
+	except ImportError:
+		test.skip("native percent implementation not available")
+
+	import random
+	r = random.Random(0)
+	alphabet = 'ab/%%0123456789AFaf\u00e9\u4e00g'
+	for i in range(2048):
+		x = ''.join(r.choice(alphabet) for j in range(r.randrange(16)))
+		try:
+			expected = ''.join(module._decode_parts(x))
+		except ValueError:
+			expected = None
+
+		try:
+			native = percent.decode(x)
+		except ValueError:
+			# Irregular escapes are left to the Python implementation.
+			continue
+		test/native == expected
+
+	test/ValueError ^ (lambda: percent.decode('%4'))
+	test/TypeError ^ (lambda: percent.decode(b'%41'))
+
 def test_combinations(test, S=module.serialize, P=module.parse):
 	for x in samples():
 		s = S(x); p = P(s)
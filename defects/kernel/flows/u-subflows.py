@@ -135,6 +135,126 @@ def test_Catenation(test):
 	ctx()
 	test/x.terminated == True
 
+def test_Catenation_budgets(test):
+	"""
+	# Validate that waiting flows are obstructed by the byte limits
+	# and that the accounting is released when they are drained.
+	"""
+
+	ctx, S = testlib.sector()
+	c = flows.Collection.list()
+	x = flows.Catenation()
+	x.cat_queue_limit = 1000
+	x.cat_channel_limit = 2500
+	x.cat_limit = 4000
+	S.dispatch(c)
+	S.dispatch(x)
+	x.f_connect(c)
+
+	in1, in2, in3 = [flows.Relay(x, i) for i in (1, 2, 3)]
+	for r in (in1, in2, in3):
+		S.dispatch(r)
+
+	x.int_reserve(1, 2, 3)
+	x.int_connect(2, 2, in2)
+	x.int_connect(3, 3, in3)
+
+	# Per-channel limit.
+	in2.f_transfer([b'x' * 1000, b'y' * 1000])
+	test/in2.f_obstructed == False
+	in2.f_transfer([b'z' * 1000])
+	test/in2.f_obstructed == True
+	test/x.cat_queued == {2: 3000}
+
+	# Aggregate limit; channel 3 is within its own.
+	in3.f_transfer([b'a' * 1000])
+	test/in3.f_obstructed == False
+	in3.f_transfer([b'b' * 1000])
+	test/in3.f_obstructed == True
+	test/x.cat_queued_total == 5000
+	test/x.cat_high_water == 5000
+	test/x.cat_obstructed_count == 2
+
+	# Non-buffer transfers count as one.
+	test/x.cat_measure(-1) == 1
+
+	# Head of line completes; channel 2 is drained and cleared.
+	x.int_connect(1, 1, None)
+	ctx.flush()
+	test/in2.f_obstructed == False
+	test/in3.f_obstructed == True
+	test/x.cat_queued == {3: 2000}
+	test/x.cat_queued_total == 2000
+
+	in2.f_terminate()
+	ctx.flush()
+	test/in3.f_obstructed == False
+	test/x.cat_queued_total == 0
+	test/x.cat_high_water == 5000
+
+def test_Catenation_interleave(test):
+	"""
+	# - &library.Catenation.cat_interleave
+	"""
+
+	fc_terminate = flows.fe_terminate
+	fc_initiate = flows.fe_initiate
+	fc_transfer = flows.fe_transfer
+	ctx, S = testlib.sector()
+
+	c = flows.Collection.list()
+	x = flows.Catenation()
+	S.dispatch(c)
+	S.dispatch(x)
+	x.f_connect(c)
+
+	in1 = flows.Relay(x, 1)
+	in2 = flows.Relay(x, 2)
+	in3 = flows.Relay(x, 3)
+	S.dispatch(in1)
+	S.dispatch(in2)
+	S.dispatch(in3)
+
+	x.int_reserve(1, 2, 3)
+	x.int_connect(2, 2, in2)
+	in2.f_transfer(-1)
+	ctx.flush()
+	test/c.c_storage == []
+
+	# Queued flows are drained and the following are emitted immediately.
+	x.cat_interleave()
+	test/x.cat_sequenced == False
+	x.int_connect(3, 3, in3)
+	in3.f_transfer(-3)
+	in2.f_transfer(-2)
+	in3.f_terminate()
+	ctx.flush()
+
+	test/list(itertools.chain.from_iterable(c.c_storage)) == [
+		(fc_initiate, 2, 2),
+		(fc_transfer, 2, -1),
+		(fc_initiate, 3, 3),
+		(fc_transfer, 3, -3),
+		(fc_transfer, 2, -2),
+		(fc_terminate, 3, None),
+	]
+	del c.c_storage[:]
+	test/list(x.cat_order) == [1, 2]
+
+	x.int_connect(1, 1, None)
+	in2.f_terminate()
+	ctx.flush()
+	test/list(itertools.chain.from_iterable(c.c_storage)) == [
+		(fc_initiate, 1, 1),
+		(fc_terminate, 1, None),
+		(fc_terminate, 2, None),
+	]
+	test/list(x.cat_order) == []
+
+	x.f_terminate()
+	ctx()
+	test/x.terminated == True
+
 def test_Division(test):
 	"""
 	# - &library.Division
@@ -92,6 +92,67 @@ def test_Collection(test):
 	b.f_transfer([b'data', b' ', b'more'])
 	test/b.c_storage == b'data more'
 
+def test_Meter(test):
+	"""
+	# Validate windowed and weighted rates using a controlled clock.
+	"""
+	now = 0
+	m = library.Meter(buckets=4, resolution=100, halflife=100, clock=(lambda: now))
+	test/m.m_rate() == 0.0
+
+	m.m_record(10)
+	now = 50
+	m.m_record(10)
+	test/m.m_total == 20
+	test/m.m_bucket == 0
+	test/m.m_rate() == 20 * (1000000000 / 50)
+
+	now = 150
+	m.m_record(30)
+	# First bucket folded with half weight.
+	test/m.m_average == 20 * (1000000000 / 100) * 0.5
+	test/m.m_rate(window=100) == 30 * (1000000000 / 50)
+	test/m.m_rate() == 50 * (1000000000 / 150)
+
+	# Skipped buckets decay the average and expire from the ring.
+	before = m.m_average
+	now = 1050
+	m.m_record(1)
+	test/m.m_average < before
+	test/m.m_ring.count(0) == 3
+	# Three complete buckets and half of the current one.
+	test/m.m_rate(window=400) == 1 * (1000000000 / 350)
+	test/m.m_overall() == 51 * (1000000000 / 1050)
+
+	# Reads past the last record see the expired buckets as empty.
+	test/m.m_rate(now=2000) == 0.0
+
+def test_Monitor(test):
+	ctx = testlib.Executable()
+	exit = testlib.ExitController()
+	m = library.Monitor(lambda x: None)
+	m.sector = exit
+	m.executable = ctx
+	l = []
+	m.f_emit = l.append
+
+	m.f_transfer([b'data', b'more'])
+	m.f_transfer(None)
+	test/m.tm_meter.m_total == 9
+	test/l == [[b'data', b'more'], None]
+
+def test_Metering_fusion(test):
+	us = library.Channel()
+	mt = library.Metering()
+	c = library.Collection.list()
+	us.f_connect(mt)
+	mt.f_connect(c)
+
+	us.f_transfer([b'x' * 10])
+	us.f_transfer([b'y' * 5, b'z'])
+	test/mt.mt_meter.m_total == 16
+	test/len(c.c_storage) == 2
+
 if __name__ == '__main__':
 	import sys; from ....test import library as libtest
 	libtest.execute(sys.modules['__main__'])
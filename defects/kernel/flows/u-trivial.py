@@ -39,6 +39,71 @@ def test_Transformation(test):
 	ctx()
 	test/c.terminated == True
 
+def test_Transformation_fusion(test):
+	"""
+	# Validate that stateless stages are fused into the upstream's emitter
+	# and that the fusion follows changes to the chain.
+	"""
+	ec = testlib.ExitController()
+	ctx = testlib.Executable()
+	dispatched = []
+
+	us = flows.Channel()
+	t1 = flows.Transformation(lambda x: x + 1)
+	t2 = flows.Transformation(lambda x: x * 2)
+	d = flows.Dispatch(dispatched.append)
+	c = flows.Collection.list()
+	for x in (us, t1, t2, d, c):
+		x.sector = ec
+		x.executable = ctx
+		x.enqueue = ctx.enqueue
+
+	us.f_connect(t1)
+	t1.f_connect(t2)
+	t2.f_connect(d)
+	d.f_connect(c)
+
+	# Bypasses the stages' f_transfer methods.
+	test/(us.f_emit == t1.f_transfer) == False
+	us.f_transfer(1)
+	test/c.c_storage == [4]
+	test/dispatched == [4]
+
+	# Reconnecting a stage updates the upstream emitters.
+	c2 = flows.Collection.list()
+	c2.sector = ec
+	t2.f_connect(c2)
+	us.f_transfer(2)
+	test/c2.c_storage == [6]
+	test/c.c_storage == [4]
+	test/dispatched == [4]
+
+	# Terminated stages discard.
+	t2.f_terminate()
+	test/t2.terminated == True
+	us.f_transfer(3)
+	test/c2.c_storage == [6]
+
+def test_Transformation_fusion_override(test):
+	"""
+	# Validate that subclasses overriding f_transfer are not fused.
+	"""
+	class Counting(flows.Transformation):
+		count = 0
+		def f_transfer(self, event):
+			self.count += 1
+			super().f_transfer(event)
+
+	us = flows.Channel()
+	t = Counting(lambda x: -x)
+	c = flows.Collection.list()
+	us.f_connect(t)
+	t.f_connect(c)
+
+	us.f_transfer(5)
+	test/t.count == 1
+	test/c.c_storage == [-5]
+
 def setup_connected_flows():
 	ctx, usector, dsector = testlib.sector(2)
 
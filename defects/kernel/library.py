@@ -73,6 +73,25 @@ class Executable(object):
 	def _io_attach(self, *channel):
 		pass
 
+class Pool(Executable):
+	"""
+	# Executable whose worker pool submissions are performed when the task queue is drained.
+	# Faults are recorded without interrupting the faulted resource's sector.
+	"""
+
+	def submit(self, controller, completion, callable, *args, failure=None):
+		def perform():
+			try:
+				result = callable(*args)
+			except BaseException as exception:
+				failure(exception)
+			else:
+				completion(result)
+		self.enqueue(perform)
+
+	def faulted(self, resource):
+		self.faults.append(resource)
+
 class SystemChannel(object):
 	link = None
 	resource = None
@@ -0,0 +1,43 @@
+"""
+# Validate the process' integration of &...system.sampling.
+"""
+import os
+from ....kernel import system
+from ....system import process
+from ....system import files
+
+def test_Process_sampling(test):
+	"""
+	# Validate that (env)`SAMPLING_PROFILE` profiles the process and
+	# writes the samples when the exit stack is closed.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	os.environ['SAMPLING_PROFILE'] = str(tmp)
+	os.environ['SAMPLING_INTERVAL'] = '0.001'
+	try:
+		p = system.Process((lambda status: None), 'sampling')
+	finally:
+		del os.environ['SAMPLING_PROFILE']
+		del os.environ['SAMPLING_INTERVAL']
+
+	s = p.sampler
+	test.isinstance(s, system.sampling.Sampler)
+	loop = process.Scheduling.__defaults__[-1]
+	test/(loop.__code__ in s.s_boundaries) == True
+	test/s.s_running == True
+
+	p._exit_stack.__exit__(None, None, None)
+	test/s.s_running == False
+	test/s.s_thread == None
+
+	path = tmp/(str(os.getpid()) + '.samples')
+	test/path.fs_type() == 'data'
+
+def test_Process_sampling_disabled(test):
+	"""
+	# Validate that no sampler is created without (env)`SAMPLING_PROFILE`.
+	"""
+	os.environ.pop('SAMPLING_PROFILE', None)
+	p = system.Process((lambda status: None), 'unsampled')
+	test/p.sampler == None
+	p._exit_stack.__exit__(None, None, None)
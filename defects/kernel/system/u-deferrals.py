@@ -0,0 +1,93 @@
+"""
+# Validate the slotted timer structure used by &.kernel.system.Context.defer.
+"""
+from ....kernel import system
+
+class Processor(object):
+	def __init__(self, identifier):
+		self.identifier = identifier
+
+	def __repr__(self):
+		return 'Processor(%r)' % (self.identifier,)
+
+def test_Deferrals_coalesce(test):
+	"""
+	# Validate that expirations within the slack share a slot and wakeup.
+	"""
+	d = system.Deferrals(100)
+	a, b, c = Processor('a'), Processor('b'), Processor('c')
+
+	test/d.put(101, a) == 2
+	test/d.put(150, b) == 2
+	test/d.put(201, c) == 3
+	test/len(d) == 3
+	test/d.d_heap == [2, 3]
+
+	# Expirations are rounded up; never performed early.
+	test/d.next() == 200
+	test/d.get(199) == []
+	test/set(d.get(200)) == {a, b}
+	test/d.next() == 300
+	test/d.get(1000) == [c]
+	test/d.next() == None
+	test/len(d) == 0
+
+def test_Deferrals_cancel(test):
+	d = system.Deferrals(10)
+	a, b = Processor('a'), Processor('b')
+
+	d.put(5, a)
+	d.put(25, b)
+	test/d.discard(a) == True
+	test/d.discard(a) == False
+
+	# Emptied slots are skipped and released.
+	test/d.next() == 30
+	test/(1 in d.d_slots) == False
+	test/d.get(100) == [b]
+
+def test_Deferrals_reschedule(test):
+	"""
+	# Validate that deferring a processor again replaces its expiration.
+	"""
+	d = system.Deferrals(10)
+	a = Processor('a')
+
+	d.put(50, a)
+	d.put(15, a)
+	test/len(d) == 1
+	test/d.next() == 20
+	test/d.get(20) == [a]
+	test/d.next() == None
+
+	# Cancel followed by defer must leave the processor scheduled.
+	d.put(50, a)
+	d.discard(a)
+	d.put(70, a)
+	test/d.get(100) == [a]
+
+def test_Deferrals_weak(test):
+	d = system.Deferrals(10)
+	a = Processor('a')
+	d.put(10, a)
+	del a
+
+	test/len(d) == 0
+	test/d.next() == None
+
+def test_Deferrals_volume(test):
+	d = system.Deferrals(1000)
+	ps = [Processor(i) for i in range(10000)]
+	for i, p in enumerate(ps):
+		d.put(i * 7, p)
+
+	# One heap entry per occupied slot.
+	test/len(d.d_heap) == len(set(-(-(i*7) // 1000) for i in range(10000)))
+
+	for p in ps[::2]:
+		d.discard(p)
+	test/len(d) == 5000
+
+	fired = d.get(10000 * 7)
+	test/len(fired) == 5000
+	test/set(x.identifier for x in fired) == set(range(1, 10000, 2))
@@ -0,0 +1,136 @@
+"""
+# Validate the worker pool of &.kernel.system.Fabric.
+"""
+import time
+import collections
+
+from ....kernel import system
+
+class Process(object):
+	"""
+	# Process substitute collecting enqueued tasks and errors.
+	"""
+	def __init__(self):
+		self.tasks = collections.deque()
+		self.errors = []
+
+	def enqueue(self, task):
+		self.tasks.append(task)
+
+	def error(self, controller, exception, title):
+		self.errors.append((controller, exception, title))
+
+	def drain(self, count, timeout=4):
+		# Wait for &count completions and perform them.
+		executed = 0
+		deadline = time.time() + timeout
+		while executed < count and time.time() < deadline:
+			if self.tasks:
+				self.tasks.popleft()()
+				executed += 1
+			else:
+				time.sleep(0.001)
+		return executed
+
+class Controller(object):
+	def __init__(self):
+		self.faults = []
+
+	def fault(self, exception, association=None):
+		self.faults.append(exception)
+
+def test_Fabric_submit(test):
+	p = Process()
+	f = system.Fabric(p, workers=2)
+	ctl = Controller()
+	results = []
+
+	for i in range(16):
+		f.submit(ctl, results.append, (lambda x: x * 2), i)
+	test/f.accounting[ctl] == 16
+
+	test/p.drain(16) == 16
+	test/sorted(results) == [x * 2 for x in range(16)]
+	test/len(f._queues) <= 2
+	test/(ctl in f.accounting) == False
+
+def test_Fabric_errors(test):
+	p = Process()
+	f = system.Fabric(p, workers=1)
+	ctl = Controller()
+	results = []
+
+	def fail():
+		raise ValueError("failure")
+
+	f.submit(ctl, results.append, fail)
+	f.submit(ctl, results.append, (lambda: 'ok'))
+	test/p.drain(2) == 2
+
+	# Delivered to the controller in the task queue.
+	test/results == ['ok']
+	test/p.errors == []
+	test/len(ctl.faults) == 1
+	test.isinstance(ctl.faults[0], ValueError)
+	test/(ctl in f.accounting) == False
+
+	# Failure completion replaces the fault.
+	failures = []
+	f.submit(ctl, results.append, fail, failure=failures.append)
+	test/p.drain(1) == 1
+	test/len(failures) == 1
+	test.isinstance(failures[0], ValueError)
+	test/len(ctl.faults) == 1
+	test/(ctl in f.accounting) == False
+
+def test_Fabric_errors_released(test):
+	"""
+	# Validate that failures of released controllers are reported to the process.
+	"""
+	p = Process()
+	f = system.Fabric(p, workers=1)
+	ctl = Controller()
+
+	import _thread
+	blocked = _thread.allocate_lock()
+	blocked.acquire()
+
+	def fail():
+		blocked.acquire()
+		raise ValueError("failure")
+
+	f.submit(ctl, None, fail)
+	del ctl
+	blocked.release()
+	test/p.drain(1) == 1
+
+	test/len(p.errors) == 1
+	test/p.errors[0][0] == None
+	test.isinstance(p.errors[0][1], ValueError)
+
+def test_Fabric_stealing(test):
+	"""
+	# Validate that queued tasks are executed by other workers when one is blocked.
+	"""
+	p = Process()
+	f = system.Fabric(p, workers=2)
+	ctl = Controller()
+	results = []
+
+	import _thread
+	blocked = _thread.allocate_lock()
+	blocked.acquire()
+
+	f.submit(ctl, results.append, blocked.acquire)
+	# Wait for the first worker to start blocking.
+	while f._idle:
+		time.sleep(0.001)
+
+	for i in range(8):
+		f.submit(ctl, results.append, (lambda x: x), i)
+	test/p.drain(8) == 8
+	test/sorted(results) == list(range(8))
+
+	blocked.release()
+	test/p.drain(1) == 1
+	test/f.executing(_thread.get_ident()) == False
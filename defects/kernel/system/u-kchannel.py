@@ -1,3 +1,4 @@
+import os
 import collections
 import functools
 import importlib.util
@@ -5,6 +6,7 @@ import typing
 import itertools
 
 from ....kernel import system
+from ....system import files
 from .. import library as testlib
 
 def test_KInput(test):
@@ -40,6 +42,199 @@ def test_KOutput(test):
 	test/f.k_transferring == len(c.resource)
 	test/f.k_transferring == 5
 
+def test_KFileInput(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'data')
+	data = bytes(range(256)) * 64
+	with open(path, 'wb') as f:
+		f.write(data)
+
+	ctx = testlib.Pool()
+	f = system.KFileInput(os.open(path, os.O_RDONLY), 100, 10000)
+	f.kf_read_size = 4096
+	f.system = ctx
+	f.executable = ctx
+	f.controller = exits = testlib.ExitController()
+	out = []
+	f.f_emit = out.extend
+
+	f.actuate()
+	test/f.kf_pending == True
+	# Only one read is submitted at a time.
+	test/len(ctx.tasks) == 1
+
+	f.f_obstruct(test, None)
+	ctx()
+	test/out == [data[100:4196]]
+	test/len(ctx.tasks) == 0
+
+	f.f_clear(test)
+	ctx(8)
+	test/b''.join(out) == data[100:10000]
+	test/f.kf_fd == None
+	test/f.terminated == True
+	test/exits.exits == [f]
+
+def test_KFileInput_interrupt(test):
+	"""
+	# Validate that the descriptor is not closed while a read is pending.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'data')
+	with open(path, 'wb') as f:
+		f.write(b'x' * 128)
+
+	ctx = testlib.Pool()
+	fd = os.open(path, os.O_RDONLY)
+	f = system.KFileInput(fd, 0, 128)
+	f.system = ctx
+	f.executable = ctx
+	f.controller = exits = testlib.ExitController()
+	f.f_emit = (lambda x: None)
+	f.actuate()
+	test/f.kf_pending == True
+
+	f.interrupt()
+	test/f.kf_fd == None
+	test/f.kf_release == fd
+	# Still open for the worker.
+	test/os.fstat(fd).st_size == 128
+
+	ctx()
+	test/f.kf_pending == False
+	test/f.kf_release == None
+	test/OSError ^ (lambda: os.fstat(fd))
+
+def test_KFileInput_failure(test):
+	"""
+	# Validate that a failed read clears the pending state, closes the descriptor,
+	# and faults the channel.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'data')
+	with open(path, 'wb') as f:
+		f.write(b'x' * 128)
+
+	def pread(*args):
+		raise OSError("failed read")
+
+	class Failing(system.KFileInput):
+		def kf_transition(self):
+			super().kf_transition(pread=pread)
+
+	ctx = testlib.Pool()
+	fd = os.open(path, os.O_RDONLY)
+	f = Failing(fd, 0, 128)
+	f.system = ctx
+	f.executable = ctx
+	f.controller = exits = testlib.ExitController()
+	f.actuate()
+	ctx()
+
+	test/f.kf_pending == False
+	test/f.kf_fd == None
+	test/ctx.faults == [f]
+	test/OSError ^ (lambda: os.fstat(fd))
+
+def test_KFileOutput(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'data')
+	with open(path, 'wb') as f:
+		f.write(b'-' * 32)
+
+	ctx = testlib.Pool()
+	f = system.KFileOutput(os.open(path, os.O_WRONLY), 8)
+	f.system = ctx
+	f.executable = ctx
+	f.controller = exits = testlib.ExitController()
+	f.actuate()
+
+	f.f_transfer((b'first',))
+	test/f.kf_pending == True
+	f.f_transfer((b'second', b'third'))
+	test/f.f_empty == False
+
+	f.f_terminate()
+	test/f.terminated == False
+	ctx(4)
+	test/f.kf_position == 8 + 16
+	test/f.terminated == True
+	test/f.kf_fd == None
+	test/exits.exits == [f]
+
+	with open(path, 'rb') as f:
+		test/f.read() == b'--------firstsecondthird--------'
+
+def test_KFileOutput_append(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'log')
+	with open(path, 'wb') as f:
+		f.write(b'prefix:')
+
+	ctx = testlib.Pool()
+	f = system.KFileOutput(os.open(path, os.O_WRONLY|os.O_APPEND), None)
+	f.system = ctx
+	f.executable = ctx
+	f.actuate()
+
+	f.kf_limit = 1
+	f.f_transfer((b'a',))
+	f.f_transfer((b'b', b'c'))
+	test/f.f_obstructed == True
+	ctx()
+	ctx()
+	test/f.f_obstructed == False
+	test/f.kf_position == None
+
+	with open(path, 'rb') as f:
+		test/f.read() == b'prefix:abc'
+
+def test_Context_file_channels(test):
+	"""
+	# Validate that positional channels are only used for regular files.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'data')
+	with open(path, 'wb') as f:
+		f.write(b'data')
+
+	ctx = system.Context.__new__(system.Context)
+	regular = [
+		ctx.read_file(path),
+		ctx.read_file_range(path, 1, 3),
+		ctx.write_file(path),
+		ctx.append_file(path),
+		ctx.update_file(path, 2, 2),
+	]
+	test/[type(x) for x in regular] == [system.KFileInput] * 2 + [system.KFileOutput] * 3
+	test/regular[0].kf_stop == 4
+	test/[x.kf_position for x in regular[2:]] == [0, None, 2]
+	for x in regular:
+		x.kf_close()
+
+	# Devices are transferred by the system's event interfaces.
+	devices = [
+		ctx.read_file(os.devnull),
+		ctx.write_file(os.devnull),
+		ctx.append_file(os.devnull),
+		ctx.update_file(os.devnull, 0, 0),
+	]
+	test/[type(x) for x in devices] == [system.KInput] + [system.KOutput] * 3
+	for x in devices:
+		x.channel.terminate()
+
+def test_kf_write_partial(test):
+	writes = []
+	def pwritev(fd, views, position):
+		# Write at most three bytes per call.
+		chunk = bytes(b''.join(views))[:3]
+		writes.append((position, chunk))
+		return len(chunk)
+
+	n = system._kf_write(-1, [b'abcd', b'ef', b'g'], 10, pwritev=pwritev)
+	test/n == 7
+	test/writes == [(10, b'abc'), (13, b'def'), (16, b'g')]
+
 if __name__ == '__main__':
 	import sys; from ...test import library as libtest
 	libtest.execute(sys.modules['__main__'])
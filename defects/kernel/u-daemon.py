@@ -0,0 +1,56 @@
+"""
+# Validate the restart policy and statistics of &.kernel.daemon.ProcessManager.
+"""
+import os
+from ...kernel import daemon as module
+from ...system import metrics
+from ...system import files
+
+second = 1000000000
+
+def test_ProcessManager_exit_delay(test):
+	pm = module.ProcessManager(None, None, concurrency=2)
+	pm.ctl_started[1] = 0
+
+	# Long running worker; immediate restart.
+	test/pm.ctl_exit_delay(1, 10 * second) == 0
+
+	# Consecutive failures back off exponentially up to the limit.
+	pm.ctl_started[1] = 10 * second
+	test/pm.ctl_exit_delay(1, 10 * second + 1) == pm.ctl_restart_delay
+	test/pm.ctl_exit_delay(1, 10 * second + 1) == pm.ctl_restart_delay * 2
+	test/pm.ctl_exit_delay(1, 10 * second + 1) == pm.ctl_restart_delay * 4
+	pm.ctl_failures[1] = 64
+	test/pm.ctl_exit_delay(1, 10 * second + 1) == pm.ctl_restart_limit
+
+	# A worker that stays up resets the failures.
+	test/pm.ctl_exit_delay(1, 20 * second) == 0
+	test/(1 in pm.ctl_failures) == False
+
+def test_ProcessManager_statistics(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+
+	class Subprocess(object):
+		def __init__(self, pids):
+			self.sp_processes = pids
+
+	pm = module.ProcessManager(None, None, concurrency=2)
+	registries = []
+	for pid, n in ((101, 3), (102, 4)):
+		r = metrics.Registry(str(tmp/(str(pid) + '.metrics')), 4)
+		r.counter('requests').increment(n)
+		registries.append(r)
+
+	subs = [Subprocess({101: 1}), Subprocess({102: 2}), Subprocess({103: 3})]
+	for i, sp in enumerate(subs):
+		pm.ctl_fork_id_to_subprocess[i+1] = sp
+
+	os.environ['METRICS_EXPORT'] = str(tmp)
+	try:
+		test/pm.ctl_statistics() == {'requests': ('counter', 7)}
+	finally:
+		del os.environ['METRICS_EXPORT']
+
+	test/pm.ctl_statistics() == {}
+	for r in registries:
+		r.close()
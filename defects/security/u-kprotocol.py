@@ -104,3 +104,45 @@ def test_channel_terminate_full(test):
 	srx.f_terminate()
 	test/srx.terminated == True
 	test/shared.closed == True
+
+class Negotiation:
+	def __init__(self):
+		self.jobs = []
+		self.negotiating = True
+
+	def negotiate(self, tls, event, completion):
+		if not self.negotiating:
+			return False
+		self.jobs.append((event, completion))
+		return True
+
+def test_negotiation(test):
+	"""
+	# - &module.SecuredReceive.srx_negotiated
+	"""
+	ng = Negotiation()
+	tasks = []
+	srx, stx = module.allocate(TLS(), ng, tasks.append)
+	emitted = []
+	drained = []
+	srx.f_emit = emitted.append
+	stx.p_drain = (lambda: drained.append(True))
+
+	# Handshake transfers do not reach decipher.
+	srx.f_transfer([b"hello"])
+	test/emitted == []
+	test/len(ng.jobs) == 1
+	test/ng.jobs[0][0] == [b"hello"]
+
+	# Completion is routed through the queue.
+	ng.jobs[0][1]()
+	test/len(tasks) == 1
+	ng.negotiating = False
+	tasks[0]()
+	test/drained == [True]
+	test/emitted == [('reveal', ())]
+	test/srx.srx_negotiate == None
+
+	# Direct afterwards.
+	srx.f_transfer([b"data"])
+	test/emitted[-1] == ('reveal', [b"data"])
@@ -52,6 +52,63 @@ def test_Invocation_execute(test):
 	out, status = perform_cat([pid], stdin[1], stdout[0], data, stderr[0])
 	test/out == data
 
+def test_Invocation_spawn_many(test):
+	"""
+	# - &module.Invocation.prepare
+	# - &module.Invocation.spawn_many
+	"""
+	r, w = os.pipe()
+	echo = module.Invocation("/bin/echo", ("echo", "data"), environ={})
+
+	with open(os.devnull, 'rb+') as null:
+		echo.prepare(((null.fileno(), 0), (w, 1), (null.fileno(), 2)))
+		pids = echo.spawn_many(3)
+	os.close(w)
+
+	test/len(pids) == 3
+	test/len(set(pids)) == 3
+
+	out = b''
+	while True:
+		new = os.read(r, 512)
+		if not new:
+			break
+		out += new
+	os.close(r)
+
+	for pid in pids:
+		test/os.waitpid(pid, 0)[1] == 0
+	test/out == b'data\n' * 3
+
+	test/echo.spawn_many(0) == []
+	test/ValueError ^ (lambda: echo.spawn_many(-1))
+
+def test_Invocation_spawn_many_failure(test):
+	"""
+	# - &module.Invocation.spawn_many
+	"""
+	tr = test.exits.enter_context(files.Path.fs_tmpdir())
+	i = module.Invocation(str(tr / 'no-such.exe'), ())
+	test/FileNotFoundError ^ (lambda: i.spawn_many(2))
+
+def test_Invocation_pidfd(test):
+	"""
+	# - &module.Invocation.spawn_many
+	"""
+	inv = module.Invocation("/bin/sh", ("sh", "-c", "exit 3"), environ={})
+	inv.prepare()
+
+	pid, fd = inv(pidfd=True)
+	test/os.waitstatus_to_exitcode(os.waitpid(pid, 0)[1]) == 3
+	if fd == -1:
+		test.skip("process descriptors not available")
+	os.close(fd)
+
+	for pid, fd in inv.spawn_many(2, pidfd=True):
+		test/fd >= 0
+		test/os.waitstatus_to_exitcode(os.waitpid(pid, 0)[1]) == 3
+		os.close(fd)
+
 def test_Ports_new(test):
 	kp = module.Ports(list(range(10)))
 	test/list(kp) == list(range(10))
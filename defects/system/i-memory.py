@@ -1,3 +1,4 @@
+import weakref
 from ...system import memory as library
 
 def test_Segments(test):
@@ -7,8 +8,8 @@ def test_Segments(test):
 	class submap(mmap.mmap):
 		def close(self, *args):
 			nonlocal closed
-			closed.append(id(self))
 			super().close(*args)
+			closed.append(id(self))
 
 	with open(__file__, 'rb') as f:
 		data = f.read()
@@ -18,46 +19,31 @@ def test_Segments(test):
 		m = submap(f.fileno(), 0, access=mmap.ACCESS_READ)
 		return m
 
-	# del iseg, s, seg
+	# Slices hold the map; it is released with the last reference.
 	del closed[:]
 	m = new()
-	cur = id(m)
+	r = weakref.ref(m)
 	seg = library.Segments(m)
+	del m
 	iseg = seg.select(0, None, 512)
 	s = next(iseg)
-	test/seg.weaks << s
-	del s, seg
-	test/closed == []
-	del iseg
-	test/closed << cur
-
-	del closed[:]
-	m = new()
-	cur = id(m)
-	seg = library.Segments(m)
-	iseg = seg.select(0, None, 128)
-	s = next(iseg)
-	test/seg.weaks << s
 	del seg, iseg
-	# should not be closed
+	test/(r() is not None) == True
 	test/closed == []
-	# XXX: check referrers
 	del s
-	test/closed << cur
+	test/r() == None
 
-	# del s, seg, iseg
 	del closed[:]
 	m = new()
-	cur = id(m)
+	r = weakref.ref(m)
 	seg = library.Segments(m)
-	iseg = seg.select(0, None, 64)
-	s = list(iseg)
-	test/set(seg.weaks) == set(s)
-	del seg, iseg
-	# should not be closed
-	test/closed == []
+	del m
+	s = list(seg.select(0, None, 64))
+	del seg
+	test/(r() is not None) == True
+	test/b''.join(s) == data
 	del s
-	test/closed << cur
+	test/r() == None
 
 	# validate that range slicing is appropriate
 	del closed[:]
@@ -65,6 +51,7 @@ def test_Segments(test):
 	m = new()
 	cur = id(m)
 	seg = library.Segments(m)
+	del m
 	x = None
 	for x in seg.select(0, None, 64):
 		ba += x
@@ -74,7 +61,13 @@ def test_Segments(test):
 	test/closed << cur
 	test/data == ba
 
-	# test empty weaks close and Segments.open path.
+	# validate that unaligned ranges are respected
+	seg = library.Segments(new())
+	test/[bytes(x) for x in seg.select(10, 45, 16)] == [data[10:26], data[26:42], data[42:45]]
+	test/[bytes(x) for x in seg.select(10, 15, 16)] == [data[10:15]]
+	del seg
+
+	# test close without outstanding slices and the Segments.open path.
 	del closed[:]
 	class SSegments(library.Segments):
 		MemoryMap=submap
@@ -83,7 +76,7 @@ def test_Segments(test):
 	del seg
 	test/closed == [cur]
 
-	# test empty weaks close and Segments.open path.
+	# test close without outstanding slices and the Segments.open path.
 	del closed[:]
 	seg = SSegments.open(__file__)
 	cur = id(seg.memory)
@@ -92,3 +85,22 @@ def test_Segments(test):
 		break
 	del seg
 	test/closed == [cur]
+
+def test_Segments_advice(test):
+	"""
+	# - &library.Segments.open
+	# - &library.Segments.advise
+	"""
+	with open(__file__, 'rb') as f:
+		data = f.read()
+
+	seg = library.Segments.open(__file__, populate=True, huge=True)
+	test/b''.join(seg) == data
+	test/seg.advise('MADV_NOT_A_REAL_ADVICE') == False
+	test/isinstance(seg.advise('MADV_NORMAL', 0, 1), bool) == True
+
+	# Readahead advice does not alter the slices.
+	seg.readahead = 128
+	test/bytes(b''.join(seg.select(3, None, 100))) == data[3:]
+	seg.readahead = 0
+	test/bytes(b''.join(seg.select(3, 50, 7))) == data[3:50]
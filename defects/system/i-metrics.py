@@ -0,0 +1,79 @@
+"""
+# Validate the metrics registry and the interpretation of its exported region.
+"""
+import os
+from ...system import metrics as module
+from ...system import files
+
+def test_Registry_values(test):
+	r = module.Registry(None, 4)
+	c = r.counter('requests')
+	c.increment()
+	c.increment(4)
+	test/r.counter('requests') is c
+	test/c.value == 5
+
+	g = r.gauge('load')
+	g.set(1.5)
+	g.adjust(-0.5)
+	test/g.value == 1.0
+
+	h = r.histogram('latency', 10)
+	for v in (1, 10, 11, 5000, 10**9):
+		h.observe(v)
+	test/h.value == (5, 1 + 10 + 11 + 5000 + 10**9, (2, 1, 0, 1, 0, 0, 0))
+
+	test/r.snapshot()['requests'] == 5
+	test/module.interpret(r.r_map)[1][0] == ('requests', 'counter', 5)
+
+	test/ValueError ^ (lambda: r.gauge('requests'))
+	r.histogram('x')
+	test/OverflowError ^ (lambda: r.counter('y'))
+	r.close()
+
+def test_Registry_export(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'process.metrics')
+
+	r = module.Registry(path, 8)
+	r.counter('tasks').increment(3)
+	r.gauge('deferred').set(7)
+
+	pid, ms = module.read(path)
+	test/pid == os.getpid()
+	test/ms == [('tasks', 'counter', 3), ('deferred', 'gauge', 7.0)]
+
+	# Updates are visible without reallocating.
+	r.counter('tasks').increment()
+	test/module.read(path)[1][0] == ('tasks', 'counter', 4)
+
+	r.close()
+	test/os.path.exists(path) == False
+
+def test_Registry_environment(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	os.environ['METRICS_EXPORT'] = str(tmp)
+	try:
+		r = module.Registry.environment(capacity=2)
+	finally:
+		del os.environ['METRICS_EXPORT']
+
+	test/r.r_path == str(tmp/(str(os.getpid()) + '.metrics'))
+	r.unlink()
+	test/os.path.exists(r.r_path) == False
+	r.close()
+
+	r = module.Registry.environment(capacity=2)
+	test/r.r_path == None
+	r.close()
+
+def test_aggregate(test):
+	h = lambda c, t, b: ('latency', 'histogram', (c, t, tuple(zip((1, 10), b))))
+	first = [('tasks', 'counter', 3), ('load', 'gauge', 0.5), h(2, 5, (1, 1))]
+	second = [('tasks', 'counter', 4), ('load', 'gauge', 1.0), h(1, 9, (0, 1)), ('extra', 'counter', 1)]
+
+	totals = module.aggregate([first, second])
+	test/totals['tasks'] == ('counter', 7)
+	test/totals['load'] == ('gauge', 1.5)
+	test/totals['latency'] == ('histogram', (3, 14, ((1, 1), (10, 2))))
+	test/totals['extra'] == ('counter', 1)
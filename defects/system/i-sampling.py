@@ -0,0 +1,78 @@
+"""
+# Validate the stack sampling profiler.
+"""
+import sys
+import time
+import threading
+
+from ...system import sampling as module
+from ...system import files
+
+def loop(tasks):
+	# Stand-in for a task queue's execution loop.
+	for x in tasks:
+		x()
+
+def leaf(frames):
+	frames.append(sys._getframe())
+
+def task(frames):
+	leaf(frames)
+
+def test_Sampler_stack(test):
+	frames = []
+	loop([lambda: task(frames)])
+
+	s = module.Sampler(boundaries=[loop.__code__])
+	stack = s.s_stack(frames[0])
+	test/stack[-1] == __name__ + ':leaf'
+	test/stack[-2] == __name__ + ':task'
+	test/stack[0] == 'task:' + __name__ + ':test_Sampler_stack.<locals>.<lambda>'
+
+	# No boundary present; no attribution.
+	s = module.Sampler()
+	test/s.s_stack(frames[0])[0].startswith('task:') == False
+
+def test_Sampler_collapsed(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	frames = []
+	leaf(frames)
+
+	s = module.Sampler(threads=[1])
+	s.s_sample({1: frames[0], 2: frames[0]})
+	s.s_sample({1: frames[0]})
+	test/s.s_samples == 2
+
+	lines = list(s.collapsed())
+	test/len(lines) == 1
+	test/lines[0].endswith(__name__ + ':leaf 2\n') == True
+
+	path = str(tmp/'out.samples')
+	s.write(path)
+	with open(path) as f:
+		test/f.read() == lines[0]
+
+def test_Sampler_thread(test):
+	done = threading.Event()
+	def spin():
+		while not done.is_set():
+			sum(range(100))
+
+	t = threading.Thread(target=spin)
+	t.start()
+	s = module.Sampler(interval=0.001, threads=[t.ident])
+	s.start()
+	try:
+		time.sleep(0.05)
+	finally:
+		s.stop()
+		done.set()
+		t.join()
+
+	# Stopping waits for the sampling thread to exit.
+	test/s.s_thread == None
+	samples = s.s_samples
+	time.sleep(0.01)
+	test/s.s_samples == samples
+	test/s.s_samples > 0
+	test/any(x[-1].endswith('.spin') for x in s.s_counts) == True
@@ -79,3 +79,17 @@ def test_Procedure_indexing(test):
 	test/p[('work', 'w_prepared')] == 5
 	test/p[('msg', 'm_errors')] == 3
 	test/p[('usage', 'r_divisions')] == 20
+
+def test_live(test):
+	first = [
+		('requests', 'counter', 10),
+		('queued', 'gauge', 2.5),
+		('latency', 'histogram', (2, 30, ((10, 1), (100, 1), (1000, 0)))),
+	]
+	lines = module.live(None, first, 0)
+	test/lines[0] == "requests 10"
+	test/lines[1] == "queued   2.5"
+	test/lines[2] == "latency  n=2 mean=15 <=10:1 <=100:1"
+
+	second = [('requests', 'counter', 30)]
+	test/module.live(first, second, 2.0) == ["requests 30 (10.0/s)"]
@@ -0,0 +1,330 @@
+"""
+# Validate the connection pool used by &.web.agent.Navigation.
+"""
+from ...web import agent as module
+
+class Transport(object):
+	functioning = True
+	terminating = False
+	terminated = False
+
+	def __init__(self):
+		self.closed = False
+
+	def io_transmit_close(self):
+		self.closed = True
+
+def pool(**kw):
+	established = []
+	def connect(key):
+		c = module.Connection(key, Transport())
+		established.append(c)
+		return c
+	clock = [0]
+	p = module.Pool(connect, clock=(lambda: clock[0]), **kw)
+	return p, established, clock
+
+def test_Pool_reuse(test):
+	"""
+	# Validate that completed connections are reused for the same key.
+	"""
+	p, established, clock = pool()
+	acquired = []
+	key = ('fault.io', None, None)
+
+	first = p.p_acquire(key, acquired.append)
+	test/acquired == [first]
+	test/first.c_pending == 1
+	p.p_complete(first)
+	test/list(p.p_idle[key]) == [first]
+
+	second = p.p_acquire(key, acquired.append)
+	test/second is first
+	test/len(established) == 1
+
+	# Distinct keys do not share connections.
+	other = p.p_acquire(('fault.io', None, 'tls'), acquired.append)
+	test/other is not first
+	test/len(established) == 2
+
+def test_Pool_health(test):
+	"""
+	# Validate that unhealthy and expired idle connections are discarded.
+	"""
+	p, established, clock = pool(idle_timeout=10)
+	key = ('fault.io', None, None)
+
+	c = p.p_acquire(key, (lambda x: None))
+	p.p_complete(c)
+	c.c_transport.functioning = False
+	n = p.p_acquire(key, (lambda x: None))
+	test/n is not c
+	test/c.c_transport.closed == True
+
+	p.p_complete(n)
+	clock[0] = 11
+	m = p.p_acquire(key, (lambda x: None))
+	test/m is not n
+	test/n.c_transport.closed == True
+
+	# Final responses close the connection.
+	m.c_final = True
+	p.p_complete(m)
+	test/m.c_transport.closed == True
+	test/len(p.p_connections[key]) == 0
+
+def test_Pool_limits(test):
+	"""
+	# Validate the host limit, pipelining, and waiting.
+	"""
+	p, established, clock = pool(host_limit=2, pipeline_depth=2, idle_limit=1)
+	key = ('fault.io', None, None)
+	acquired = []
+
+	a = p.p_acquire(key, acquired.append)
+	b = p.p_acquire(key, acquired.append)
+	test/len(established) == 2
+
+	# Pipelined on the least loaded connection.
+	c = p.p_acquire(key, acquired.append)
+	test/len(established) == 2
+	test/(c is a or c is b) == True
+	test/c.c_pending == 2
+
+	# Not pipelined.
+	test/p.p_acquire(key, acquired.append, pipeline=False) == None
+	test/len(p.p_waiting[key]) == 1
+
+	# Completion hands the connection to the waiting request.
+	p.p_complete(a)
+	test/acquired[-1] is a
+	test/len(p.p_waiting[key]) == 0
+
+	# Idle limit.
+	while a.c_pending:
+		p.p_complete(a)
+	while b.c_pending:
+		p.p_complete(b)
+	test/len(p.p_idle[key]) == 1
+	test/len(p.p_connections[key]) == 1
+
+	p.p_close()
+	test/len(p.p_connections[key]) == 0
+	test/a.c_transport.closed == True
+	test/b.c_transport.closed == True
+
+def test_Pool_reduce(test):
+	p, established, clock = pool(idle_timeout=5)
+	key = ('fault.io', None, None)
+	c = p.p_acquire(key, (lambda x: None))
+	p.p_complete(c)
+
+	clock[0] = 3
+	p.p_reduce()
+	test/c.c_transport.closed == False
+	clock[0] = 6
+	p.p_reduce()
+	test/c.c_transport.closed == True
+	test/len(p.p_idle[key]) == 0
+
+class Invocations(object):
+	def i_allocate(self):
+		n = 0
+		while True:
+			n += 1
+			yield (n, (lambda request, channel: None))
+
+class System(object):
+	def __init__(self):
+		self.deferred = []
+
+	def defer(self, measure, processor):
+		self.deferred.append((measure, processor))
+
+class Navigation(module.Navigation):
+	def __init__(self, clock, **kw):
+		super().__init__(**kw)
+		self.nav_pool.p_clock = (lambda: clock[0])
+		self.established = []
+
+	def nav_establish(self, key):
+		c = module.Connection(key, Transport())
+		c.c_invocations = Invocations()
+		self.nav_transports[c.c_transport] = c
+		self.established.append(c)
+		return c
+
+def session(**kw):
+	clock = [0]
+	nav = Navigation(clock, **kw)
+	nav.system = System()
+	s = module.Session()
+	s.navigation = nav
+	return s, nav, clock
+
+def respond(ctl, final=False):
+	ctl._correlation(ctl._request_channel_id, (b'200', b'OK', []), (lambda channel: None))
+	if final:
+		# Incomplete entity body.
+		ctl.http_complete(True)
+	else:
+		ctl.accept(None)
+
+def test_Session_completion(test):
+	"""
+	# Validate that responses received through a &module.Session return
+	# their connections to the navigation's pool.
+	"""
+	s, nav, clock = session(host_limit=1, pipeline_depth=1, idle_timeout=5)
+	key = ('fault.io', None, None)
+	requests = []
+	for i in range(4):
+		s.s_request(key, (lambda ctl, c: requests.append((ctl, c))))
+
+	# Limits exceeded; waiting on completion.
+	test/len(requests) == 1
+	test/len(nav.established) == 1
+
+	for i in range(3):
+		respond(requests[i][0])
+	test/len(requests) == 4
+	test/len(nav.established) == 1
+	test/len(nav.system.deferred) == 0
+
+	# Repeated completion is ignored.
+	ctl, c = requests[-1]
+	respond(ctl)
+	ctl.http_complete()
+	test/list(nav.nav_pool.p_idle[key]) == [c]
+	test/c.c_pending == 0
+
+	# Idle connection scheduled for reduction.
+	test/len(nav.system.deferred) == 1
+	test/nav.system.deferred[0][1] is nav
+	test/nav.nav_reducing == True
+
+	clock[0] = 6
+	nav.occur()
+	test/c.c_transport.closed == True
+	test/len(nav.nav_pool.p_idle[key]) == 0
+	test/nav.nav_reducing == False
+	test/len(nav.system.deferred) == 1
+
+def test_Session_final(test):
+	"""
+	# Validate that incomplete responses and exited transports
+	# remove the connection from the pool.
+	"""
+	s, nav, clock = session()
+	key = ('fault.io', None, None)
+	requests = []
+	s.s_request(key, (lambda ctl, c: requests.append((ctl, c))))
+	ctl, c = requests[0]
+	respond(ctl, final=True)
+	test/c.c_transport.closed == True
+	test/len(nav.nav_pool.p_idle[key]) == 0
+
+	s.s_request(key, (lambda ctl, c: requests.append((ctl, c))))
+	ctl, c = requests[1]
+	test/(c.c_transport in nav.nav_transports) == True
+	failures = []
+	ctl.http_failed = failures.append
+
+	class Exit(object):
+		xact_context = c.c_transport
+	nav.xact_exit(Exit())
+	test/c.c_transport.closed == True
+	test/(c.c_transport in nav.nav_transports) == False
+	test/len(nav.nav_pool.p_connections[key]) == 0
+
+	# Requests waiting for their responses are faulted.
+	test/len(failures) == 1
+	test/failures[0] is ctl.http_exception
+	test/isinstance(ctl.http_exception, ConnectionError) == True
+	test/c.c_requests == {}
+	test/c.c_pending == 0
+
+def test_Controller_correlation_fault(test):
+	"""
+	# Validate that responses abandoned by HTTP/2 resets fault the request
+	# without preventing the connection from being reused.
+	"""
+	from ...internet import http2
+
+	connected = []
+	completions = []
+	failures = []
+	ctl = module.Controller(None, 1, None)
+	ctl.http_completion = completions.append
+	ctl.http_failed = failures.append
+
+	error = http2.Error(http2.ec_refused_stream, 1, "refused")
+	ctl._correlation(1, error, connected.append)
+	test/connected == [None]
+	test/completions == [False]
+	test/failures == [error]
+	test/ctl.http_exception is error
+
+	ctl = module.Controller(None, 3, None)
+	ctl.http_completion = completions.append
+	ctl._correlation(3, http2.Error(http2.ec_no_error, 0, "goaway"), connected.append)
+	test/completions == [False, True]
+
+def test_Connection_correlate(test):
+	"""
+	# Validate that the persistence of pooled connections is identified
+	# by the version and the connection field of the received responses.
+	"""
+	from ...kernel import flows
+	from ...kernel import core as kcore
+	from ...kernel import io as kio
+	from ..kernel import library as testlib
+
+	def response(version, *fields):
+		rline = version + b' 200 OK\r\n'
+		headers = b''.join(k + b': ' + v + b'\r\n' for k, v in fields)
+		return rline + headers + b'Content-Length: 0\r\n\r\n'
+
+	def receiver():
+		r = flows.Receiver(None)
+		S.dispatch(r)
+		received = flows.Collection.list()
+		r.f_connect(received)
+		S.dispatch(received)
+		return r
+
+	ctx, S = testlib.sector()
+	end = flows.Collection.list()
+	start = flows.Channel()
+
+	tp = kio.Transport.from_endpoint((('test', None), (start, end)))
+	S.dispatch(kcore.Transaction.create(tp))
+	ctx(1)
+
+	c = module.Connection(('fault.io', None, None), tp)
+	c.c_invocations = tp.tp_connect(c.c_correlate, module.http.allocate_client_protocol())
+	ctx(1)
+
+	controllers = [c.c_request(module.Controller) for i in range(3)]
+
+	# HTTP/1.1 without a connection field; persistent.
+	start.f_transfer([response(b'HTTP/1.1')])
+	ctx(1)
+	test/len(c.c_requests) == 2
+	test/c.c_final == False
+	controllers[0].accept(receiver())
+	ctx(1)
+
+	# HTTP/1.0 with keep-alive; persistent.
+	start.f_transfer([response(b'HTTP/1.0', (b'Connection', b'Keep-Alive'))])
+	ctx(1)
+	test/len(c.c_requests) == 1
+	test/c.c_final == False
+	controllers[1].accept(receiver())
+	ctx(1)
+
+	# HTTP/1.1 closed by the server.
+	start.f_transfer([response(b'HTTP/1.1', (b'Connection', b'close'))])
+	ctx(1)
+	test/len(c.c_requests) == 0
+	test/c.c_final == True
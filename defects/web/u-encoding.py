@@ -0,0 +1,154 @@
+"""
+# Validate content coding negotiation, compression, and variant caching.
+"""
+import os
+import zlib
+
+from ...web import encoding as module
+from ...kernel import flows
+from ...system import files
+from ..kernel import library as testlib
+
+def test_parse(test):
+	w = module.parse(b'gzip;q=0.5, deflate , br;q=0, *;q=0.1')
+	test/w == {'gzip': 0.5, 'deflate': 1.0, 'br': 0.0, '*': 0.1}
+	test/module.parse(b'gzip;q=x') == {'gzip': 0.0}
+	test/module.parse(b'') == {}
+
+def test_select(test):
+	available = {'gzip': None, 'deflate': None}
+	test/module.select(None, available) == None
+	test/module.select(b'identity', available) == None
+	test/module.select(b'gzip', available) == 'gzip'
+	test/module.select(b'deflate, gzip', available) == 'gzip'
+	test/module.select(b'gzip;q=0.5, deflate', available) == 'deflate'
+	test/module.select(b'gzip;q=0, *', available) == 'deflate'
+	test/module.select(b'*;q=0', available) == None
+
+def test_compressible_type(test):
+	test/module.compressible_type('text/html') == True
+	test/module.compressible_type('application/json') == True
+	test/module.compressible_type('image/png') == False
+
+def test_Compression(test):
+	"""
+	# Validate that the transfers are compressed as a single stream.
+	"""
+	ctx, S = testlib.sector()
+
+	c = module.Compression('gzip')
+	out = flows.Collection.list()
+	S.dispatch(c)
+	S.dispatch(out)
+	c.f_connect(out)
+
+	data = [bytes([x % 256]) * 512 for x in range(64)]
+	for i in range(0, len(data), 8):
+		c.f_transfer(data[i:i+8])
+	c.f_terminate()
+	ctx(1)
+
+	compressed = b''.join(b''.join(x) for x in out.c_storage)
+	test/len(compressed) < sum(map(len, data))
+	test/zlib.decompress(compressed, 16 + zlib.MAX_WBITS) == b''.join(data)
+
+def test_Compression_flush(test):
+	"""
+	# Validate that flushed transfers can be decoded immediately.
+	"""
+	ctx, S = testlib.sector()
+
+	c = module.Compression('deflate', flush=True)
+	out = flows.Collection.list()
+	S.dispatch(c)
+	S.dispatch(out)
+	c.f_connect(out)
+
+	d = zlib.decompressobj()
+	c.f_transfer([b'first event'])
+	test/d.decompress(b''.join(out.c_storage[-1])) == b'first event'
+	c.f_transfer([b'second event'])
+	test/d.decompress(b''.join(out.c_storage[-1])) == b'second event'
+
+def test_Variants(test):
+	"""
+	# Validate caching, invalidation, and eviction of compressed variants.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'index.html')
+	content = b'<html>' + b'content ' * 512 + b'</html>'
+	with open(path, 'wb') as f:
+		f.write(content)
+
+	v = module.Variants()
+	data = v.get(path, 'gzip')
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == content
+	test/v.get(path, 'gzip') is data
+	test/v.v_size == len(data)
+
+	# Modification invalidates.
+	content = b'changed ' * 256
+	with open(path, 'wb') as f:
+		f.write(content)
+	data = v.get(path, 'gzip')
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == content
+
+	# Eviction of the least recently used.
+	v = module.Variants(limit=len(data) + 1)
+	v.get(path, 'gzip')
+	v.get(path, 'deflate')
+	test/len(v.v_entries) == 1
+	test/v.v_size <= v.v_limit
+
+def test_Variants_prepare(test):
+	"""
+	# Validate that variants prepared by workers are stored when complete.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'index.html')
+	content = b'prepared ' * 512
+	with open(path, 'wb') as f:
+		f.write(content)
+	st = os.stat(path)
+
+	system = testlib.Pool()
+	v = module.Variants()
+	test/v.lookup(path, 'gzip', st) == None
+
+	v.prepare(system, path, 'gzip', st)
+	v.prepare(system, path, 'gzip', st)
+	# Only one compression per variant.
+	test/len(system.tasks) == 1
+	test/v.lookup(path, 'gzip', st) == None
+
+	system()
+	test/v.v_pending == set()
+	data = v.lookup(path, 'gzip', st)
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == content
+
+	# Failures allow the variant to be prepared again.
+	os.unlink(path)
+	v.prepare(system, path, 'deflate', st)
+	system()
+	test/v.v_pending == set()
+	test/v.lookup(path, 'deflate', st) == None
+
+def test_Variants_sibling(test):
+	"""
+	# Validate that precompressed siblings are used when current.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'app.js')
+	with open(path, 'wb') as f:
+		f.write(b'var x = 1;')
+	with open(path + '.gz', 'wb') as f:
+		f.write(b'precompressed')
+
+	v = module.Variants()
+	test/v.get(path, 'gzip') == b'precompressed'
+
+	# Stale sibling is ignored.
+	st = os.stat(path + '.gz')
+	os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 10**9))
+	data = v.get(path, 'gzip')
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == b'var x = 1;'
@@ -58,6 +58,14 @@ def test_ranges(test):
 	# Missing starts means last n-bytes.
 	test/list(library.ranges(100, b"bytes=-50")) == [(50, 100)]
 
+	# Whitespace is permitted around the list elements.
+	test/list(library.ranges(100, b"bytes=0-5, 10-20")) == [(0, 6), (10, 21)]
+	test/list(library.ranges(100, b"bytes=0-5 ,-10,, 10-")) == [(0, 6), (90, 100), (10, 100)]
+
+	# Last positions preceding the first are invalid.
+	test/ValueError ^ (lambda: list(library.ranges(100, b"bytes=5-3")))
+	test/ValueError ^ (lambda: list(library.ranges(100, b"bytes=0-1, 5-3")))
+
 allocate_transparent = (lambda x: (('line+headers',) + x, b'VERSION'))
 
 def test_fork_headers_no_content(test):
@@ -222,6 +230,80 @@ def test_TXProtocol_initiate_request(test):
 	ctx(2)
 	test/end.c_storage[0][0] == (b"GET /test HTTP/1.1" + b"\r\n"*3)
 
+def test_satisfiable(test):
+	test/library.satisfiable([(0, 10)], 100) == [(0, 10)]
+	test/library.satisfiable([(90, 200)], 100) == [(90, 100)]
+	test/library.satisfiable([(100, 200)], 100) == None
+	test/library.satisfiable([(50, 60), (0, 10)], 100) == [(50, 60), (0, 10)]
+
+	# Overlapping ranges are coalesced.
+	test/library.satisfiable([(0, 10), (5, 20), (30, 40)], 100) == [(0, 20), (30, 40)]
+
+	# Excessive ranges are reduced to one.
+	many = [(x, x+1) for x in range(0, 64, 2)]
+	test/library.satisfiable(many, 100, limit=16) == [(0, 63)]
+
+def test_byteranges(test):
+	test/library.content_range(0, 10, 100) == b'bytes 0-9/100'
+
+	parts, close, total = library.byteranges(b'B', b'text/plain', [(0, 1), (5, 7)], 100)
+	test/len(parts) == 2
+	test/parts[1] == b'\r\n--B\r\nContent-Type: text/plain\r\nContent-Range: bytes 5-6/100\r\n\r\n'
+	test/close == b'\r\n--B--\r\n'
+	test/total == len(parts[0]) + len(parts[1]) + len(close) + 3
+
+def test_entity_tags(test):
+	test/library.entity_tags(b'"a", W/"b" ,"c"') == {b'"a"', b'"b"', b'"c"'}
+	test/library.entity_tags(b'*') == {b'*'}
+	test/library.timestamp(b'Sun, 06 Nov 1994 08:49:37 GMT') == 784111777
+	test/library.timestamp(b'invalid') == None
+
+def conditional(*headers, method=b'GET'):
+	return library.Structures(list(headers)).set_request(method, b'/')
+
+def test_precondition(test):
+	etag = b'"1-2"'
+	t = 784111777
+	lm = b'Sun, 06 Nov 1994 08:49:37 GMT'
+	later = b'Sun, 06 Nov 1994 08:49:38 GMT'
+	earlier = b'Sun, 06 Nov 1994 08:49:36 GMT'
+
+	test/library.precondition(conditional(), etag, t) == None
+	test/library.precondition(conditional((b'If-None-Match', etag)), etag, t) == b'304'
+	test/library.precondition(conditional((b'If-None-Match', b'W/' + etag)), etag, t) == b'304'
+	test/library.precondition(conditional((b'If-None-Match', b'"x"')), etag, t) == None
+	test/library.precondition(conditional((b'If-None-Match', b'*'), method=b'PUT'), etag, t) == b'412'
+
+	test/library.precondition(conditional((b'If-Match', etag)), etag, t) == None
+	test/library.precondition(conditional((b'If-Match', b'"x"')), etag, t) == b'412'
+
+	test/library.precondition(conditional((b'If-Modified-Since', lm)), etag, t) == b'304'
+	test/library.precondition(conditional((b'If-Modified-Since', earlier)), etag, t) == None
+	test/library.precondition(conditional((b'If-Unmodified-Since', earlier)), etag, t) == b'412'
+	test/library.precondition(conditional((b'If-Unmodified-Since', later)), etag, t) == None
+
+	# If-None-Match takes precedence over If-Modified-Since.
+	h = conditional((b'If-None-Match', b'"x"'), (b'If-Modified-Since', lm))
+	test/library.precondition(h, etag, t) == None
+
+def test_Structures_range_applies(test):
+	etag = b'"1-2"'
+	t = 784111777
+	lm = b'Sun, 06 Nov 1994 08:49:37 GMT'
+
+	test/conditional().range_applies(etag, t) == False
+	test/conditional((b'Range', b'bytes=0-1')).range_applies(etag, t) == True
+
+	h = conditional((b'Range', b'bytes=0-1'), (b'If-Range', etag))
+	test/h.range_applies(etag, t) == True
+	test/h.range_applies(b'"3-4"', t) == False
+	h = conditional((b'Range', b'bytes=0-1'), (b'If-Range', b'W/' + etag))
+	test/h.range_applies(etag, t) == False
+
+	h = conditional((b'Range', b'bytes=0-1'), (b'If-Range', lm))
+	test/h.range_applies(etag, t) == True
+	test/h.range_applies(etag, t + 1) == False
+
 def test_RXProtocol_allocate_request(test):
 	"""
 	# - &library.RXProtocol
@@ -355,6 +437,294 @@ def test_server_transport(test):
 	ctx(1)
 	test/r.terminated == True
 
+def test_server_transport_pipelined(test):
+	"""
+	# Validate that responses to pipelined requests are emitted as a single buffer.
+	"""
+	l = []
+	add = (lambda x: l.append(x.i_accept()))
+
+	ctx, S = testlib.sector()
+	end = flows.Collection.list()
+	start = flows.Channel()
+
+	t = kio.Transport.from_endpoint([('test', None), (start, end)])
+	S.dispatch(kcore.Transaction.create(t))
+	ctx(1)
+
+	m = t.tp_connect(add, library.allocate_server_protocol_v1())
+	ctx(1)
+
+	start.f_transfer([
+		b"GET /%d HTTP/1.1\r\nConnection: keep-alive\r\n\r\n" % i
+		for i in range(3)
+	])
+	ctx(1)
+
+	outputs = []
+	for accepted in l:
+		for connect_output, (channel_id, parameters, connect_input) in zip(*accepted):
+			connect_input(None)
+			outputs.append(connect_output)
+		ctx(1)
+	test/len(outputs) == 3
+
+	template = library.protocol.Template([(b'Server', b'fault.io')], slots=())
+	for connect_output in outputs:
+		fields = library.protocol.Fields(template, [(b'Content-Length', b'0')])
+		connect_output((b'204', b'NO CONTENT', fields, 0), None)
+	ctx(2)
+
+	test/len(end.c_storage) == 1
+	test/len(end.c_storage[0]) == 1
+	response = b"HTTP/1.1 204 NO CONTENT\r\nServer: fault.io\r\nContent-Length: 0\r\n\r\n"
+	test/end.c_storage[0][0] == response * 3
+
+def test_server_transport_v2(test):
+	"""
+	# - &library.RXProtocolV2
+	# - &library.TXProtocolV2
+	"""
+	from ...internet import http2
+	l = []
+	add = (lambda x: l.extend(x.i_accept()))
+
+	ctx, S = testlib.sector()
+	end = flows.Collection.list()
+	start = flows.Channel()
+
+	t = kio.Transport.from_endpoint([('test', None), (start, end)])
+	S.dispatch(kcore.Transaction.create(t))
+	ctx(1)
+
+	m = t.tp_connect(add, library.allocate_server_protocol())
+	ctx(1)
+
+	c = http2.Connection('client')
+	for path in (b'/first', b'/second'):
+		sid = c.open()
+		c.headers(sid, [
+			(b':method', b'GET'),
+			(b':scheme', b'http'),
+			(b':authority', b'test.fault.io'),
+			(b':path', path),
+		], end=True)
+	start.f_transfer(c.transmit())
+	ctx(2)
+
+	(first, second), requests = l[0], l[1]
+	test/len(requests) == 2
+	test/requests[0][1][:2] == (b'GET', b'/first')
+	headers = library.Structures(requests[0][1][2])
+	test/headers.multiplexed == True
+	test/headers.host == 'test.fault.io'
+
+	def responses():
+		out = b''.join(map(b''.join, end.c_storage))
+		end.c_storage.clear()
+		return [x for x in c.receive(out) if x[0] != http2.ev_goaway]
+
+	# Respond to the second request first.
+	relay = flows.Relay(m.i_catenate, 3)
+	S.dispatch(relay)
+	second((b'200', b'OK', [(b'Content-Length', b'3'), (b'Connection', b'keep-alive')], 3), relay)
+	relay.f_transfer([b'abc'])
+	relay.f_terminate()
+	ctx(2)
+
+	events = responses()
+	test/events[0] == (http2.ev_headers, 3, [(b':status', b'200'), (b'content-length', b'3')], False)
+	test/events[1] == (http2.ev_data, 3, b'abc', True)
+
+	first((b'204', b'NO CONTENT', [], None), None)
+	ctx(2)
+	events = responses()
+	test/events == [(http2.ev_headers, 1, [(b':status', b'204')], True)]
+
+def test_server_transport_v2_connection_error(test):
+	"""
+	# - &library.RXProtocolV2.p_streams
+	# - &library.RXProtocolV2.p_shutdown
+
+	# Validate that a connection error terminates every open stream and the transport.
+	"""
+	from ...internet import http2
+	l = []
+	add = (lambda x: l.extend(x.i_accept()))
+
+	ctx, S = testlib.sector()
+	end = flows.Collection.list()
+	start = flows.Channel()
+
+	t = kio.Transport.from_endpoint([('test', None), (start, end)])
+	S.dispatch(kcore.Transaction.create(t))
+	ctx(1)
+
+	m = t.tp_connect(add, library.allocate_server_protocol())
+	ctx(1)
+
+	c = http2.Connection('client')
+	for path in (b'/first', b'/second', b'/third'):
+		sid = c.open()
+		c.headers(sid, [
+			(b':method', b'POST'),
+			(b':scheme', b'http'),
+			(b':authority', b'test.fault.io'),
+			(b':path', path),
+		])
+	start.f_transfer(c.transmit())
+	ctx(2)
+
+	outputs, requests = l[0], l[1]
+	test/[x[0] for x in requests] == [1, 3, 5]
+
+	receivers = []
+	for channel_id, parameters, connect_input in requests:
+		r = flows.Receiver(None)
+		S.dispatch(r)
+		received = flows.Collection.list()
+		r.f_connect(received)
+		S.dispatch(received)
+		connect_input(r)
+		receivers.append(r)
+	ctx(1)
+
+	# PING is a connection frame; sending it on a stream is a connection error.
+	start.f_transfer([http2.frame(http2.ft_ping, 0, 1, b'\x00' * 8)])
+	ctx(3)
+
+	for r in receivers:
+		test/r.terminated == True
+
+	out = b''.join(map(b''.join, end.c_storage))
+	events = c.receive(out)
+	test/events[-1] == (http2.ev_goaway, 5, http2.ec_protocol_error)
+	test/end.terminated == True
+
+def test_server_transport_v2_goaway(test):
+	"""
+	# - &library.RXProtocolV2.p_streams
+
+	# Validate that a received GOAWAY leaves the remotely initiated streams open.
+	"""
+	from ...internet import http2
+	state = {
+		'version': b'HTTP/2',
+		'disposition': 'server',
+	}
+	allocated = []
+	def allocate(parameter):
+		allocated.append(parameter)
+		return library.RXProtocol.allocate_client_request(parameter)
+
+	sc = http2.Connection('server')
+	po = library.TXProtocolV2(state, library.TXProtocolV2.initiate_client_response, sc)
+	pi = library.RXProtocolV2(state, allocate, sc, po)
+
+	c = http2.Connection('client')
+	for path in (b'/first', b'/second'):
+		sid = c.open()
+		c.headers(sid, [
+			(b':method', b'GET'),
+			(b':scheme', b'http'),
+			(b':authority', b'test.fault.io'),
+			(b':path', path),
+		])
+	events = pi.p_streams(c.transmit())
+	test/[x[:2] for x in events] == [(flows.fe_initiate, 1), (flows.fe_initiate, 3)]
+
+	c.goaway()
+	test/pi.p_streams(c.transmit()) == []
+	test/sorted(pi.p_initiated) == [1, 3]
+
+def test_server_transport_v2_obstructed(test):
+	"""
+	# - &library.RXProtocolV2.f_clear
+
+	# Validate that the window updates of received data are withheld
+	# while the channel is obstructed.
+	"""
+	from ...internet import http2
+	state = {
+		'version': b'HTTP/2',
+		'disposition': 'server',
+	}
+	window = 1 << 15
+	sc = http2.Connection('server', settings={http2.st_initial_window_size: window})
+	po = library.TXProtocolV2(state, library.TXProtocolV2.initiate_client_response, sc)
+	pi = library.RXProtocolV2(state, library.RXProtocol.allocate_client_request, sc, po)
+	emitted = []
+	transmitted = []
+	pi.f_emit = emitted.extend
+	po.f_emit = transmitted.extend
+
+	c = http2.Connection('client')
+	sid = c.open()
+	c.headers(sid, [
+		(b':method', b'POST'),
+		(b':scheme', b'http'),
+		(b':authority', b'test.fault.io'),
+		(b':path', b'/'),
+	])
+	c.data(sid, b'x' * 20000)
+
+	pi.f_obstruct('test')
+	pi.f_transfer(c.transmit())
+	test/[x[0] for x in emitted] == [flows.fe_initiate, flows.fe_transfer, flows.fe_transfer]
+	test/pi.p_withheld == {sid: 20000}
+	test/sc.c_streams[sid].s_receive_window == window - 20000
+
+	del transmitted[:]
+	pi.f_clear('test')
+	test/pi.p_withheld == {}
+	test/sc.c_streams[sid].s_receive_window == window
+	test/len(transmitted) > 0
+
+def test_client_transport_v2_abandoned(test):
+	"""
+	# - &library.RXProtocolV2.p_streams
+
+	# Validate that requests whose streams are reset or refused by GOAWAY
+	# before the response headers are received fault their channels.
+	"""
+	import struct
+	from ...internet import http2
+	state = {
+		'version': b'HTTP/2',
+		'disposition': 'client',
+		'scheme': b'http',
+		'streams': {},
+		'channels': {},
+	}
+	cc = http2.Connection('client')
+	po = library.TXProtocolV2(state, library.TXProtocolV2.initiate_server_request, cc)
+	pi = library.RXProtocolV2(state, library.RXProtocol.allocate_server_response, cc, po)
+
+	request = (b'GET', b'/', [(b'Host', b'test.fault.io')], None)
+	sc = http2.Connection('server')
+	sc.receive(b''.join(po.p_frames([
+		(flows.fe_initiate, channel_id, request)
+		for channel_id in (10, 11, 12)
+	])))
+	test/state['channels'] == {1: 10, 3: 11, 5: 12}
+
+	# REFUSED_STREAM before the response headers.
+	sc.reset(1, http2.ec_refused_stream)
+	events = pi.p_streams(sc.transmit())
+	test/[x[:2] for x in events] == [(flows.fe_initiate, 10), (flows.fe_terminate, 10)]
+	error = events[0][2]
+	test/isinstance(error, http2.Error) == True
+	test/error.code == http2.ec_refused_stream
+	test/error.stream == 1
+	test/state['channels'] == {3: 11, 5: 12}
+
+	# Streams above last_stream were not processed.
+	goaway = http2.frame(http2.ft_goaway, 0, 0, struct.pack('>II', 3, http2.ec_no_error))
+	events = pi.p_streams([goaway])
+	test/[x[:2] for x in events] == [(flows.fe_initiate, 12), (flows.fe_terminate, 12)]
+	test/events[0][2].stream == 0
+	test/state['channels'] == {3: 11}
+
 if __name__ == '__main__':
 	import sys; from ...test import library as libtest
 	libtest.execute(sys.modules[__name__])
@@ -0,0 +1,251 @@
+"""
+# Validate the static file cache used by &.web.system.select_filesystem_resource.
+"""
+import os
+import zlib
+
+from ...web import system as module
+from ...web import http
+from ...system import files
+from ..kernel import library as testlib
+
+def store(path, data):
+	with open(path, 'wb') as f:
+		f.write(data)
+	return files.Path.from_path(path).fs_status()
+
+def test_etag(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'file')
+	st = store(path, b'data').system
+	test/module.etag(st) == b'"4-%x"' % st.st_mtime_ns
+
+def test_Resource(test):
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'index.html')
+	body = b'<html>' + b'x' * 1024 + b'</html>'
+	status = store(path, body)
+
+	r = module.Resource(path, 'text/html', status, body)
+	test/r.r_compressible == True
+	fields, data, tag = r.select(None)
+	test/data is body
+	test/tag == module.etag(status.system)
+	fields = dict(fields)
+	test/fields[b'Content-Length'] == str(len(body)).encode('ascii')
+	test/fields[b'ETag'] == module.etag(status.system)
+	test/fields[b'Content-Type'] == b'text/html'
+
+	fields, data, tag = r.select('gzip')
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == body
+	fields = dict(fields)
+	test/fields[b'Content-Length'] == str(len(data)).encode('ascii')
+	test/fields[b'ETag'] == module.etag(status.system)[:-1] + b'-gzip"'
+	test/fields[b'ETag'] == tag
+	test/r.select('gzip')[1] is data
+	test/r.r_size == len(body) + len(data)
+
+def test_Cache_revalidation(test):
+	"""
+	# Validate that entries are checked against the file's status.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'file.txt')
+	status = store(path, b'first')
+
+	c = module.Cache()
+	test/c.get(('file.txt',)) == None
+	r = c.load(('file.txt',), path, 'text/plain', status)
+	test/c.get(('file.txt',)) is r
+	test/c.c_size == 5
+
+	st = os.stat(path)
+	store(path, b'second version')
+	os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 10**9))
+	test/c.get(('file.txt',)) == None
+	test/c.c_size == 0
+
+	os.unlink(path)
+	test/c.get(('file.txt',)) == None
+
+def test_Cache_status(test):
+	"""
+	# Validate that the given status is used in place of inspecting the file.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'file.txt')
+	status = store(path, b'content')
+
+	c = module.Cache()
+	r = c.load(('file.txt',), path, 'text/plain', status)
+
+	# Status retrieved while resolving the request.
+	os.unlink(path)
+	test/c.get(('file.txt',), status) is r
+
+	changed = store(path, b'changed content')
+	test/c.get(('file.txt',), changed) == None
+	test/c.c_size == 0
+
+def test_Cache_limit(test):
+	"""
+	# Validate that the least recently used entries are evicted.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	c = module.Cache(limit=250)
+
+	for i in range(3):
+		path = str(tmp/str(i))
+		c.load((str(i),), path, 'application/octet-stream', store(path, b'x' * 100))
+		if i == 1:
+			c.get(('0',))
+
+	test/list(c.c_entries) == [('0',), ('2',)]
+	test/c.c_size == 200
+
+	c.clear()
+	test/c.c_size == 0
+	test/len(c.c_entries) == 0
+
+def test_Cache_prepare(test):
+	"""
+	# Validate that files and their variants are read and compressed by workers.
+	"""
+	tmp = test.exits.enter_context(files.Path.fs_tmpdir())
+	path = str(tmp/'index.html')
+	body = b'<html>' + b'x' * 1024 + b'</html>'
+	status = store(path, body)
+
+	system = testlib.Pool()
+	c = module.Cache()
+	c.prepare(system, path, path, 'text/html', status)
+	c.prepare(system, path, path, 'text/html', status)
+	test/len(system.tasks) == 1
+	test/c.get(path, status) == None
+
+	system()
+	test/c.c_pending == set()
+	r = c.get(path, status)
+	test/r.r_variants[None][1] == body
+	test/c.c_size == len(body)
+
+	c.prepare_variant(system, path, r, 'gzip')
+	test/('gzip' in r.r_variants) == False
+	system()
+	fields, data, tag = c.select(path, r, 'gzip')
+	test/zlib.decompress(data, 16 + zlib.MAX_WBITS) == body
+	test/c.c_size == len(body) + len(data)
+
+	# Failed reads are not cached and may be prepared again.
+	os.unlink(path)
+	c.discard(path)
+	c.prepare(system, path, path, 'text/html', status)
+	system()
+	test/c.c_pending == set()
+	test/c.get(path, status) == None
+
+def test_variant_etag(test):
+	test/module.variant_etag(b'"1-2"', None) == b'"1-2"'
+	test/module.variant_etag(b'"1-2"', 'zstd') == b'"1-2-zstd"'
+
+def test_requested_ranges(test):
+	"""
+	# Validate that invalid Range fields are ignored rather than unsatisfiable.
+	"""
+	def request(value):
+		return http.Structures([(b'Range', value)])
+
+	test/module.requested_ranges(request(b"bytes=0-5, 10-20"), 100) == [(0, 6), (10, 21)]
+	test/module.requested_ranges(request(b"bytes=5-3"), 100) == []
+	test/module.requested_ranges(request(b"bytes=x-y"), 100) == []
+	test/module.requested_ranges(request(b"items=0-5"), 100) == []
+	test/module.requested_ranges(request(b"bytes=200-300"), 100) == None
+
+class Controller(object):
+	"""
+	# Response recorder for the send functions.
+	"""
+	def __init__(self):
+		self.headers = []
+		self.response = None
+		self.output = None
+
+	def http_add_header(self, key, value):
+		self.headers.append((key, value))
+
+	def http_set_response(self, code, descr, length, cotype=None):
+		self.response = (code, length, cotype)
+
+	def http_iterate_output(self, iterator):
+		self.output = b''.join(bytes(x[0]) for x in iterator)
+
+	def connect(self, channel):
+		self.output = channel
+
+def test_select_coding(test):
+	"""
+	# Validate that unavailable codings are prepared while the identity is served.
+	"""
+	class Negotiation(Controller):
+		invocations = type('Invocations', (), {'system': 'system'})
+
+		def __init__(self, accept):
+			super().__init__()
+			self.request = http.Structures([(b'Accept-Encoding', accept)])
+
+		def http_select_coding(self, available):
+			self.http_add_header(b'Vary', b'Accept-Encoding')
+			return available[0] if available else None
+
+	prepared = []
+	prepare = (lambda system, coding: prepared.append((system, coding)))
+
+	ctl = Negotiation(b'gzip')
+	test/module.select_coding(ctl, False, {'gzip'}.__contains__, prepare) == 'gzip'
+	test/prepared == []
+
+	test/module.select_coding(ctl, False, set().__contains__, prepare) == None
+	test/prepared == [('system', 'gzip')]
+
+	# Ranged responses address the identity representation.
+	ctl = Negotiation(b'gzip')
+	test/module.select_coding(ctl, True, set().__contains__, prepare) == None
+	test/ctl.headers == [(b'Vary', b'Accept-Encoding')]
+	test/len(prepared) == 1
+
+def test_send_ranges(test):
+	"""
+	# Validate single and multipart range responses.
+	"""
+	errors = []
+	def error(ctl, code, descr):
+		errors.append(code)
+
+	data = bytes(range(100))
+	view = memoryview(data)
+	select = (lambda x, y: (view[x:y],))
+
+	ctl = Controller()
+	module.send_ranges(error, ctl, 'GET', b'text/plain', 100, [(10, 20)], select)
+	test/ctl.response == (b'206', 10, b'text/plain')
+	test/ctl.headers == [(b'Content-Range', b'bytes 10-19/100')]
+	test/ctl.output == data[10:20]
+
+	ctl = Controller()
+	module.send_ranges(error, ctl, 'GET', b'text/plain', 100, [(0, 2), (50, 52)], select)
+	code, length, cotype = ctl.response
+	test/code == b'206'
+	test/cotype == b'multipart/byteranges; boundary=' + module.boundary
+	test/length == len(ctl.output)
+	test/ctl.output.endswith(b'\r\n--' + module.boundary + b'--\r\n')
+	test/ctl.output.find(b'Content-Range: bytes 50-51/100\r\n\r\n' + data[50:52]) > 0
+
+	ctl = Controller()
+	module.send_ranges(error, ctl, 'HEAD', b'text/plain', 100, [(10, 20)], select)
+	test/ctl.output == None
+	test/ctl.response == (b'206', 10, b'text/plain')
+
+	ctl = Controller()
+	module.send_ranges(error, ctl, 'GET', b'text/plain', 100, None, None)
+	test/ctl.headers == [(b'Content-Range', b'bytes */100')]
+	test/errors == [416]
@@ -0,0 +1,1464 @@
+/**
+	// HTTP/1.x message tokenization.
+
+	// &TokenizationType is a state machine reproducing the event stream of
+	// the Python &.http.Tokenization generator. Data is accumulated into a
+	// single buffer that is consumed from the front; delimiters are located
+	// with memchr(3) which is vectorized by the C library.
+*/
+#include <fault/libc.h>
+#include <fault/internal.h>
+#include <fault/python/environ.h>
+
+/* Event identifiers; see &.http */
+#define ev_bypass -2
+#define ev_violation -1
+#define ev_rline 0
+#define ev_headers 1
+#define ev_content 2
+#define ev_chunk 3
+#define ev_trailers 4
+#define ev_message 5
+#define ev_warning 6
+
+/* Size and chunk size states mirroring the generator's use of None. */
+#define TK_NONE (-2)
+#define TK_PENDING (-1)
+
+/* has_body identity states; the generator distinguishes `is True` */
+#define TK_BODY_FALSE 0
+#define TK_BODY_TRUE 1
+#define TK_BODY_IDENTITY 2
+
+#define LIMITS() \
+	L(max_line_size, 4096) \
+	L(max_headers, 1024) \
+	L(max_trailers, 32) \
+	L(max_header_size, 1024*4) \
+	L(max_header_set_size, 1024*8*2) \
+	L(max_trailer_size, 1024) \
+	L(max_chunk_line_size, 1024)
+
+enum tk_state {
+	tks_initial = 0,
+	tks_guard,
+	tks_rline,
+	tks_headers,
+	tks_control,
+	tks_body,
+	tks_chunk_line,
+	tks_transfer,
+	tks_passthrough,
+	tks_chunk_terminator,
+	tks_body_end,
+	tks_trailers,
+	tks_message_end,
+	tks_bypass,
+	tks_content,
+	tks_closed,
+};
+
+struct Tokenization {
+	PyObject_HEAD
+
+	#define L(NAME, DEFAULT) Py_ssize_t tk_##NAME;
+		LIMITS()
+	#undef L
+
+	PyObj tk_allocation;
+	enum tk_state tk_state;
+	char tk_client;
+
+	/* Message state */
+	char tk_body;
+	char tk_keep_alive;
+	char tk_close;
+	char tk_http10; /* Response version; clients only. */
+	int tk_body_ev;
+	long long tk_size;
+	long long tk_chunk_size;
+	Py_ssize_t tk_count;
+	Py_ssize_t tk_messages;
+	PyObj tk_fields; /* headers or trailers being collected */
+	PyObj tk_cl;
+	PyObj tk_te;
+
+	/* Buffered data; consumed from tk_start. */
+	char *tk_data;
+	Py_ssize_t tk_start, tk_end, tk_allocated;
+};
+typedef struct Tokenization *Tokenization;
+
+#define Tokenization_Head(tk) ((tk)->tk_data + (tk)->tk_start)
+#define Tokenization_Length(tk) ((tk)->tk_end - (tk)->tk_start)
+
+static PyTypeObject TokenizationType;
+
+static int
+tk_append(Tokenization tk, const char *data, Py_ssize_t size)
+{
+	Py_ssize_t length = Tokenization_Length(tk);
+
+	if (tk->tk_end + size > tk->tk_allocated)
+	{
+		if (tk->tk_start > 0)
+		{
+			memmove(tk->tk_data, Tokenization_Head(tk), length);
+			tk->tk_start = 0;
+			tk->tk_end = length;
+		}
+
+		if (length + size > tk->tk_allocated)
+		{
+			Py_ssize_t n = tk->tk_allocated ? tk->tk_allocated : 1024;
+			char *nd;
+
+			while (n < length + size)
+				n *= 2;
+
+			nd = PyMem_Realloc(tk->tk_data, n);
+			if (nd == NULL)
+			{
+				PyErr_NoMemory();
+				return(-1);
+			}
+
+			tk->tk_data = nd;
+			tk->tk_allocated = n;
+		}
+	}
+
+	memcpy(tk->tk_data + tk->tk_end, data, size);
+	tk->tk_end += size;
+	return(0);
+}
+
+static void
+tk_consume(Tokenization tk, Py_ssize_t size)
+{
+	tk->tk_start += size;
+	if (tk->tk_start >= tk->tk_end)
+		tk->tk_start = tk->tk_end = 0;
+}
+
+/**
+	// Find CRLF within the first &limit bytes as `bytearray.find` would.
+*/
+static Py_ssize_t
+tk_find_crlf(Tokenization tk, Py_ssize_t limit)
+{
+	const char *head = Tokenization_Head(tk), *cur = head, *last, *p;
+	Py_ssize_t length = Tokenization_Length(tk);
+
+	if (limit > length)
+		limit = length;
+	if (limit < 2)
+		return(-1);
+
+	/* Position of the last possible CR. */
+	last = head + limit - 1;
+	while (cur < last && (p = memchr(cur, '\r', last - cur)) != NULL)
+	{
+		if (p[1] == '\n')
+			return(p - head);
+		cur = p + 1;
+	}
+
+	return(-1);
+}
+
+/**
+	// Find the CRLF CRLF sequence terminating the header block.
+*/
+static Py_ssize_t
+tk_find_eoh(Tokenization tk, Py_ssize_t limit)
+{
+	const char *head = Tokenization_Head(tk), *cur = head, *last, *p;
+	Py_ssize_t length = Tokenization_Length(tk);
+
+	if (limit > length)
+		limit = length;
+	if (limit < 4)
+		return(-1);
+
+	last = head + limit - 3;
+	while (cur < last && (p = memchr(cur, '\r', last - cur)) != NULL)
+	{
+		if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
+			return(p - head);
+		cur = p + 1;
+	}
+
+	return(-1);
+}
+
+static Py_ssize_t
+tk_find(Tokenization tk, char c, Py_ssize_t limit)
+{
+	const char *head = Tokenization_Head(tk), *p;
+
+	p = memchr(head, c, limit);
+	return(p == NULL ? -1 : p - head);
+}
+
+static int
+tk_startswith_crlf(Tokenization tk)
+{
+	return(Tokenization_Length(tk) >= 2 && Tokenization_Head(tk)[0] == '\r' && Tokenization_Head(tk)[1] == '\n');
+}
+
+/**
+	// ASCII whitespace as recognized by `bytes.strip`.
+*/
+static inline int
+tk_space(char c)
+{
+	switch (c)
+	{
+		case ' ': case '\t': case '\n': case '\r': case '\x0b': case '\x0c':
+			return(1);
+	}
+
+	return(0);
+}
+
+static PyObj
+tk_strip(const char *s, Py_ssize_t size)
+{
+	while (size > 0 && tk_space(s[0]))
+	{
+		s += 1;
+		size -= 1;
+	}
+
+	while (size > 0 && tk_space(s[size-1]))
+		size -= 1;
+
+	return(PyBytes_FromStringAndSize(s, size));
+}
+
+static PyObj
+tk_bytearray(Tokenization tk, Py_ssize_t size)
+{
+	return(PyByteArray_FromStringAndSize(Tokenization_Head(tk), size));
+}
+
+/**
+	// Append an event to &events stealing the reference to &value.
+*/
+static int
+tk_emit(PyObj events, int type, PyObj value)
+{
+	PyObj ev;
+	int r;
+
+	if (value == NULL)
+		return(-1);
+
+	ev = Py_BuildValue("(iN)", type, value);
+	if (ev == NULL)
+		return(-1);
+
+	r = PyList_Append(events, ev);
+	Py_DECREF(ev);
+	return(r);
+}
+
+/**
+	// Emit the remaining buffer as a bypass event and enter the bypass state.
+*/
+static int
+tk_bypass(Tokenization tk, PyObj events)
+{
+	if (tk_emit(events, ev_bypass, tk_bytearray(tk, Tokenization_Length(tk))))
+		return(-1);
+
+	tk_consume(tk, Tokenization_Length(tk));
+	tk->tk_state = tks_bypass;
+	return(0);
+}
+
+static int
+tk_violation(Tokenization tk, PyObj events, PyObj context)
+{
+	if (tk_emit(events, ev_violation, context))
+		return(-1);
+
+	return(tk_bypass(tk, events));
+}
+
+/**
+	// Lowercase comparison of a field name against a control header.
+*/
+static int
+tk_field(const char *name, Py_ssize_t size, const char *control)
+{
+	Py_ssize_t i;
+
+	for (i = 0; i < size; ++i)
+	{
+		char c = name[i];
+
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if (c != control[i] || control[i] == 0)
+			return(0);
+	}
+
+	return(control[size] == 0);
+}
+
+/**
+	// Split the comma separated field value into &list, or recognize keep-alive.
+*/
+static int
+tk_control_values(Tokenization tk, PyObj list, const char *value, Py_ssize_t size)
+{
+	const char *end = value + size, *p;
+
+	for (;;)
+	{
+		const char *s = value;
+		Py_ssize_t n;
+
+		p = memchr(value, ',', end - value);
+		if (p == NULL)
+			p = end;
+
+		while (s < p && tk_space(*s))
+			s += 1;
+		n = p - s;
+		while (n > 0 && tk_space(s[n-1]))
+			n -= 1;
+
+		if (list != NULL)
+		{
+			PyObj item = PyBytes_FromStringAndSize(s, n);
+			if (item == NULL)
+				return(-1);
+			if (PyList_Append(list, item))
+			{
+				Py_DECREF(item);
+				return(-1);
+			}
+			Py_DECREF(item);
+		}
+		else if (n == 10 && tk_field(s, n, "keep-alive"))
+			tk->tk_keep_alive = 1;
+		else if (n == 5 && tk_field(s, n, "close"))
+			tk->tk_close = 1;
+
+		if (p == end)
+			break;
+		value = p + 1;
+	}
+
+	return(0);
+}
+
+/**
+	// Whether the connection continues after the current message.
+	// HTTP/1.1 responses persist unless closed; requests and HTTP/1.0
+	// responses require keep-alive.
+*/
+static int
+tk_persistent(Tokenization tk)
+{
+	if (tk->tk_client && !tk->tk_http10)
+		return(!tk->tk_close);
+
+	return(tk->tk_keep_alive);
+}
+
+/**
+	// Construct the (name, value) pair for a header line and
+	// record the control headers when a body is expected.
+
+	// Returns one when the line has no field separator.
+*/
+static int
+tk_header(Tokenization tk, const char *line, Py_ssize_t size, PyObj *out)
+{
+	const char *sep = memchr(line, ':', size);
+	const char *name = line, *value;
+	Py_ssize_t nsize, vsize;
+
+	if (sep == NULL)
+		return(1);
+
+	value = sep + 1;
+	vsize = (line + size) - value;
+
+	*out = Py_BuildValue("(NN)", tk_strip(line, sep - line), tk_strip(value, vsize));
+	if (*out == NULL)
+		return(-1);
+
+	if (tk->tk_body == TK_BODY_FALSE)
+		return(0);
+
+	while (name < sep && tk_space(*name))
+		name += 1;
+	nsize = sep - name;
+	while (nsize > 0 && tk_space(name[nsize-1]))
+		nsize -= 1;
+
+	switch (nsize)
+	{
+		case 10:
+			if (tk_field(name, nsize, "connection"))
+				return(tk_control_values(tk, NULL, value, vsize));
+		break;
+
+		case 14:
+			if (tk_field(name, nsize, "content-length"))
+				return(tk_control_values(tk, tk->tk_cl, value, vsize));
+		break;
+
+		case 17:
+			if (tk_field(name, nsize, "transfer-encoding"))
+				return(tk_control_values(tk, tk->tk_te, value, vsize));
+		break;
+	}
+
+	return(0);
+}
+
+static int
+tk_invalid_header(Tokenization tk, PyObj events, const char *line, Py_ssize_t size)
+{
+	return(tk_violation(tk, events, Py_BuildValue("(sssy#)",
+		"protocol", "invalid-header", "header field has no separator", line, size)));
+}
+
+/**
+	// Parse a non-negative integer; digits only with surrounding whitespace
+	// are handled directly and everything else is given to &int.
+*/
+static int
+tk_integer(const char *s, Py_ssize_t size, int base, long long *out)
+{
+	Py_ssize_t i = 0, n = size;
+	long long v = 0;
+	PyObj bytes, ob;
+
+	while (i < n && tk_space(s[i]))
+		i += 1;
+	while (n > i && tk_space(s[n-1]))
+		n -= 1;
+
+	if (n > i && n - i < 15)
+	{
+		for (; i < n; ++i)
+		{
+			int d;
+			char c = s[i];
+
+			if (c >= '0' && c <= '9')
+				d = c - '0';
+			else if (base == 16 && c >= 'a' && c <= 'f')
+				d = c - 'a' + 10;
+			else if (base == 16 && c >= 'A' && c <= 'F')
+				d = c - 'A' + 10;
+			else
+				goto fallback;
+
+			v = (v * base) + d;
+		}
+
+		*out = v;
+		return(0);
+	}
+
+	fallback:
+	{
+		bytes = PyBytes_FromStringAndSize(s, size);
+		if (bytes == NULL)
+			return(-1);
+
+		ob = PyObject_CallFunction((PyObj) &PyLong_Type, "Oi", bytes, base);
+		Py_DECREF(bytes);
+		if (ob == NULL)
+		{
+			if (!PyErr_ExceptionMatches(PyExc_ValueError))
+				return(-1);
+			PyErr_Clear();
+			return(1);
+		}
+
+		v = PyLong_AsLongLong(ob);
+		Py_DECREF(ob);
+		if (v == -1 && PyErr_Occurred())
+		{
+			PyErr_Clear();
+			return(1);
+		}
+
+		/* Negative sizes are not interpretable. */
+		if (v < 0)
+			return(1);
+
+		*out = v;
+		return(0);
+	}
+}
+
+/**
+	// Begin the next message identified by the allocation.
+*/
+static int
+tk_allocate(Tokenization tk, PyObj events)
+{
+	if (tk->tk_allocation == NULL)
+		tk->tk_body = TK_BODY_IDENTITY;
+	else
+	{
+		PyObj item, seq, hb;
+
+		item = PyIter_Next(tk->tk_allocation);
+		if (item == NULL)
+		{
+			if (PyErr_Occurred())
+				return(-1);
+
+			return(tk_violation(tk, events,
+				Py_BuildValue("(ssn)", "limit", "max_messages", tk->tk_messages)));
+		}
+
+		seq = PySequence_Fast(item, "allocation must produce pairs");
+		Py_DECREF(item);
+		if (seq == NULL)
+			return(-1);
+
+		if (PySequence_Fast_GET_SIZE(seq) != 2)
+		{
+			Py_DECREF(seq);
+			PyErr_SetString(PyExc_ValueError, "allocation must produce pairs");
+			return(-1);
+		}
+
+		hb = PySequence_Fast_GET_ITEM(seq, 1);
+		if (hb == Py_True)
+			tk->tk_body = TK_BODY_IDENTITY;
+		else
+		{
+			int t = PyObject_IsTrue(hb);
+			if (t < 0)
+			{
+				Py_DECREF(seq);
+				return(-1);
+			}
+			tk->tk_body = t ? TK_BODY_TRUE : TK_BODY_FALSE;
+		}
+		Py_DECREF(seq);
+	}
+
+	tk->tk_messages += 1;
+	tk->tk_keep_alive = 0;
+	tk->tk_close = 0;
+	tk->tk_http10 = 0;
+	tk->tk_body_ev = ev_content;
+	tk->tk_size = TK_NONE;
+	tk->tk_chunk_size = TK_NONE;
+
+	Py_XDECREF(tk->tk_cl);
+	Py_XDECREF(tk->tk_te);
+	tk->tk_cl = PyList_New(0);
+	tk->tk_te = PyList_New(0);
+	if (tk->tk_cl == NULL || tk->tk_te == NULL)
+		return(-1);
+
+	tk->tk_state = tks_rline;
+	return(0);
+}
+
+/**
+	// Emit all the headers present in the buffer when the terminator is available.
+*/
+static int
+tk_headers_complete(Tokenization tk, PyObj events, Py_ssize_t eoh)
+{
+	const char *head = Tokenization_Head(tk), *line = head, *end = head + eoh;
+	PyObj headers, header;
+
+	headers = PyList_New(0);
+	if (headers == NULL)
+		return(-1);
+
+	for (;;)
+	{
+		const char *p = memchr(line, '\r', end - line);
+		int r;
+
+		while (p != NULL && !(p + 1 < end && p[1] == '\n'))
+			p = memchr(p + 1, '\r', end - (p + 1));
+		if (p == NULL)
+			p = end;
+
+		r = tk_header(tk, line, p - line, &header);
+		if (r)
+		{
+			if (r > 0)
+			{
+				tk_consume(tk, line - head);
+				r = tk_invalid_header(tk, events, line, p - line);
+			}
+			Py_DECREF(headers);
+			return(r);
+		}
+
+		if (PyList_Append(headers, header))
+		{
+			Py_DECREF(header);
+			Py_DECREF(headers);
+			return(-1);
+		}
+		Py_DECREF(header);
+
+		if (p == end)
+			break;
+		line = p + 2;
+	}
+
+	tk_consume(tk, eoh + 4);
+
+	if (tk_emit(events, ev_headers, headers))
+		return(-1);
+	if (tk_emit(events, ev_headers, PyTuple_New(0)))
+		return(-1);
+
+	tk->tk_state = tks_control;
+	return(0);
+}
+
+static int
+tk_read_rline(Tokenization tk, PyObj events)
+{
+	Py_ssize_t eof, eoh;
+	const char *line, *sp1, *sp2;
+	PyObj rline;
+
+	for (;;)
+	{
+		eof = tk_find_crlf(tk, tk->tk_max_line_size);
+
+		if (eof == -1)
+		{
+			if (Tokenization_Length(tk) > tk->tk_max_line_size)
+			{
+				return(tk_violation(tk, events,
+					Py_BuildValue("(ssn)", "limit", "max_line_size", tk->tk_max_line_size)));
+			}
+
+			/* Need more data to complete the initial line. */
+			return(1);
+		}
+		else if (eof == 0)
+		{
+			/* strip a preceding CRLF */
+			tk_consume(tk, 2);
+		}
+		else
+			break;
+	}
+
+	/* line.split(b" ", 2) */
+	line = Tokenization_Head(tk);
+	sp1 = memchr(line, ' ', eof);
+	sp2 = sp1 == NULL ? NULL : memchr(sp1 + 1, ' ', (line + eof) - (sp1 + 1));
+
+	if (sp1 == NULL)
+		rline = Py_BuildValue("(y#)", line, eof);
+	else if (sp2 == NULL)
+		rline = Py_BuildValue("(y#y#)", line, sp1 - line, sp1 + 1, (line + eof) - (sp1 + 1));
+	else
+		rline = Py_BuildValue("(y#y#y#)", line, sp1 - line,
+			sp1 + 1, sp2 - (sp1 + 1), sp2 + 1, (line + eof) - (sp2 + 1));
+
+	if (tk->tk_client)
+	{
+		Py_ssize_t vsize = sp1 == NULL ? eof : sp1 - line;
+		tk->tk_http10 = (vsize == 8 && memcmp(line, "HTTP/1.0", 8) == 0);
+	}
+
+	if (tk->tk_client && sp1 != NULL)
+	{
+		const char *code = sp1 + 1;
+		Py_ssize_t size = (sp2 == NULL ? line + eof : sp2) - code;
+
+		/* 1xx, 204 No Content, and 304 Not Modified */
+		if ((size > 0 && code[0] == '1') || (size == 3 && (memcmp(code, "204", 3) == 0 || memcmp(code, "304", 3) == 0)))
+			tk->tk_body = TK_BODY_FALSE;
+	}
+
+	tk_consume(tk, eof + 2);
+	if (tk_emit(events, ev_rline, rline))
+		return(-1);
+
+	/* Fast path when full headers are present. */
+	if (!tk_startswith_crlf(tk))
+	{
+		Py_ssize_t limit = tk->tk_max_header_set_size;
+
+		eoh = tk_find_eoh(tk, limit);
+		if (eoh != -1)
+			return(tk_headers_complete(tk, events, eoh));
+	}
+
+	tk->tk_count = 0;
+	Py_XDECREF(tk->tk_fields);
+	tk->tk_fields = PyList_New(0);
+	if (tk->tk_fields == NULL)
+		return(-1);
+
+	tk->tk_state = tks_headers;
+	return(0);
+}
+
+/**
+	// Emit the collected fields, if any, and start a new set.
+*/
+static int
+tk_flush_fields(Tokenization tk, PyObj events, int type)
+{
+	if (PyList_GET_SIZE(tk->tk_fields) == 0)
+		return(0);
+
+	if (tk_emit(events, type, tk->tk_fields))
+	{
+		tk->tk_fields = NULL;
+		return(-1);
+	}
+
+	tk->tk_fields = PyList_New(0);
+	if (tk->tk_fields == NULL)
+		return(-1);
+
+	return(0);
+}
+
+static int
+tk_read_headers(Tokenization tk, PyObj events)
+{
+	Py_ssize_t eof;
+	PyObj header;
+	int r;
+
+	while (!tk_startswith_crlf(tk))
+	{
+		eof = tk_find_crlf(tk, tk->tk_max_header_size);
+
+		if (eof == -1)
+		{
+			/* no terminator, need more data */
+			if (tk_flush_fields(tk, events, ev_headers))
+				return(-1);
+
+			if (Tokenization_Length(tk) > tk->tk_max_header_size)
+			{
+				return(tk_violation(tk, events,
+					Py_BuildValue("(ssn)", "limit", "max_header_size", tk->tk_max_header_size)));
+			}
+
+			return(1);
+		}
+
+		r = tk_header(tk, Tokenization_Head(tk), eof, &header);
+		if (r)
+		{
+			if (r > 0)
+				return(tk_invalid_header(tk, events, Tokenization_Head(tk), eof));
+			return(-1);
+		}
+
+		tk_consume(tk, eof + 2);
+		if (PyList_Append(tk->tk_fields, header))
+		{
+			Py_DECREF(header);
+			return(-1);
+		}
+		Py_DECREF(header);
+
+		tk->tk_count += 1;
+		if (tk->tk_count > tk->tk_max_headers)
+		{
+			if (tk_flush_fields(tk, events, ev_headers))
+				return(-1);
+
+			return(tk_violation(tk, events,
+				Py_BuildValue("(ssnn)", "limit", "max_headers", tk->tk_count, tk->tk_max_headers)));
+		}
+	}
+
+	/* Emit remaining headers and the terminator. */
+	if (tk_flush_fields(tk, events, ev_headers))
+		return(-1);
+	if (tk_emit(events, ev_headers, PyTuple_New(0)))
+		return(-1);
+
+	/* Trim trailing CRLF. */
+	tk_consume(tk, 2);
+	tk->tk_state = tks_control;
+	return(0);
+}
+
+/**
+	// Interpret the control headers and determine the body's framing.
+*/
+static int
+tk_read_control(Tokenization tk, PyObj events)
+{
+	Py_ssize_t ncl = PyList_GET_SIZE(tk->tk_cl);
+	Py_ssize_t nte = PyList_GET_SIZE(tk->tk_te);
+
+	if (ncl > 0)
+	{
+		PyObj cl0 = PyList_GET_ITEM(tk->tk_cl, 0);
+		long long size = 0;
+		int r;
+
+		if (ncl > 1)
+		{
+			if (tk_emit(events, ev_warning, Py_BuildValue("(sssO)",
+				"protocol", "multiple-content-lengths",
+				"multiple length values present", tk->tk_cl)))
+				return(-1);
+		}
+
+		r = tk_integer(PyBytes_AS_STRING(cl0), PyBytes_GET_SIZE(cl0), 10, &size);
+		if (r < 0)
+			return(-1);
+		else if (r > 0)
+		{
+			return(tk_violation(tk, events, Py_BuildValue("(sssO)",
+				"protocol", "invalid-header",
+				"Content-Length could not be interpreted as an integer", cl0)));
+		}
+
+		tk->tk_size = size;
+	}
+
+	if (nte > 0)
+	{
+		PyObj last = PyList_GET_ITEM(tk->tk_te, nte - 1);
+
+		if (PyBytes_GET_SIZE(last) == 7 && memcmp(PyBytes_AS_STRING(last), "chunked", 7) == 0)
+		{
+			/* If C-L was specified, override it here. */
+			tk->tk_chunk_size = TK_PENDING;
+			tk->tk_size = TK_PENDING;
+			tk->tk_body_ev = ev_chunk;
+		}
+		else
+		{
+			PyObj chunked = PyBytes_FromStringAndSize("chunked", 7);
+			int present;
+
+			if (chunked == NULL)
+				return(-1);
+			present = PySequence_Contains(tk->tk_te, chunked);
+			Py_DECREF(chunked);
+
+			if (present < 0)
+				return(-1);
+			if (present)
+			{
+				if (tk_emit(events, ev_warning, Py_BuildValue("(sssO)",
+					"protocol", "misplaced-chunked-coding",
+					"chunked coding was present but not final", tk->tk_te)))
+					return(-1);
+			}
+		}
+	}
+
+	if (tk->tk_body == TK_BODY_IDENTITY && tk->tk_size == TK_NONE)
+	{
+		if (!tk->tk_keep_alive && tk->tk_client)
+		{
+			/* Content is terminated by the connection. */
+			if (tk_emit(events, ev_content, tk_bytearray(tk, Tokenization_Length(tk))))
+				return(-1);
+
+			tk_consume(tk, Tokenization_Length(tk));
+			tk->tk_state = tks_content;
+			return(0);
+		}
+
+		tk->tk_body = TK_BODY_FALSE;
+		tk->tk_size = 0;
+	}
+
+	tk->tk_state = tks_body;
+	return(0);
+}
+
+static int
+tk_read_chunk_line(Tokenization tk, PyObj events)
+{
+	Py_ssize_t eof, extsep;
+	long long size = 0;
+	int r;
+
+	eof = tk_find_crlf(tk, tk->tk_max_chunk_line_size);
+	if (eof == -1)
+	{
+		Py_ssize_t length = Tokenization_Length(tk);
+
+		if (length > tk->tk_max_chunk_line_size)
+		{
+			return(tk_violation(tk, events, Py_BuildValue("(ssnn)",
+				"limit", "max_chunk_line_size", length, tk->tk_max_chunk_line_size)));
+		}
+
+		return(1);
+	}
+
+	/* Chunk extensions are ignored. */
+	extsep = tk_find(tk, ';', eof);
+	if (extsep == -1)
+		extsep = eof;
+
+	r = tk_integer(Tokenization_Head(tk), extsep, 16, &size);
+	if (r < 0)
+		return(-1);
+	else if (r > 0)
+	{
+		PyObj field = tk_bytearray(tk, extsep);
+
+		tk_consume(tk, eof + 2);
+		return(tk_violation(tk, events, Py_BuildValue("(ssN)", "protocol", "chunk-field", field)));
+	}
+
+	tk_consume(tk, eof + 2);
+	tk->tk_chunk_size = size;
+	tk->tk_size = size;
+	tk->tk_state = tks_transfer;
+	return(0);
+}
+
+static int
+tk_transfer_body(Tokenization tk, PyObj events)
+{
+	Py_ssize_t n = Tokenization_Length(tk);
+
+	if (n < tk->tk_size)
+	{
+		/* Buffer size is less than remainder. */
+		tk->tk_size -= n;
+
+		if (tk_emit(events, tk->tk_body_ev, tk_bytearray(tk, n)))
+			return(-1);
+		tk_consume(tk, n);
+
+		tk->tk_state = tks_passthrough;
+		return(1);
+	}
+
+	if (tk->tk_size)
+	{
+		if (tk_emit(events, tk->tk_body_ev, tk_bytearray(tk, tk->tk_size)))
+			return(-1);
+		tk_consume(tk, tk->tk_size);
+		tk->tk_size = 0;
+	}
+
+	if (tk->tk_chunk_size == TK_NONE)
+		tk->tk_state = tks_body;
+	else if (tk->tk_chunk_size == 0)
+		tk->tk_state = tks_body_end;
+	else
+		tk->tk_state = tks_chunk_terminator;
+
+	return(0);
+}
+
+static int
+tk_read_chunk_terminator(Tokenization tk, PyObj events)
+{
+	if (!tk_startswith_crlf(tk))
+	{
+		if (Tokenization_Length(tk) > 2)
+		{
+			return(tk_violation(tk, events, Py_BuildValue("(ssN)",
+				"protocol", "bad-chunk-terminator", tk_bytearray(tk, 2))));
+		}
+
+		return(1);
+	}
+
+	tk_consume(tk, 2);
+	tk->tk_chunk_size = TK_PENDING;
+	tk->tk_size = TK_PENDING;
+	tk->tk_state = tks_body;
+	return(0);
+}
+
+static int
+tk_read_trailers(Tokenization tk, PyObj events)
+{
+	Py_ssize_t eof;
+
+	while ((eof = tk_find_crlf(tk, tk->tk_max_header_size)) != 0)
+	{
+		if (eof == -1)
+		{
+			Py_ssize_t length = Tokenization_Length(tk);
+
+			if (tk_flush_fields(tk, events, ev_trailers))
+				return(-1);
+
+			if (length > tk->tk_max_trailer_size)
+			{
+				return(tk_violation(tk, events,
+					Py_BuildValue("(ssn)", "limit", "max_trailer_size", length)));
+			}
+
+			return(1);
+		}
+		else
+		{
+			const char *line = Tokenization_Head(tk), *sep;
+			PyObj trailer;
+
+			tk->tk_count += 1;
+
+			sep = memchr(line, ':', eof);
+			if (sep == NULL)
+				trailer = Py_BuildValue("(N)", tk_strip(line, eof));
+			else
+				trailer = Py_BuildValue("(NN)",
+					tk_strip(line, sep - line), tk_strip(sep + 1, (line + eof) - (sep + 1)));
+
+			if (trailer == NULL)
+				return(-1);
+			tk_consume(tk, eof + 2);
+
+			if (PyList_Append(tk->tk_fields, trailer))
+			{
+				Py_DECREF(trailer);
+				return(-1);
+			}
+			Py_DECREF(trailer);
+
+			if (eof > tk->tk_max_trailer_size)
+			{
+				if (tk_flush_fields(tk, events, ev_trailers))
+					return(-1);
+
+				return(tk_violation(tk, events,
+					Py_BuildValue("(ssn)", "limit", "max_trailer_size", eof)));
+			}
+
+			if (tk->tk_count > tk->tk_max_trailers)
+			{
+				if (tk_flush_fields(tk, events, ev_trailers))
+					return(-1);
+
+				return(tk_violation(tk, events,
+					Py_BuildValue("(ssn)", "limit", "max_trailers", tk->tk_count)));
+			}
+		}
+	}
+
+	/* remove the trailing CRLF */
+	tk_consume(tk, 2);
+
+	if (tk_flush_fields(tk, events, ev_trailers))
+		return(-1);
+	if (tk_emit(events, ev_trailers, PyTuple_New(0)))
+		return(-1);
+
+	tk->tk_state = tks_message_end;
+	return(0);
+}
+
+/**
+	// Process the buffer until more data is needed.
+*/
+static int
+tk_process(Tokenization tk, PyObj events)
+{
+	int r = 0;
+
+	while (r == 0)
+	{
+		switch (tk->tk_state)
+		{
+			case tks_guard:
+				/* Don't continue to the next message until there is some data. */
+				if (Tokenization_Length(tk) == 0)
+					return(0);
+
+				r = tk_allocate(tk, events);
+			break;
+
+			case tks_rline:
+				r = tk_read_rline(tk, events);
+			break;
+
+			case tks_headers:
+				r = tk_read_headers(tk, events);
+			break;
+
+			case tks_control:
+				r = tk_read_control(tk, events);
+			break;
+
+			case tks_body:
+				if (tk->tk_size == 0 || tk->tk_size == TK_NONE)
+					tk->tk_state = tks_body_end;
+				else if (tk->tk_chunk_size == TK_PENDING)
+					tk->tk_state = tks_chunk_line;
+				else
+					tk->tk_state = tks_transfer;
+			break;
+
+			case tks_chunk_line:
+				r = tk_read_chunk_line(tk, events);
+			break;
+
+			case tks_transfer:
+				r = tk_transfer_body(tk, events);
+			break;
+
+			case tks_chunk_terminator:
+				r = tk_read_chunk_terminator(tk, events);
+			break;
+
+			case tks_body_end:
+				/* Body termination indicator; signals EOF to transformations. */
+				if (tk->tk_body != TK_BODY_FALSE)
+				{
+					if (tk_emit(events, tk->tk_body_ev, PyBytes_FromStringAndSize("", 0)))
+						return(-1);
+				}
+
+				if (tk->tk_chunk_size == 0)
+				{
+					tk->tk_count = 0;
+					Py_XDECREF(tk->tk_fields);
+					tk->tk_fields = PyList_New(0);
+					if (tk->tk_fields == NULL)
+						return(-1);
+
+					tk->tk_state = tks_trailers;
+				}
+				else
+					tk->tk_state = tks_message_end;
+			break;
+
+			case tks_trailers:
+				r = tk_read_trailers(tk, events);
+			break;
+
+			case tks_message_end:
+				tk->tk_size = TK_NONE;
+				if (tk_emit(events, ev_message, (Py_INCREF(Py_None), Py_None)))
+					return(-1);
+
+				if (!tk_persistent(tk))
+				{
+					if (Tokenization_Length(tk) > 0)
+					{
+						if (tk_bypass(tk, events))
+							return(-1);
+					}
+
+					tk->tk_state = tks_bypass;
+				}
+				else
+					tk->tk_state = tks_guard;
+			break;
+
+			case tks_passthrough:
+			case tks_bypass:
+			case tks_content:
+			case tks_closed:
+			case tks_initial:
+				/* Driven by &tk_send */
+				return(0);
+			break;
+		}
+	}
+
+	return(r < 0 ? -1 : 0);
+}
+
+static PyObj
+tk_send(PyObj self, PyObj data)
+{
+	Tokenization tk = (Tokenization) self;
+	PyObj events;
+	Py_buffer pb;
+
+	switch (tk->tk_state)
+	{
+		case tks_initial:
+			if (data != Py_None)
+			{
+				PyErr_SetString(PyExc_TypeError, "can't send non-None value to a just-started tokenization");
+				return(NULL);
+			}
+
+			tk->tk_state = tks_guard;
+			Py_RETURN_NONE;
+		break;
+
+		case tks_closed:
+			PyErr_SetNone(PyExc_StopIteration);
+			return(NULL);
+		break;
+
+		case tks_bypass:
+			return(Py_BuildValue("[(iO)]", ev_bypass, data));
+		break;
+
+		case tks_content:
+			return(Py_BuildValue("[(iO)]", ev_content, data));
+		break;
+
+		case tks_passthrough:
+		{
+			Py_ssize_t n = PyObject_Size(data);
+
+			if (n < 0)
+			{
+				tk->tk_state = tks_closed;
+				return(NULL);
+			}
+
+			if (n < tk->tk_size)
+			{
+				tk->tk_size -= n;
+				return(Py_BuildValue("[(iO)]", tk->tk_body_ev, data));
+			}
+
+			/* Exceeded the remaining size; continue with a buffer. */
+			tk->tk_state = tks_transfer;
+		}
+		break;
+
+		default:
+		break;
+	}
+
+	if (PyObject_GetBuffer(data, &pb, PyBUF_SIMPLE))
+	{
+		tk->tk_state = tks_closed;
+		return(NULL);
+	}
+
+	if (tk_append(tk, pb.buf, pb.len))
+	{
+		PyBuffer_Release(&pb);
+		return(NULL);
+	}
+	PyBuffer_Release(&pb);
+
+	events = PyList_New(0);
+	if (events == NULL)
+		return(NULL);
+
+	if (tk_process(tk, events))
+	{
+		tk->tk_state = tks_closed;
+		Py_DECREF(events);
+		return(NULL);
+	}
+
+	return(events);
+}
+
+static PyObj
+tk_close(PyObj self)
+{
+	Tokenization tk = (Tokenization) self;
+
+	tk->tk_state = tks_closed;
+	tk->tk_start = tk->tk_end = 0;
+	Py_RETURN_NONE;
+}
+
+static PyMethodDef
+tk_methods[] = {
+	{"send", (PyCFunction) tk_send, METH_O,
+		PyDoc_STR("Process the given data and return the produced events.")},
+	{"close", (PyCFunction) tk_close, METH_NOARGS,
+		PyDoc_STR("Discard the buffered data and refuse further sends.")},
+	{NULL,},
+};
+
+static PyObj
+tk_iternext(PyObj self)
+{
+	return(tk_send(self, Py_None));
+}
+
+static int
+tk_traverse(PyObj self, visitproc visit, void *arg)
+{
+	Tokenization tk = (Tokenization) self;
+
+	Py_VISIT(tk->tk_allocation);
+	Py_VISIT(tk->tk_fields);
+	return(0);
+}
+
+static int
+tk_clear(PyObj self)
+{
+	Tokenization tk = (Tokenization) self;
+
+	Py_CLEAR(tk->tk_allocation);
+	Py_CLEAR(tk->tk_fields);
+	Py_CLEAR(tk->tk_cl);
+	Py_CLEAR(tk->tk_te);
+	return(0);
+}
+
+static void
+tk_dealloc(PyObj self)
+{
+	Tokenization tk = (Tokenization) self;
+
+	PyObject_GC_UnTrack(self);
+	tk_clear(self);
+	PyMem_Free(tk->tk_data);
+	Py_TYPE(self)->tp_free(self);
+}
+
+static int
+tk_limit(PyObj constraints, const char *name, Py_ssize_t *out)
+{
+	PyObj ob;
+
+	if (constraints == NULL || constraints == Py_None)
+		return(0);
+
+	ob = PyObject_GetAttrString(constraints, name);
+	if (ob == NULL)
+		return(-1);
+
+	*out = PyLong_AsSsize_t(ob);
+	Py_DECREF(ob);
+	if (*out == -1 && PyErr_Occurred())
+		return(-1);
+
+	return(0);
+}
+
+static PyObj
+tk_new(PyTypeObject *subtype, PyObj args, PyObj kw)
+{
+	static char *kwlist[] = {"disposition", "allocation", "constraints", NULL,};
+	const char *disposition = "server";
+	PyObj allocation = NULL, constraints = NULL;
+	Tokenization tk;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "|sOO", kwlist, &disposition, &allocation, &constraints))
+		return(NULL);
+
+	tk = (Tokenization) subtype->tp_alloc(subtype, 0);
+	if (tk == NULL)
+		return(NULL);
+
+	#define L(NAME, DEFAULT) \
+		tk->tk_##NAME = DEFAULT; \
+		if (tk_limit(constraints, #NAME, &tk->tk_##NAME)) \
+			goto error;
+
+		LIMITS()
+	#undef L
+
+	if (allocation != NULL && allocation != Py_None)
+	{
+		tk->tk_allocation = PyObject_GetIter(allocation);
+		if (tk->tk_allocation == NULL)
+			goto error;
+	}
+
+	tk->tk_client = (strcmp(disposition, "client") == 0);
+	tk->tk_state = tks_initial;
+	tk->tk_size = TK_NONE;
+	tk->tk_chunk_size = TK_NONE;
+
+	return((PyObj) tk);
+
+	error:
+	{
+		Py_DECREF(tk);
+		return(NULL);
+	}
+}
+
+PyDoc_STRVAR(tk_doc,
+	"Tokenization(disposition='server', allocation=None, constraints=None)\n\n"
+	"HTTP/1.x message tokenizer implementing the generator protocol used by "
+	"the Python Tokenization.");
+
+static PyTypeObject
+TokenizationType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	FACTOR_PATH("Tokenization"),   /* tp_name */
+	sizeof(struct Tokenization),   /* tp_basicsize */
+	0,                             /* tp_itemsize */
+	tk_dealloc,                    /* tp_dealloc */
+	0,                             /* (tp_print) */
+	NULL,                          /* tp_getattr */
+	NULL,                          /* tp_setattr */
+	NULL,                          /* tp_compare */
+	NULL,                          /* tp_repr */
+	NULL,                          /* tp_as_number */
+	NULL,                          /* tp_as_sequence */
+	NULL,                          /* tp_as_mapping */
+	NULL,                          /* tp_hash */
+	NULL,                          /* tp_call */
+	NULL,                          /* tp_str */
+	NULL,                          /* tp_getattro */
+	NULL,                          /* tp_setattro */
+	NULL,                          /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT|
+	Py_TPFLAGS_HAVE_GC,            /* tp_flags */
+	tk_doc,                        /* tp_doc */
+	tk_traverse,                   /* tp_traverse */
+	tk_clear,                      /* tp_clear */
+	NULL,                          /* tp_richcompare */
+	0,                             /* tp_weaklistoffset */
+	PyObject_SelfIter,             /* tp_iter */
+	tk_iternext,                   /* tp_iternext */
+	tk_methods,                    /* tp_methods */
+	NULL,                          /* tp_members */
+	NULL,                          /* tp_getset */
+	NULL,                          /* tp_base */
+	NULL,                          /* tp_dict */
+	NULL,                          /* tp_descr_get */
+	NULL,                          /* tp_descr_set */
+	0,                             /* tp_dictoffset */
+	NULL,                          /* tp_init */
+	NULL,                          /* tp_alloc */
+	tk_new,                        /* tp_new */
+};
+
+#define PYTHON_TYPES() \
+	ID(Tokenization)
+
+#define MODULE_FUNCTIONS()
+#include <fault/metrics.h>
+#include <fault/python/module.h>
+INIT(module, 0, PyDoc_STR("HTTP/1.x tokenization."))
+{
+	#define ID(NAME) \
+		if (PyType_Ready((PyTypeObject *) &( NAME##Type ))) \
+			goto error; \
+		Py_INCREF((PyObj) &( NAME##Type )); \
+		if (PyModule_AddObject(module, #NAME, (PyObj) &( NAME##Type )) < 0) \
+			{ Py_DECREF((PyObj) &( NAME##Type )); goto error; }
+		PYTHON_TYPES()
+	#undef ID
+
+	return(0);
+
+	error:
+	{
+		return(-1);
+	}
+}
@@ -0,0 +1,181 @@
+/**
+	// Percent escape decoding for Resource Indicators.
+
+	// ASCII strings are scanned with &memchr and copied in spans between escapes;
+	// other strings are processed a code point at a time. Escapes that are not
+	// followed by two hexadecimal digits raise &ValueError so that the caller
+	// can apply its own interpretation.
+*/
+#include <stdint.h>
+
+#include <fault/libc.h>
+#include <fault/internal.h>
+#include <fault/python/environ.h>
+
+/**
+	// Hexadecimal digit values; negative for non-digits.
+*/
+static signed char hexdigits[256];
+
+static void
+percent_initialize(void)
+{
+	int i;
+
+	memset(hexdigits, -1, sizeof(hexdigits));
+
+	for (i = 0; i < 10; ++i)
+		hexdigits['0' + i] = i;
+
+	for (i = 0; i < 6; ++i)
+	{
+		hexdigits['a' + i] = 10 + i;
+		hexdigits['A' + i] = 10 + i;
+	}
+}
+
+static PyObj
+invalid_escape(Py_ssize_t offset)
+{
+	PyErr_Format(PyExc_ValueError, "invalid percent escape at offset %zd", offset);
+	return(NULL);
+}
+
+/**
+	// Decode the escapes of an ASCII string.
+*/
+static PyObj
+decode_ascii(PyObj arg, const char *data, Py_ssize_t len)
+{
+	const char *start = data, *end = data + len;
+	const char *p = memchr(data, '%', len);
+	char *buf, *out;
+	PyObj rob;
+
+	if (p == NULL)
+	{
+		Py_INCREF(arg);
+		return(arg);
+	}
+
+	buf = PyMem_Malloc(len);
+	if (buf == NULL)
+		return(PyErr_NoMemory());
+	out = buf;
+
+	while (p != NULL)
+	{
+		int h, l;
+
+		memcpy(out, data, p - data);
+		out += p - data;
+
+		if (end - p < 3)
+		{
+			PyMem_Free(buf);
+			return(invalid_escape(p - start));
+		}
+
+		h = hexdigits[(unsigned char) p[1]];
+		l = hexdigits[(unsigned char) p[2]];
+		if (h < 0 || l < 0)
+		{
+			PyMem_Free(buf);
+			return(invalid_escape(p - start));
+		}
+
+		*out++ = (char) ((h << 4) | l);
+		data = p + 3;
+		p = memchr(data, '%', end - data);
+	}
+
+	memcpy(out, data, end - data);
+	out += end - data;
+
+	/* Escapes identify code points, not UTF-8 sequences. */
+	rob = PyUnicode_DecodeLatin1(buf, out - buf, NULL);
+	PyMem_Free(buf);
+
+	return(rob);
+}
+
+/**
+	// Decode the escapes of a string containing non-ASCII code points.
+*/
+static PyObj
+decode_ucs(PyObj arg, int kind, const void *data, Py_ssize_t len)
+{
+	Py_UCS4 *buf, c;
+	Py_ssize_t i, n = 0;
+	PyObj rob;
+
+	buf = PyMem_New(Py_UCS4, len);
+	if (buf == NULL)
+		return(PyErr_NoMemory());
+
+	for (i = 0; i < len; ++i)
+	{
+		c = PyUnicode_READ(kind, data, i);
+
+		if (c == '%')
+		{
+			Py_UCS4 hc, lc;
+
+			if (len - i < 3)
+				goto invalid;
+
+			hc = PyUnicode_READ(kind, data, i + 1);
+			lc = PyUnicode_READ(kind, data, i + 2);
+			if (hc > 0xFF || lc > 0xFF || hexdigits[hc] < 0 || hexdigits[lc] < 0)
+				goto invalid;
+
+			c = (hexdigits[hc] << 4) | hexdigits[lc];
+			i += 2;
+		}
+
+		buf[n++] = c;
+	}
+
+	rob = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, buf, n);
+	PyMem_Free(buf);
+	return(rob);
+
+	invalid:
+	{
+		PyMem_Free(buf);
+		return(invalid_escape(i));
+	}
+}
+
+static PyObj
+percent_decode(PyObj mod, PyObj arg)
+{
+	Py_ssize_t len;
+
+	if (!PyUnicode_Check(arg))
+	{
+		PyErr_SetString(PyExc_TypeError, "percent escapes can only be decoded from str instances");
+		return(NULL);
+	}
+
+	len = PyUnicode_GET_LENGTH(arg);
+	if (PyUnicode_IS_ASCII(arg))
+		return(decode_ascii(arg, (const char *) PyUnicode_DATA(arg), len));
+
+	return(decode_ucs(arg, PyUnicode_KIND(arg), PyUnicode_DATA(arg), len));
+}
+
+#define PYTHON_TYPES()
+#define MODULE_FUNCTIONS() \
+	PYMETHOD( \
+		decode, percent_decode, METH_O, \
+			"Substitute percent escapes with the code points that they identify; " \
+			"&ValueError is raised when an escape is not followed by two hexadecimal digits.")
+
+#include <fault/metrics.h>
+#include <fault/python/module.h>
+INIT(module, 0, PyDoc_STR("Percent escape decoding for Resource Indicators."))
+{
+	percent_initialize();
+	return(0);
+}
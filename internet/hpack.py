@@ -3,9 +3,12 @@
 
 # Provides state machines for managing the dynamic tables needed for connections.
 # http://tools.ietf.org/html/rfc7541
+
+# Huffman coding is performed by &huffman_encode and &huffman_decode; when the
+# native extension is available, &hencode and &hdecode refer to its implementations
+# and are used by &Encoder and &Decoder.
 """
-import itertools
-import functools
+import collections
 
 static_table = [
 	None,
@@ -334,52 +337,120 @@ huffman_code = [
 	'11111111' '11111111' '11111111' '111111', # EOS
 ]
 
-huffman_reverse_index = {
-	huffman_code[i]: i for i in range(len(huffman_code))
-}
+class CompressionError(ValueError):
+	"""
+	# Header block or field could not be decoded.
+	# Connections receiving this error must be terminated with a `COMPRESSION_ERROR`.
+	"""
+
+huffman_lengths = bytes(map(len, huffman_code))
+huffman_integers = [int(x, 2) for x in huffman_code]
+
+def _huffman_tree(codes):
+	"""
+	# Construct the decoding tree; internal nodes are lists of two children
+	# and leaves are symbol integers.
+	"""
+	root = [None, None]
+	for symbol, code in enumerate(codes):
+		node = root
+		for bit in code[:-1]:
+			b = int(bit)
+			if node[b] is None:
+				node[b] = [None, None]
+			node = node[b]
+		node[int(code[-1])] = symbol
+	return root
+
+def _huffman_states(codes, eos=256):
+	"""
+	# Construct the nibble transition table used by &huffman_decode.
+
+	# Each internal node of the tree is a state. Entries are indexed by
+	# `(state << 4) | nibble` and hold `(next_state, symbol)` where symbol is
+	# `-1` when no symbol was completed and `-2` when the sequence is invalid.
+	# The returned accept set contains the states that may end a field:
+	# those reached by less than eight padding bits.
+	"""
+	root = _huffman_tree(codes)
+	nodes = [root]
+	ids = {id(root): 0}
+	accept = {0}
+
+	# Number the internal nodes; accepting states are reached by all-ones prefixes.
+	i = 0
+	while i < len(nodes):
+		for child in nodes[i]:
+			if isinstance(child, list) and id(child) not in ids:
+				ids[id(child)] = len(nodes)
+				nodes.append(child)
+		i += 1
+
+	node = root
+	for depth in range(7):
+		node = node[1]
+		accept.add(ids[id(node)])
 
-h_start = min(map(len, huffman_code))
-h_stop = max(map(len, huffman_code)) + 1
+	table = []
+	for node in nodes:
+		for nibble in range(16):
+			current = node
+			symbol = -1
+			for shift in (3, 2, 1, 0):
+				current = current[(nibble >> shift) & 1]
+				if not isinstance(current, list):
+					if current == eos:
+						symbol = -2
+						current = root
+						break
+					symbol = current
+					current = root
+			table.append((ids[id(current)], symbol))
+
+	return table, frozenset(accept)
+
+huffman_states, huffman_accept = _huffman_states(huffman_code)
 
 def huffman_decode(field:bytes,
-		h_range=(h_start, h_stop),
-		index=huffman_reverse_index,
+		table=huffman_states,
+		accept=huffman_accept,
 		bytes=bytes,
-		range=range,
 	):
 	"""
 	# Decode the byte string using the HPACK huffman code table.
 
+	# Decoding is driven by a state transition table consuming four bits
+	# at a time; at most one symbol can be completed per transition.
+
 	# [ Invariants ]
 	# - `encode(decode(x)) == x`
 	"""
-	get = index.get
-	bits = ''.join(bin(x)[2:].rjust(8, '0') for x in field)
-
 	chars = []
-	char = None
-
-	while bits:
-		for i in range(*h_range):
-			maybe = bits[0:i]
-			char = index.get(maybe)
-			if char is not None:
-				chars.append(char)
-				bits = bits[i:]
-				break # Next bit string.
-		else:
-			# Error; no such character. Bad input.
-			if bits == (len(bits) * '1'):
-				# EOS
-				break
-			raise ValueError("field contains invalid bit sequence")
+	add = chars.append
+	state = 0
+
+	for x in field:
+		state, symbol = table[(state << 4) | (x >> 4)]
+		if symbol != -1:
+			if symbol == -2:
+				raise CompressionError("field contains EOS symbol")
+			add(symbol)
+
+		state, symbol = table[(state << 4) | (x & 0x0F)]
+		if symbol != -1:
+			if symbol == -2:
+				raise CompressionError("field contains EOS symbol")
+			add(symbol)
+
+	if state not in accept:
+		raise CompressionError("field contains invalid bit sequence")
 
 	return bytes(chars)
 
 def huffman_encode(field:bytes,
-		table=huffman_code,
-		chain=itertools.chain.from_iterable,
-		len=len, int=int
+		codes=huffman_integers,
+		lengths=huffman_lengths,
+		bytearray=bytearray, bytes=bytes,
 	):
 	"""
 	# Encode the byte string as using the HPACK huffman code table.
@@ -387,26 +458,407 @@ def huffman_encode(field:bytes,
 	# [ Invariants ]
 	# - `decode(encode(x)) == x`
 	"""
-	seq = ''.join([table[x] for x in field])
-	byte_fields = [seq[y:y+8] for y in range(0, len(seq), 8)]
+	out = bytearray()
+	add = out.append
+	acc = 0
+	n = 0
+
+	for x in field:
+		acc = (acc << lengths[x]) | codes[x]
+		n += lengths[x]
+
+		while n >= 8:
+			n -= 8
+			add((acc >> n) & 0xFF)
+		acc &= (1 << n) - 1
+
+	if n:
+		# Pad with the most significant bits of EOS.
+		pad = 8 - n
+		add((acc << pad) | ((1 << pad) - 1))
+
+	return bytes(out)
+
+def huffman_length(field:bytes, lengths=huffman_lengths, sum=sum) -> int:
+	"""
+	# The number of bytes &huffman_encode would produce for &field.
+	"""
+	return (sum(lengths[x] for x in field) + 7) >> 3
+
+try:
+	from . import huffman as _native
+except ImportError:
+	hencode = huffman_encode
+	hdecode = huffman_decode
+	hlength = huffman_length
+else:
+	hencode = _native.encode
+	hdecode = _native.decode
+	hlength = _native.length
+
+def integer_encode(value:int, prefix:int, flags:int=0) -> bytes:
+	"""
+	# Encode the integer using an &prefix bit prefix with the leading bits set to &flags.
+	"""
+	limit = (1 << prefix) - 1
+	if value < limit:
+		return bytes((flags | value,))
+
+	out = bytearray((flags | limit,))
+	value -= limit
+	while value >= 128:
+		out.append((value & 0x7F) | 0x80)
+		value >>= 7
+	out.append(value)
+
+	return bytes(out)
+
+def integer_decode(data, offset:int, prefix:int, limit=1 << 32):
+	"""
+	# Decode the prefixed integer at &offset in &data.
+
+	# [ Returns ]
+	# The integer and the offset following it.
+	"""
+	mask = (1 << prefix) - 1
+	value = data[offset] & mask
+	offset += 1
+	if value < mask:
+		return value, offset
+
+	shift = 0
+	try:
+		while True:
+			b = data[offset]
+			offset += 1
+			value += (b & 0x7F) << shift
+			shift += 7
+
+			if value > limit:
+				raise CompressionError("integer exceeds limit")
+			if not b & 0x80:
+				return value, offset
+	except IndexError:
+		raise CompressionError("truncated integer") from None
+
+def string_encode(field:bytes, huffman:bool=True) -> bytes:
+	"""
+	# Encode a string literal; Huffman coding is used when &huffman is
+	# true and it does not increase the size of the field.
+	"""
+	if huffman and field:
+		size = hlength(field)
+		if size <= len(field):
+			return integer_encode(size, 7, 0x80) + hencode(field)
+
+	return integer_encode(len(field), 7) + field
+
+def string_decode(data, offset:int):
+	"""
+	# Decode the string literal at &offset in &data.
+
+	# [ Returns ]
+	# The string and the offset following it.
+	"""
+	huffman = data[offset] & 0x80
+	size, offset = integer_decode(data, offset, 7)
+
+	end = offset + size
+	if end > len(data):
+		raise CompressionError("truncated string literal")
+
+	field = bytes(data[offset:end])
+	if huffman:
+		try:
+			field = hdecode(field)
+		except ValueError as err:
+			raise CompressionError(str(err)) from None
+
+	return field, end
+
+static_entries = [None] + [
+	(x.encode('ascii'), b'') if isinstance(x, str) else (x[0].encode('ascii'), x[1].encode('ascii'))
+	for x in static_table[1:]
+]
+static_fields = {}
+static_names = {}
+for i, x in reversed(list(enumerate(static_entries))[1:]):
+	static_fields[x] = i
+	static_names[x[0]] = i
+del i, x
+static_size = len(static_entries)
+
+class Table(object):
+	"""
+	# The dynamic table of an HPACK context.
+
+	# Entries are identified by their insertion number so that lookups
+	# do not need to be updated when the table's indexes shift.
+
+	# [ Properties ]
+	# /max_size/
+		# The size limit of the table in octets.
+	# /size/
+		# The current size of the entries using the RFC 7541 accounting.
+	"""
+	overhead = 32
+
+	def __init__(self, max_size:int=4096):
+		self.max_size = max_size
+		self.size = 0
+		self.entries = collections.deque()
+		self.inserted = 0
+		self.fields = {}
+		self.names = {}
+
+	def __len__(self):
+		return len(self.entries)
+
+	def _evict(self, limit):
+		entries = self.entries
+		while self.size > limit and entries:
+			entry = entries.pop()
+			number = self.inserted - len(entries) - 1
+			self.size -= len(entry[0]) + len(entry[1]) + self.overhead
+
+			if self.fields.get(entry) == number:
+				del self.fields[entry]
+			if self.names.get(entry[0]) == number:
+				del self.names[entry[0]]
+
+	def resize(self, max_size:int):
+		"""
+		# Change the size limit evicting entries as necessary.
+		"""
+		self.max_size = max_size
+		self._evict(max_size)
+
+	def insert(self, name:bytes, value:bytes):
+		"""
+		# Add an entry to the table evicting older entries to make space.
+		# Entries larger than the table empty it and are not added.
+		"""
+		size = len(name) + len(value) + self.overhead
+		self._evict(self.max_size - size)
+		if size > self.max_size:
+			return
+
+		entry = (name, value)
+		number = self.inserted
+		self.inserted += 1
+		self.entries.appendleft(entry)
+		self.size += size
+		self.fields[entry] = number
+		self.names[name] = number
+
+	def get(self, index:int):
+		"""
+		# Retrieve the (name, value) pair of the static or dynamic table &index.
+		"""
+		if 0 < index < static_size:
+			return static_entries[index]
+
+		try:
+			return self.entries[index - static_size]
+		except IndexError:
+			raise CompressionError("index %d is not in the table" %(index,)) from None
+
+	def _index(self, number):
+		return static_size + (self.inserted - number - 1)
+
+	def search(self, name:bytes, value:bytes):
+		"""
+		# Identify the index of the (name, value) pair or the index of an entry with &name.
+
+		# [ Returns ]
+		# A pair, `(index, exact)`; index is zero when the name is not present.
+		"""
+		entry = (name, value)
+
+		i = static_fields.get(entry)
+		if i is not None:
+			return i, True
+
+		number = self.fields.get(entry)
+		if number is not None:
+			return self._index(number), True
+
+		i = static_names.get(name)
+		if i is not None:
+			return i, False
+
+		number = self.names.get(name)
+		if number is not None:
+			return self._index(number), False
+
+		return 0, False
+
+class Encoder(object):
+	"""
+	# Header block serialization for a connection's sending side.
+
+	# [ Properties ]
+	# /table/
+		# The dynamic &Table shared with the remote decoder.
+	# /huffman/
+		# Whether string literals are Huffman coded when it reduces their size.
+	# /never_indexed/
+		# Field names that are sent as never-indexed literals.
+	"""
+
+	def __init__(self, max_size:int=4096, huffman:bool=True,
+			never_indexed=frozenset((b'authorization', b'proxy-authorization', b'set-cookie')),
+		):
+		self.table = Table(max_size)
+		self.huffman = huffman
+		self.never_indexed = never_indexed
+		self._updates = []
+
+	def resize(self, max_size:int):
+		"""
+		# Change the table size; the update is signalled in the next header block.
+		# Used when the peer's `SETTINGS_HEADER_TABLE_SIZE` changes.
+		"""
+		self._updates.append(max_size)
+		self.table.resize(max_size)
+
+	def encode(self, headers) -> bytes:
+		"""
+		# Serialize the sequence of (name, value) pairs into a header block.
+		"""
+		out = bytearray()
+		table = self.table
+		huffman = self.huffman
+
+		if self._updates:
+			# Signal the smallest size followed by the final size.
+			least = min(self._updates)
+			if least != self._updates[-1]:
+				out += integer_encode(least, 5, 0x20)
+			out += integer_encode(self._updates[-1], 5, 0x20)
+			self._updates = []
 
-	last = byte_fields[-1]
-	llen = 8 - len(last)
-	if llen:
-		byte_fields[-1] = (last + ('1' * llen))
+		for name, value in headers:
+			index, exact = table.search(name, value)
 
-	return bytes((int(x, 2) for x in byte_fields))
+			if exact:
+				out += integer_encode(index, 7, 0x80)
+				continue
 
-def encoder(hencode=huffman_encode):
+			if name in self.never_indexed:
+				out += integer_encode(index, 4, 0x10)
+			elif len(name) + len(value) + Table.overhead > table.max_size:
+				out += integer_encode(index, 4, 0x00)
+			else:
+				out += integer_encode(index, 6, 0x40)
+				table.insert(name, value)
+
+			if not index:
+				out += string_encode(name, huffman)
+			out += string_encode(value, huffman)
+
+		return bytes(out)
+
+class Decoder(object):
+	"""
+	# Header block interpretation for a connection's receiving side.
+
+	# [ Properties ]
+	# /table/
+		# The dynamic &Table maintained by the remote encoder.
+	# /limit/
+		# The maximum table size permitted by local settings.
+	"""
+
+	def __init__(self, max_size:int=4096):
+		self.table = Table(max_size)
+		self.limit = max_size
+
+	def resize(self, max_size:int):
+		"""
+		# Change the permitted table size; used when the local
+		# `SETTINGS_HEADER_TABLE_SIZE` is acknowledged.
+		"""
+		self.limit = max_size
+		if self.table.max_size > max_size:
+			self.table.resize(max_size)
+
+	def decode(self, block) -> list:
+		"""
+		# Interpret the header block producing a list of (name, value) pairs.
+		"""
+		table = self.table
+		headers = []
+		add = headers.append
+		offset = 0
+		end = len(block)
+		updates = True
+
+		try:
+			while offset < end:
+				b = block[offset]
+
+				if b & 0x80:
+					# Indexed Header Field
+					index, offset = integer_decode(block, offset, 7)
+					if index == 0:
+						raise CompressionError("zero index")
+					add(table.get(index))
+				elif b & 0xE0 == 0x20:
+					# Dynamic Table Size Update
+					if not updates:
+						raise CompressionError("table size update after header field")
+					size, offset = integer_decode(block, offset, 5)
+					if size > self.limit:
+						raise CompressionError("table size update exceeds limit")
+					table.resize(size)
+					continue
+				else:
+					if b & 0xC0 == 0x40:
+						prefix = 6
+						indexing = True
+					else:
+						# Without indexing or never indexed.
+						prefix = 4
+						indexing = False
+
+					index, offset = integer_decode(block, offset, prefix)
+					if index:
+						name = table.get(index)[0]
+					else:
+						name, offset = string_decode(block, offset)
+					value, offset = string_decode(block, offset)
+
+					if indexing:
+						table.insert(name, value)
+					add((name, value))
+
+				updates = False
+		except IndexError:
+			raise CompressionError("truncated header block") from None
+
+		return headers
+
+def encoder(max_size=4096):
 	"""
 	# Encoding state for serializing headers.
+	# Send sequences of (name, value) pairs to receive header blocks.
 	"""
-	dindex = {}
-	yield None
+	state = Encoder(max_size)
+	encode = state.encode
+
+	headers = (yield None)
+	while True:
+		headers = (yield encode(headers))
 
-def decoder(hdecode=huffman_decode):
+def decoder(max_size=4096):
 	"""
 	# Decoding state for loading headers.
+	# Send header blocks to receive lists of (name, value) pairs.
 	"""
-	dindex = {}
-	yield None
+	state = Decoder(max_size)
+	decode = state.decode
+
+	block = (yield None)
+	while True:
+		block = (yield decode(block))
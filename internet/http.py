@@ -43,9 +43,11 @@
 # /(id)`WARNING`/
 	# (&ev_warning, (type, identifier, message, context))
 """
+import time
 import typing
 import itertools
 import functools
+from email.utils import formatdate
 from dataclasses import dataclass
 from .data import http as protocoldata
 
@@ -108,6 +110,17 @@ class Limits(object):
 	max_trailer_size: int = 1024
 	max_chunk_line_size: int = 1024
 
+def decode_size(field, base:int=10, limit:int=(1 << 63) - 1) -> int:
+	"""
+	# Interpret a (http/header)`Content-Length` or chunk size field.
+	# Raises &ValueError when the size is negative or exceeds the range
+	# of the native tokenizer's sizes.
+	"""
+	size = int(field, base)
+	if size < 0 or size > limit:
+		raise ValueError("size is not within the supported range")
+	return size
+
 def Tokenization(
 		disposition:str='server',
 		allocation:typing.Iterable[typing.Tuple[int,bool]]=None,
@@ -121,6 +134,7 @@ def Tokenization(
 		bastrip = bytearray.strip,
 		map = map, range = range,
 		max = max,
+		decode_size = decode_size,
 
 		CRLF = protocoldata.CRLF, SP = protocoldata.SP,
 		PROTOCOLS = protocoldata.VERSIONS,
@@ -247,13 +261,36 @@ def Tokenization(
 		# Emit headers.
 		chunk_size = None
 
-		eoh = find(b"\r\n\r\n", 0, max_header_set_size)
+		if startswith(b"\r\n"):
+			# Empty header block; searching for the terminator would
+			# find the end of a pipelined message's headers.
+			eoh = -1
+		else:
+			eoh = find(b"\r\n\r\n", 0, max_header_set_size)
+
 		if eoh != -1:
 			# Fast path when full headers are present.
 			header = None
 			headers = bytes(req[:eoh]).split(b"\r\n")
 			nheaders = len(headers)
 
+			for i in range(nheaders):
+				if b':' not in headers[i]:
+					# No field separator; the preceding fields are discarded.
+					del req[:sum(len(x) + 2 for x in headers[:i])]
+					addev((
+						violation_ev,
+						('protocol', 'invalid-header', "header field has no separator", headers[i])
+					))
+					addev((bypass_ev, req))
+
+					del find, buflen, startswith
+					del headers, header
+					req = (yield events)
+					del events, addev
+					while True:
+						req = (yield [(bypass_ev, req)])
+
 			if has_body:
 				for i in range(nheaders):
 					h, v = headers[i].split(b":", 1)
@@ -316,6 +353,21 @@ def Tokenization(
 
 					# Spell out header tuple constructor for performance.
 					eoi = find(b':', 0, eof) # Use find rather than split to avoid list().
+					if eoi == -1:
+						# No field separator; the unflushed fields are discarded.
+						addev((
+							violation_ev,
+							('protocol', 'invalid-header', "header field has no separator", bytes(req[:eof]))
+						))
+						addev((bypass_ev, req))
+
+						del find, buflen, startswith
+						del headers, add_header
+						req = (yield events)
+						del events, addev
+						while True:
+							req = (yield [(bypass_ev, req)])
+
 					header = (bstrip(bytes(req[:eoi])), bstrip(bytes(req[eoi+1:eof])))
 					del req[:eof+2]
 
@@ -357,7 +409,14 @@ def Tokenization(
 			del req[:2]
 		# : if eoh == -1
 
-		keep_alive = b'keep-alive' in cn
+		options = {x.lower() for x in cn}
+		keep_alive = b'keep-alive' in options
+		if is_client and line[0] != b'HTTP/1.0':
+			# HTTP/1.1 responses persist unless closed.
+			# Servers continue to close requests without keep-alive; see web.http.Structures.final.
+			persistent = b'close' not in options
+		else:
+			persistent = keep_alive
 
 		if cl:
 			if len(cl) > 1:
@@ -368,7 +427,7 @@ def Tokenization(
 				))
 
 			try:
-				ctl_headers[b'content-length'] = size = int(cl[0])
+				ctl_headers[b'content-length'] = size = decode_size(cl[0])
 			except ValueError:
 				addev((
 					violation_ev,
@@ -457,7 +516,7 @@ def Tokenization(
 					del req[0:eof+2]
 
 					try:
-						chunk_size = int(chunk_field, 16)
+						chunk_size = decode_size(chunk_field, 16)
 					except ValueError:
 						addev((violation_ev, ('protocol', 'chunk-field', chunk_field)))
 						addev((bypass_ev, req))
@@ -643,7 +702,7 @@ def Tokenization(
 		# finish up by resetting size and emitting EOM on continuation
 		size = None
 		addev(EOM)
-		if keep_alive is not True:
+		if not persistent:
 			if req:
 				addev((bypass_ev, req))
 			del find, buflen, startswith, req
@@ -669,7 +728,12 @@ def Tokenization(
 			req = (yield events)
 			events = []
 			addev = events.append
-Disassembler = Tokenization
+
+try:
+	# Native implementation producing the same event stream.
+	from .http1 import Tokenization as Disassembler
+except ImportError:
+	Disassembler = Tokenization
 
 def disassembly(**config):
 	"""
@@ -709,6 +773,69 @@ def chunk(data, len=len, CRLF=protocoldata.CRLF):
 	"""
 	return (chunk_size(len(data)), data, CRLF)
 
+_date_cache = [None, b'']
+
+def date(time=time.time, format=formatdate, cache=_date_cache) -> bytes:
+	"""
+	# The current time as an IMF-fixdate suitable for the (http/header)`Date` field.
+	# Formatted at most once per second.
+	"""
+	now = int(time())
+	if cache[0] != now:
+		cache[1] = format(now, usegmt=True).encode('ascii')
+		cache[0] = now
+	return cache[1]
+
+class Template(object):
+	"""
+	# Precompiled header block for fields shared by many messages.
+
+	# [ Properties ]
+	# /t_fields/
+		# The static fields of the block.
+	# /t_slots/
+		# Sequence of field name and callable pairs producing the
+		# per-message values that follow the static fields.
+	# /t_block/
+		# The serialized form of &t_fields.
+	"""
+
+	def __init__(self, fields, slots=((b'Date', date),), CRLF=protocoldata.CRLF, HFS=protocoldata.HFS):
+		self.t_fields = list(fields)
+		self.t_slots = list(slots)
+		self.t_block = b''.join(headers(self.t_fields))
+		self._t_prefixes = [(k + HFS, f) for k, f in self.t_slots]
+
+	def fields(self) -> list:
+		"""
+		# Construct the complete sequence of fields for a message.
+		"""
+		return self.t_fields + [(k, f()) for k, f in self.t_slots]
+
+	def serialize(self, CRLF=protocoldata.CRLF) -> bytes:
+		"""
+		# Construct the serialized header block for a message.
+		"""
+		return self.t_block + b''.join([k + f() + CRLF for k, f in self._t_prefixes])
+
+class Fields(list):
+	"""
+	# Header sequence extending a &Template.
+
+	# The list only holds the fields specific to the message;
+	# &Serialization emits the template's block before them.
+	"""
+
+	def __init__(self, template:Template, iterable=()):
+		super().__init__(iterable)
+		self.f_template = template
+
+	def complete(self) -> list:
+		"""
+		# Construct the full sequence of fields including the template's.
+		"""
+		return self.f_template.fields() + self
+
 def Serialization(
 		chunk_map = {
 			ev_chunk: chunk,
@@ -720,12 +847,16 @@ def Serialization(
 	):
 	"""
 	# Assemble HTTP events back into a sequences of bytes.
+
+	# Events of consecutive messages are concatenated into the same buffer
+	# so that pipelined responses can be written with a single transfer.
+	# Raw transfers, &ev_wire, are passed through as separate buffers.
 	"""
 
 	events = (yield None)
 	while True:
 		buf = bytearray()
-		seq = (buf,)
+		seq = None
 
 		for (t, v) in events:
 			# keep content/chunks first to minimize transfer overhead
@@ -734,20 +865,32 @@ def Serialization(
 				for x in (chunk_map[t](v)):
 					buf += x
 			elif t == -3: # ev_wire
-				assert len(buf) == 0
-				seq = v
-				del buf # Trigger exception if events follow.
+				if seq is None:
+					seq = []
+				if buf:
+					seq.append(buf)
+					buf = bytearray()
+				seq.extend(v)
 			elif t == 0: # ev_rline
 				buf += (b" ".join(v))
 				buf += (b"\r\n")
 			else: # {ev_headers, ev_trailers}
-				if not v:
+				if v.__class__ is Fields:
+					buf += v.f_template.serialize()
+					if v:
+						buf += (b"\r\n".join(y[0] + b": " + y[1] for y in v))
+						buf += (b"\r\n")
+				elif not v:
 					# end of headers
 					buf += (b"\r\n")
 				else:
 					buf += (b"\r\n".join(y[0] + b": " + y[1] for y in v))
 					buf += (b"\r\n")
 
+		if seq is None:
+			seq = (buf,)
+		elif buf:
+			seq.append(buf)
 		events = (yield seq)
 Assembler = Serialization
 
@@ -0,0 +1,824 @@
+"""
+# HTTP/2 framing and connection state.
+
+# Provides the frame codec along with the stream, flow control, and priority
+# accounting needed to multiplex messages over a single transport. &Connection
+# performs no I/O; received octets are given to &Connection.receive producing
+# stream events, and &Connection.transmit produces the frames to be written.
+# Received DATA is only returned to the peer's windows once the application
+# notes its consumption with &Connection.consumed.
+
+# [ Events ]
+
+# /(id)`HEADERS`/
+	# (&ev_headers, stream, [(&bytes, &bytes),...], end_stream)
+	# Initial or trailing header block; `end_stream` when no data follows.
+# /(id)`DATA`/
+	# (&ev_data, stream, &bytes, end_stream)
+# /(id)`RESET`/
+	# (&ev_reset, stream, error_code)
+	# The stream was abandoned by the peer or by a detected stream error.
+# /(id)`GOAWAY`/
+	# (&ev_goaway, last_stream, error_code)
+	# The connection is shutting down. Emitted for received GOAWAY frames
+	# and connection errors; for the latter, no further events are produced.
+"""
+import struct
+import collections
+
+from . import hpack
+
+preface = b'PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n'
+
+ev_headers = 1
+ev_data = 2
+ev_reset = 3
+ev_goaway = 4
+
+# Frame types.
+ft_data = 0x0
+ft_headers = 0x1
+ft_priority = 0x2
+ft_rst_stream = 0x3
+ft_settings = 0x4
+ft_push_promise = 0x5
+ft_ping = 0x6
+ft_goaway = 0x7
+ft_window_update = 0x8
+ft_continuation = 0x9
+
+# Frame flags.
+ff_end_stream = 0x1
+ff_ack = 0x1
+ff_end_headers = 0x4
+ff_padded = 0x8
+ff_priority = 0x20
+
+# Settings identifiers.
+st_header_table_size = 0x1
+st_enable_push = 0x2
+st_max_concurrent_streams = 0x3
+st_initial_window_size = 0x4
+st_max_frame_size = 0x5
+st_max_header_list_size = 0x6
+
+# Error codes.
+ec_no_error = 0x0
+ec_protocol_error = 0x1
+ec_internal_error = 0x2
+ec_flow_control_error = 0x3
+ec_settings_timeout = 0x4
+ec_stream_closed = 0x5
+ec_frame_size_error = 0x6
+ec_refused_stream = 0x7
+ec_cancel = 0x8
+ec_compression_error = 0x9
+ec_connect_error = 0xa
+ec_enhance_your_calm = 0xb
+ec_inadequate_security = 0xc
+ec_http_1_1_required = 0xd
+
+window_limit = (1 << 31) - 1
+frame_size_limit = (1 << 24) - 1
+
+# Settings assumed for a peer until its SETTINGS frame is received.
+defaults = {
+	st_header_table_size: 4096,
+	st_enable_push: 1,
+	st_max_concurrent_streams: window_limit,
+	st_initial_window_size: 65535,
+	st_max_frame_size: 16384,
+	st_max_header_list_size: window_limit,
+}
+
+# Fields that must not be sent in HTTP/2 messages.
+connection_headers = frozenset([
+	b'connection',
+	b'keep-alive',
+	b'proxy-connection',
+	b'transfer-encoding',
+	b'upgrade',
+	b'host',
+])
+
+_frame_header = struct.Struct('>HBBBL')
+_setting = struct.Struct('>HL')
+_u32 = struct.Struct('>L')
+_u32x2 = struct.Struct('>LL')
+_priority = struct.Struct('>LB')
+
+def frame(type:int, flags:int, stream:int, payload=b'', pack=_frame_header.pack) -> bytes:
+	"""
+	# Serialize a single frame.
+	"""
+	l = len(payload)
+	return pack(l >> 8, l & 0xFF, type, flags, stream) + payload
+
+def settings_frame(pairs, pack=_setting.pack) -> bytes:
+	"""
+	# Serialize a SETTINGS frame from the given (identifier, value) pairs.
+	"""
+	return frame(ft_settings, 0, 0, b''.join(pack(k, v) for k, v in pairs))
+
+class Error(Exception):
+	"""
+	# Protocol error identified while interpreting received frames.
+
+	# [ Properties ]
+	# /code/
+		# The error code to send to the peer.
+	# /stream/
+		# The stream of a stream error; zero for connection errors.
+	"""
+
+	def __init__(self, code, stream=0, description=None):
+		self.code = code
+		self.stream = stream
+		self.description = description
+
+	def __str__(self):
+		return "error code %d on stream %d: %s" %(self.code, self.stream, self.description)
+
+class Stream(object):
+	"""
+	# Stream state held by &Connection.
+
+	# [ Properties ]
+	# /s_send_window/
+		# Octets of DATA the peer is prepared to receive.
+	# /s_receive_window/
+		# Octets of DATA the peer may send before a WINDOW_UPDATE is needed.
+	# /s_receive_consumed/
+		# Octets of received DATA consumed by the application that have not
+		# been returned to the peer with a WINDOW_UPDATE.
+	# /s_queue/
+		# Data waiting for window or scheduling.
+	# /s_end/
+		# Whether END_STREAM should be sent once &s_queue is empty.
+	# /s_headers/
+		# The HEADERS frame of the stream while it has not been transmitted;
+		# allows END_STREAM to be set when the message has no content.
+	"""
+
+	__slots__ = (
+		's_identifier',
+		's_weight',
+		's_parent',
+		's_send_window',
+		's_receive_window',
+		's_receive_consumed',
+		's_queue',
+		's_end',
+		's_headers',
+		's_local_closed',
+		's_remote_closed',
+	)
+
+	def __init__(self, identifier, send_window, receive_window):
+		self.s_identifier = identifier
+		self.s_weight = 16
+		self.s_parent = 0
+		self.s_send_window = send_window
+		self.s_receive_window = receive_window
+		self.s_receive_consumed = 0
+		self.s_queue = collections.deque()
+		self.s_end = False
+		self.s_headers = None
+		self.s_local_closed = False
+		self.s_remote_closed = False
+
+class Connection(object):
+	"""
+	# HTTP/2 connection state for either side of a connection.
+
+	# [ Properties ]
+	# /c_local/
+		# Settings advertised to the peer.
+	# /c_remote/
+		# Settings received from the peer.
+	# /c_streams/
+		# Open and half-closed streams by identifier.
+	# /c_output/
+		# Frames queued for &transmit that are not subject to flow control.
+	# /c_pending/
+		# Streams with queued data or an unsent END_STREAM.
+	# /c_continuation/
+		# The stream, flags, and fragments of a header block awaiting CONTINUATION frames.
+	# /c_continuation_size/
+		# The number of octets held by &c_continuation; limited by the local
+		# (id)`SETTINGS_MAX_HEADER_LIST_SIZE`.
+	# /c_receive_consumed/
+		# Octets of received DATA consumed by the application that have not
+		# been returned to the peer with a connection WINDOW_UPDATE.
+	"""
+
+	def __init__(self, disposition='server', settings=None, window=1 << 24):
+		"""
+		# [ Parameters ]
+		# /disposition/
+			# `'client'` or `'server'`.
+		# /settings/
+			# Mapping of settings to advertise overriding the local defaults.
+		# /window/
+			# Size of the connection's receive window.
+		"""
+		self.c_client = (disposition == 'client')
+		self.c_local = dict(defaults)
+		self.c_local[st_enable_push] = 0
+		self.c_local[st_max_concurrent_streams] = 128
+		self.c_local[st_initial_window_size] = 1 << 20
+		self.c_local[st_max_header_list_size] = 1 << 16
+		if settings:
+			self.c_local.update(settings)
+		self.c_remote = dict(defaults)
+
+		self.c_encoder = hpack.Encoder(self.c_remote[st_header_table_size])
+		self.c_decoder = hpack.Decoder(self.c_local[st_header_table_size])
+
+		self.c_streams = {}
+		self.c_priorities = {}
+		self.c_pending = {}
+		self.c_output = []
+		self.c_headed = []
+		self.c_buffer = b''
+		self.c_continuation = None
+		self.c_continuation_size = 0
+
+		self.c_send_window = defaults[st_initial_window_size]
+		self.c_receive_window = defaults[st_initial_window_size]
+		self.c_receive_target = window
+		self.c_receive_consumed = 0
+
+		self.c_last_remote = 0
+		self.c_next_local = 1 if self.c_client else 2
+		self.c_preface = not self.c_client
+		self.c_closed = False
+
+		if self.c_client:
+			self.c_output.append(preface)
+		self.c_output.append(settings_frame([
+			(k, v) for k, v in self.c_local.items() if v != defaults[k]
+		]))
+		if window > self.c_receive_window:
+			self.c_output.append(frame(ft_window_update, 0, 0, _u32.pack(window - self.c_receive_window)))
+			self.c_receive_window = window
+
+		self._frames = {
+			ft_data: self._data,
+			ft_headers: self._headers,
+			ft_priority: self._priority,
+			ft_rst_stream: self._rst_stream,
+			ft_settings: self._settings,
+			ft_push_promise: self._push_promise,
+			ft_ping: self._ping,
+			ft_goaway: self._goaway,
+			ft_window_update: self._window_update,
+			ft_continuation: self._continuation,
+		}
+
+	@property
+	def pending(self) -> bool:
+		"""
+		# Whether &transmit would produce frames.
+		"""
+		return bool(self.c_output or self.c_pending)
+
+	def _open(self, identifier):
+		s = Stream(identifier,
+			self.c_remote[st_initial_window_size],
+			self.c_local[st_initial_window_size],
+		)
+		self.c_streams[identifier] = s
+		return s
+
+	def _local_close(self, s):
+		s.s_local_closed = True
+		if s.s_remote_closed:
+			self.c_streams.pop(s.s_identifier, None)
+
+	def _remote_close(self, s):
+		s.s_remote_closed = True
+		if s.s_local_closed:
+			self.c_streams.pop(s.s_identifier, None)
+
+	def _discard(self, s):
+		sid = s.s_identifier
+		self.c_streams.pop(sid, None)
+		self.c_pending.pop(sid, None)
+		s.s_queue.clear()
+		s.s_end = False
+		s.s_local_closed = s.s_remote_closed = True
+
+	def _remote_streams(self):
+		parity = 0 if self.c_client else 1
+		return sum(1 for x in self.c_streams if x % 2 == parity)
+
+	# Receive
+
+	def receive(self, data, unpack=_frame_header.unpack_from) -> list:
+		"""
+		# Interpret the given octets producing a list of stream events.
+		# Incomplete frames are retained until the next call.
+		"""
+		events = []
+		if self.c_closed:
+			return events
+
+		if self.c_buffer:
+			buf = self.c_buffer + data
+		else:
+			buf = data
+		offset = 0
+		size = len(buf)
+
+		try:
+			if self.c_preface:
+				l = len(preface)
+				if size < l:
+					if not preface.startswith(bytes(buf)):
+						raise Error(ec_protocol_error, 0, "invalid connection preface")
+					self.c_buffer = bytes(buf)
+					return events
+
+				if buf[:l] != preface:
+					raise Error(ec_protocol_error, 0, "invalid connection preface")
+				self.c_preface = False
+				offset = l
+
+			limit = self.c_local[st_max_frame_size]
+			while size - offset >= 9:
+				hi, lo, type, flags, sid = unpack(buf, offset)
+				length = (hi << 8) | lo
+				if length > limit:
+					raise Error(ec_frame_size_error, 0, "frame exceeds maximum size")
+
+				end = offset + 9 + length
+				if end > size:
+					break
+
+				payload = bytes(buf[offset+9:end])
+				offset = end
+				sid &= window_limit
+
+				if self.c_continuation is not None and type != ft_continuation:
+					raise Error(ec_protocol_error, 0, "header block interrupted")
+
+				try:
+					method = self._frames.get(type)
+					if method is not None:
+						method(events, flags, sid, payload)
+				except Error as err:
+					if not err.stream:
+						raise
+					self.reset(err.stream, err.code)
+					events.append((ev_reset, err.stream, err.code))
+		except Error as err:
+			self.goaway(err.code)
+			events.append((ev_goaway, self.c_last_remote, err.code))
+			self.c_buffer = b''
+			return events
+
+		self.c_buffer = bytes(buf[offset:])
+		return events
+
+	def _unpad(self, flags, payload):
+		if flags & ff_padded:
+			if not payload:
+				raise Error(ec_frame_size_error, 0, "padded frame without pad length")
+			pad = payload[0]
+			if pad >= len(payload):
+				raise Error(ec_protocol_error, 0, "padding exceeds frame")
+			return payload[1:len(payload)-pad]
+		return payload
+
+	def _data(self, events, flags, sid, payload):
+		if sid == 0:
+			raise Error(ec_protocol_error, 0, "DATA on stream zero")
+
+		# Connection window applies regardless of the stream's state.
+		size = len(payload)
+		self.c_receive_window -= size
+		if self.c_receive_window < 0:
+			raise Error(ec_flow_control_error, 0, "connection receive window exceeded")
+
+		s = self.c_streams.get(sid)
+		if s is None or s.s_remote_closed:
+			if s is None and self._idle(sid):
+				raise Error(ec_protocol_error, 0, "DATA on idle stream")
+
+			# Discarded; the octets are returned to the connection window.
+			self.consumed(0, size)
+			raise Error(ec_stream_closed, sid, "DATA on closed stream")
+
+		s.s_receive_window -= size
+		if s.s_receive_window < 0:
+			self.consumed(0, size)
+			raise Error(ec_flow_control_error, sid, "stream receive window exceeded")
+
+		data = self._unpad(flags, payload)
+		end = bool(flags & ff_end_stream)
+		if end:
+			self._remote_close(s)
+
+		# Padding is consumed upon receipt; the data when the application
+		# notes it with &consumed.
+		if size > len(data):
+			self.consumed(sid, size - len(data))
+
+		events.append((ev_data, sid, data, end))
+
+	def _idle(self, sid):
+		# Whether the stream identifier has not been used by either endpoint.
+		if (sid % 2 == 1) == self.c_client:
+			return sid >= self.c_next_local
+		return sid > self.c_last_remote
+
+	def _headers(self, events, flags, sid, payload):
+		if sid == 0:
+			raise Error(ec_protocol_error, 0, "HEADERS on stream zero")
+
+		data = self._unpad(flags, payload)
+		if flags & ff_priority:
+			if len(data) < 5:
+				raise Error(ec_frame_size_error, 0, "truncated priority fields")
+			dependency, weight = _priority.unpack_from(data)
+			data = data[5:]
+			self._prioritize(sid, dependency, weight)
+
+		self._header_limit(len(data))
+		if flags & ff_end_headers:
+			self._header_block(events, sid, flags, data)
+		else:
+			self.c_continuation = (sid, flags, [data])
+			self.c_continuation_size = len(data)
+
+	def _continuation(self, events, flags, sid, payload):
+		if self.c_continuation is None or self.c_continuation[0] != sid:
+			raise Error(ec_protocol_error, 0, "unexpected CONTINUATION")
+
+		self.c_continuation_size += len(payload)
+		self._header_limit(self.c_continuation_size)
+
+		self.c_continuation[2].append(payload)
+		if flags & ff_end_headers:
+			sid, hflags, fragments = self.c_continuation
+			self.c_continuation = None
+			self.c_continuation_size = 0
+			self._header_block(events, sid, hflags, b''.join(fragments))
+
+	def _header_limit(self, size):
+		# Encoded fields are never larger than their contribution to the list size,
+		# so a block exceeding the limit is refused before it is decoded.
+		if size > self.c_local[st_max_header_list_size]:
+			raise Error(ec_enhance_your_calm, 0, "header block exceeds the header list size")
+
+	def _header_block(self, events, sid, flags, block):
+		# Always decode to keep the table synchronized with the peer's encoder.
+		try:
+			headers = self.c_decoder.decode(block)
+		except hpack.CompressionError as err:
+			raise Error(ec_compression_error, 0, str(err))
+
+		# Indexed fields may expand beyond the size of the block.
+		self._header_limit(sum(len(k) + len(v) + 32 for k, v in headers))
+
+		end = bool(flags & ff_end_stream)
+		s = self.c_streams.get(sid)
+		if s is None:
+			if self.c_client or sid % 2 == 0 or sid <= self.c_last_remote:
+				raise Error(ec_protocol_error, 0, "invalid stream identifier")
+			self.c_last_remote = sid
+
+			if self._remote_streams() >= self.c_local[st_max_concurrent_streams]:
+				raise Error(ec_refused_stream, sid, "concurrent stream limit")
+			s = self._open(sid)
+			self._prioritize(sid, *self.c_priorities.pop(sid, (0, 15)))
+		elif s.s_remote_closed:
+			raise Error(ec_stream_closed, sid, "HEADERS on closed stream")
+
+		if end:
+			self._remote_close(s)
+		events.append((ev_headers, sid, headers, end))
+
+	def _prioritize(self, sid, dependency, weight):
+		exclusive = dependency >> 31
+		dependency &= window_limit
+		if dependency == sid:
+			raise Error(ec_protocol_error, sid, "stream depends on itself")
+
+		s = self.c_streams.get(sid)
+		if s is None:
+			# Idle stream; applied when opened.
+			if sid > self.c_last_remote and len(self.c_priorities) < 256:
+				self.c_priorities[sid] = (dependency | (exclusive << 31), weight)
+			return
+
+		# Move the new parent if it is a descendant of the stream.
+		p = self.c_streams.get(dependency)
+		depth = len(self.c_streams)
+		while p is not None and depth > 0:
+			if p.s_parent == sid:
+				self.c_streams[dependency].s_parent = s.s_parent
+				break
+			p = self.c_streams.get(p.s_parent)
+			depth -= 1
+
+		if exclusive:
+			for x in self.c_streams.values():
+				if x.s_parent == dependency and x is not s:
+					x.s_parent = sid
+
+		s.s_parent = dependency
+		s.s_weight = weight + 1
+
+	def _priority(self, events, flags, sid, payload):
+		if sid == 0:
+			raise Error(ec_protocol_error, 0, "PRIORITY on stream zero")
+		if len(payload) != 5:
+			raise Error(ec_frame_size_error, sid, "invalid PRIORITY size")
+
+		self._prioritize(sid, *_priority.unpack(payload))
+
+	def _rst_stream(self, events, flags, sid, payload):
+		if sid == 0:
+			raise Error(ec_protocol_error, 0, "RST_STREAM on stream zero")
+		if len(payload) != 4:
+			raise Error(ec_frame_size_error, 0, "invalid RST_STREAM size")
+
+		s = self.c_streams.get(sid)
+		if s is not None:
+			self._discard(s)
+		events.append((ev_reset, sid, _u32.unpack(payload)[0]))
+
+	def _settings(self, events, flags, sid, payload):
+		if sid != 0:
+			raise Error(ec_protocol_error, 0, "SETTINGS on a stream")
+
+		if flags & ff_ack:
+			if payload:
+				raise Error(ec_frame_size_error, 0, "SETTINGS acknowledgement with payload")
+			return
+
+		if len(payload) % 6:
+			raise Error(ec_frame_size_error, 0, "invalid SETTINGS size")
+
+		remote = self.c_remote
+		for i in range(0, len(payload), 6):
+			k, v = _setting.unpack_from(payload, i)
+
+			if k == st_initial_window_size:
+				if v > window_limit:
+					raise Error(ec_flow_control_error, 0, "initial window size too large")
+				delta = v - remote[k]
+				for s in self.c_streams.values():
+					s.s_send_window += delta
+			elif k == st_max_frame_size:
+				if v < defaults[k] or v > frame_size_limit:
+					raise Error(ec_protocol_error, 0, "invalid maximum frame size")
+			elif k == st_enable_push:
+				if v > 1:
+					raise Error(ec_protocol_error, 0, "invalid push setting")
+			elif k == st_header_table_size:
+				size = min(v, defaults[k])
+				if size != self.c_encoder.table.max_size:
+					self.c_encoder.resize(size)
+			elif k not in remote:
+				# Unknown settings are ignored.
+				continue
+
+			remote[k] = v
+
+		self.c_output.append(frame(ft_settings, ff_ack, 0))
+
+	def _push_promise(self, events, flags, sid, payload):
+		raise Error(ec_protocol_error, 0, "push is disabled")
+
+	def _ping(self, events, flags, sid, payload):
+		if sid != 0:
+			raise Error(ec_protocol_error, 0, "PING on a stream")
+		if len(payload) != 8:
+			raise Error(ec_frame_size_error, 0, "invalid PING size")
+
+		if not flags & ff_ack:
+			self.c_output.append(frame(ft_ping, ff_ack, 0, payload))
+
+	def _goaway(self, events, flags, sid, payload):
+		if sid != 0:
+			raise Error(ec_protocol_error, 0, "GOAWAY on a stream")
+		if len(payload) < 8:
+			raise Error(ec_frame_size_error, 0, "invalid GOAWAY size")
+
+		last, code = _u32x2.unpack_from(payload)
+		events.append((ev_goaway, last & window_limit, code))
+
+	def _window_update(self, events, flags, sid, payload):
+		if len(payload) != 4:
+			raise Error(ec_frame_size_error, 0, "invalid WINDOW_UPDATE size")
+
+		increment = _u32.unpack(payload)[0] & window_limit
+		if increment == 0:
+			raise Error(ec_protocol_error, sid, "zero window increment")
+
+		if sid == 0:
+			self.c_send_window += increment
+			if self.c_send_window > window_limit:
+				raise Error(ec_flow_control_error, 0, "connection window overflow")
+		else:
+			s = self.c_streams.get(sid)
+			if s is not None:
+				s.s_send_window += increment
+				if s.s_send_window > window_limit:
+					raise Error(ec_flow_control_error, sid, "stream window overflow")
+
+	# Send
+
+	def open(self) -> int:
+		"""
+		# Allocate a locally initiated stream returning its identifier.
+		"""
+		sid = self.c_next_local
+		self.c_next_local += 2
+		self._open(sid)
+		return sid
+
+	def headers(self, sid:int, headers, end:bool=False) -> bool:
+		"""
+		# Queue a header block for the stream.
+		# Returns &False if the stream has been closed or reset.
+		"""
+		s = self.c_streams.get(sid)
+		if s is None or s.s_local_closed:
+			return False
+
+		block = self.c_encoder.encode(headers)
+		size = self.c_remote[st_max_frame_size]
+		flags = ff_end_stream if end else 0
+
+		if len(block) <= size:
+			first = bytearray(frame(ft_headers, flags | ff_end_headers, sid, block))
+			self.c_output.append(first)
+		else:
+			first = bytearray(frame(ft_headers, flags, sid, block[:size]))
+			self.c_output.append(first)
+			for i in range(size, len(block), size):
+				cflags = ff_end_headers if i + size >= len(block) else 0
+				self.c_output.append(frame(ft_continuation, cflags, sid, block[i:i+size]))
+
+		if end:
+			self._local_close(s)
+		else:
+			s.s_headers = first
+			self.c_headed.append(s)
+
+		return True
+
+	def data(self, sid:int, data, end:bool=False) -> bool:
+		"""
+		# Queue data for the stream; sent by &transmit as windows permit.
+		# Returns &False if the stream has been closed or reset.
+		"""
+		s = self.c_streams.get(sid)
+		if s is None or s.s_local_closed or s.s_end:
+			return False
+
+		if data:
+			s.s_queue.append(data)
+			s.s_headers = None
+
+		if end:
+			if not s.s_queue and s.s_headers is not None:
+				# No content; signal the end with the unsent HEADERS frame.
+				s.s_headers[4] |= ff_end_stream
+				s.s_headers = None
+				self._local_close(s)
+				return True
+			s.s_end = True
+
+		if s.s_queue or s.s_end:
+			self.c_pending[sid] = s
+
+		return True
+
+	def consumed(self, sid:int, size:int):
+		"""
+		# Note that &size octets of DATA received on the stream &sid were consumed
+		# by the application. WINDOW_UPDATE frames are queued once half of the
+		# corresponding receive window has been consumed; received DATA that
+		# is never noted continues to count against the windows.
+		"""
+		self.c_receive_consumed += size
+		if self.c_receive_consumed >= self.c_receive_target // 2:
+			self.c_output.append(frame(ft_window_update, 0, 0, _u32.pack(self.c_receive_consumed)))
+			self.c_receive_window += self.c_receive_consumed
+			self.c_receive_consumed = 0
+
+		s = self.c_streams.get(sid)
+		if s is not None and not s.s_remote_closed:
+			s.s_receive_consumed += size
+			if s.s_receive_consumed >= self.c_local[st_initial_window_size] // 2:
+				self.c_output.append(frame(ft_window_update, 0, sid, _u32.pack(s.s_receive_consumed)))
+				s.s_receive_window += s.s_receive_consumed
+				s.s_receive_consumed = 0
+
+	def reset(self, sid:int, code:int=ec_cancel):
+		"""
+		# Abandon the stream.
+		"""
+		self.c_output.append(frame(ft_rst_stream, 0, sid, _u32.pack(code)))
+		s = self.c_streams.get(sid)
+		if s is not None:
+			self._discard(s)
+
+	def goaway(self, code:int=ec_no_error):
+		"""
+		# Signal the end of the connection; subsequently received frames are ignored
+		# when &code is an error.
+		"""
+		self.c_output.append(frame(ft_goaway, 0, 0, _u32x2.pack(self.c_last_remote, code)))
+		if code != ec_no_error:
+			self.c_closed = True
+
+	def _blocked(self, s):
+		# Whether an ancestor is able to send.
+		pending = self.c_pending
+		streams = self.c_streams
+		depth = len(streams)
+		p = streams.get(s.s_parent)
+		while p is not None and depth > 0:
+			if p.s_identifier in pending and p.s_send_window > 0 and p.s_queue:
+				return True
+			p = streams.get(p.s_parent)
+			depth -= 1
+		return False
+
+	def _take(self, s, limit):
+		q = s.s_queue
+		parts = []
+		n = 0
+		while q and n < limit:
+			x = q[0]
+			l = len(x)
+			if n + l <= limit:
+				parts.append(q.popleft())
+				n += l
+			else:
+				r = limit - n
+				x = memoryview(x)
+				parts.append(x[:r])
+				q[0] = x[r:]
+				n = limit
+		return b''.join(parts)
+
+	def transmit(self) -> list:
+		"""
+		# Produce the frames to be written; control frames first followed by data
+		# scheduled by stream priority within the available windows.
+		"""
+		out = self.c_output
+		self.c_output = []
+		for s in self.c_headed:
+			s.s_headers = None
+		self.c_headed = []
+
+		pending = self.c_pending
+		limit = self.c_remote[st_max_frame_size]
+
+		while pending:
+			progress = False
+			for s in sorted(pending.values(), key=(lambda x: -x.s_weight)):
+				if self._blocked(s):
+					continue
+
+				sid = s.s_identifier
+				quantum = max(limit * s.s_weight // 16, 1024)
+				while s.s_queue and quantum > 0:
+					window = min(self.c_send_window, s.s_send_window, limit, quantum)
+					if window <= 0:
+						break
+
+					chunk = self._take(s, window)
+					l = len(chunk)
+					self.c_send_window -= l
+					s.s_send_window -= l
+					quantum -= l
+
+					if s.s_end and not s.s_queue:
+						out.append(frame(ft_data, ff_end_stream, sid, chunk))
+						s.s_end = False
+						self._local_close(s)
+					else:
+						out.append(frame(ft_data, 0, sid, chunk))
+					progress = True
+
+				if not s.s_queue:
+					if s.s_end:
+						out.append(frame(ft_data, ff_end_stream, sid))
+						s.s_end = False
+						self._local_close(s)
+						progress = True
+					del pending[sid]
+
+			if not progress:
+				break
+
+		return out
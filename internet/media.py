@@ -31,6 +31,11 @@
 	# Construct a &Range instance from a Media Range string like an Accept header.
 
 	# Equivalent to &Range.from_string, but cached.
+# /range_from_bytes/
+	# Construct a &Range instance from an undecoded Accept header.
+
+	# Equivalent to &Range.from_bytes, but cached. The cache is shared by the
+	# process so that the common headers sent by user agents are parsed once.
 """
 import operator
 import functools
@@ -391,6 +396,73 @@ class Range(tuple):
 
 		return (current, position, quality)
 
+class Index(object):
+	"""
+	# Negotiation index for a fixed sequence of offered types.
+
+	# The offered types are indexed by the range patterns that contain them so that
+	# a &Range can be resolved in a single pass over its entries. The quality of an
+	# offered type is determined by the most specific range entry containing it, and
+	# the order of the offered types is used to select between equal qualities.
+
+	# [ Properties ]
+	# /i_types/
+		# The offered types in order of preference.
+	# /i_patterns/
+		# Mapping of type and subtype patterns to the offered types that they contain.
+	# /i_offered_patterns/
+		# The offered types that are patterns themselves.
+	"""
+	__slots__ = ('i_types', 'i_patterns', 'i_offered_patterns')
+
+	def __init__(self, types:typing.Iterable[Type]):
+		self.i_types = tuple(types)
+		patterns = {}
+		offered = []
+
+		for t in self.i_types:
+			if t.pattern:
+				offered.append(t)
+				continue
+
+			for k in ((t[0], t[1]), (t[0], '*'), ('*', '*')):
+				patterns.setdefault(k, []).append(t)
+
+		self.i_patterns = {k: tuple(v) for k, v in patterns.items()}
+		self.i_offered_patterns = tuple(offered)
+
+	def query(self, range:Range):
+		"""
+		# Select the offered type best matching the &range.
+		# Returns the selected type, the range entry that matched it, and the quality;
+		# &None when no offered type is acceptable.
+		"""
+		best = {}
+		get = self.i_patterns.get
+
+		for q, mt in range:
+			specificity = (mt[0] != '*') + (mt[1] != '*') + (len(mt[2]) > 0)
+
+			candidates = get((mt[0], mt[1]), ())
+			if self.i_offered_patterns:
+				candidates += tuple(x for x in self.i_offered_patterns if mt in x)
+
+			for t in candidates:
+				if mt[2] and not (t in mt or mt in t):
+					continue
+
+				prior = best.get(t)
+				if prior is None or specificity > prior[0]:
+					best[t] = (specificity, q, mt)
+
+		selected = None
+		for t in self.i_types:
+			m = best.get(t)
+			if m is not None and m[1] > 0 and (selected is None or m[1] > selected[2]):
+				selected = (t, m[2], m[1])
+
+		return selected
+
 any_type = Type(('*', '*', frozenset()))
 any_range = Range([(100, any_type)])
 
@@ -398,3 +470,4 @@ any_range = Range([(100, any_type)])
 type_from_bytes = functools.lru_cache(32)(Type.from_bytes)
 type_from_string = functools.lru_cache(32)(Type.from_string)
 range_from_string = functools.lru_cache(32)(Range.from_string)
+range_from_bytes = functools.lru_cache(256)(Range.from_bytes)
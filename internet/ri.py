@@ -34,6 +34,7 @@
 """
 
 import collections
+from string import ascii_letters
 
 scheme_chars = '-.+0123456789'
 reserved_chars = "%!*'();:@&=+$,/?#[]"
@@ -48,8 +49,22 @@ def _decode_parts(string, chr=chr, int=int):
 		yield string[2:]
 
 def decode_percent_escapes(string, parse=_decode_parts):
+	if '%' not in string:
+		return string
 	return ''.join(parse(string))
 
+try:
+	from . import percent as _native
+except ImportError:
+	pass
+else:
+	def decode_percent_escapes(string, parse=_decode_parts, decode=_native.decode):
+		try:
+			return decode(string)
+		except ValueError:
+			# Irregular escapes are interpreted by the Python implementation.
+			return ''.join(parse(string))
+
 def strict():
 	"""
 	# Enable strict serializations.
@@ -139,7 +154,7 @@ Parts = collections.namedtuple("Parts",
 	('type', 'scheme', 'netloc', 'path', 'query', 'fragment')
 )
 
-def split(iri, _scheme_char_set=set(scheme_chars)):
+def split(iri, _scheme_char_set=frozenset(scheme_chars + ascii_letters)):
 	"""
 	# Split an IRI into its base components based on the markers:
 
@@ -183,19 +198,11 @@ def split(iri, _scheme_char_set=set(scheme_chars)):
 			scheme = s[:scheme_pos]
 
 			# validate the scheme.
-			for x in scheme:
-				# ! DEFECT:
-					# The range check here has the possibility of recognizing
-					# characters outside of the ascii uppercase and lowercase.
-					# While this isn't a strict parser, it was not the original
-					# intention to accept those values(early versions supporting bytes).
-				if not (x in _scheme_char_set) and \
-				not ('A' <= x <= 'Z') and not ('a' <= x <= 'z'):
-					# it's not a valid scheme
-					pos = 0
-					scheme = None
-					type = "amorphous"
-					break
+			if not _scheme_char_set.issuperset(scheme):
+				# it's not a valid scheme
+				pos = 0
+				scheme = None
+				type = "amorphous"
 
 	end_of_netloc = end
 
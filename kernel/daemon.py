@@ -6,16 +6,53 @@ import weakref
 
 from ..system import execution
 from ..system import process
+from ..system import metrics
+from ..time import types as timetypes
 
 from . import core as kcore
 from . import dispatch as kdispatch
 from . import system
 
+class Restart(object):
+	"""
+	# Deferred restart of a worker; kept by the manager until it occurs.
+	"""
+
+	def __init__(self, manager, fork_id):
+		self.r_manager = weakref.ref(manager)
+		self.r_fork_id = fork_id
+
+	def occur(self):
+		pm = self.r_manager()
+		if pm is not None:
+			pm.ctl_restart(self.r_fork_id)
+
 class ProcessManager(kcore.Context):
 	"""
 	# Application context maintaining a pool of worker processes.
+
+	# Listening sockets allocated before the &ProcessManager is dispatched are inherited
+	# by every worker, and the system distributes the accepted connections across them.
+
+	# [ Properties ]
+	# /ctl_restart_window/
+		# Workers exiting within this many nanoseconds of their start are considered
+		# failures; consecutive failures delay the restart.
+	# /ctl_restart_delay/
+		# The delay, in nanoseconds, applied after the first failure; doubled
+		# for each consecutive failure.
+	# /ctl_restart_limit/
+		# The maximum restart delay in nanoseconds.
+	# /ctl_restarts/
+		# Mapping of fork identifiers to the number of times the worker was restarted.
+	# /ctl_failures/
+		# Mapping of fork identifiers to the number of consecutive failures.
 	"""
 
+	ctl_restart_window = 1000000000
+	ctl_restart_delay = 100000000
+	ctl_restart_limit = 30000000000
+
 	def __init__(self, application, update, concurrency=4):
 		self.ctl_application = application
 		self.ctl_update = update
@@ -23,11 +60,73 @@ class ProcessManager(kcore.Context):
 
 		self.ctl_fork_id_to_subprocess = weakref.WeakValueDictionary()
 		self.ctl_last_exit_status = {}
+		self.ctl_started = {}
+		self.ctl_restarts = {}
+		self.ctl_failures = {}
+		self.ctl_pending = {}
 
 	def actuate(self):
 		for i in range(1, self.ctl_concurrency+1):
 			self.ctl_fork(i)
 
+	def ctl_exit_delay(self, fid, now) -> int:
+		"""
+		# Identify the delay, in nanoseconds, before restarting the worker &fid that
+		# exited at &now; updates the failure count of the worker.
+		"""
+
+		started = self.ctl_started.get(fid, now)
+		if now - started < self.ctl_restart_window:
+			n = self.ctl_failures[fid] = self.ctl_failures.get(fid, 0) + 1
+			return min(self.ctl_restart_limit, self.ctl_restart_delay * (2 ** (n - 1)))
+
+		self.ctl_failures.pop(fid, None)
+		return 0
+
+	def ctl_restart(self, fid):
+		"""
+		# Fork the worker identified by &fid unless the manager is terminating.
+		"""
+
+		self.ctl_pending.pop(fid, None)
+		if self.terminating or not self.functioning:
+			return
+
+		self.ctl_restarts[fid] = self.ctl_restarts.get(fid, 0) + 1
+		self.ctl_fork(fid)
+
+	def ctl_statistics(self, read=metrics.read) -> dict:
+		"""
+		# Aggregate the metrics exported by the running workers.
+
+		# Workers only export their metrics when (env)`METRICS_EXPORT` identifies
+		# a directory; an empty mapping is returned otherwise.
+		"""
+
+		directory = os.environ.get('METRICS_EXPORT')
+		if not directory:
+			return {}
+
+		samples = []
+		for sub in list(self.ctl_fork_id_to_subprocess.values()):
+			for pid in sub.sp_processes:
+				try:
+					samples.append(read(os.path.join(directory, str(pid) + '.metrics'))[1])
+				except (OSError, ValueError):
+					# Not yet created or already removed.
+					pass
+
+		return metrics.aggregate(samples)
+
+	def structure(self):
+		p = [
+			('workers', len(self.ctl_fork_id_to_subprocess)),
+			('restarts', sum(self.ctl_restarts.values())),
+			('delayed', sorted(self.ctl_pending)),
+		]
+		p.extend((name, value) for name, (kind, value) in sorted(self.ctl_statistics().items()))
+		return (p, ())
+
 	def xact_exit(self, xact):
 		"""
 		# Called when a fork's exit has been received by the controlling process.
@@ -42,9 +141,14 @@ class ProcessManager(kcore.Context):
 
 		self.ctl_last_exit_status[fid] = (pid, sub.sp_only)
 
-		# Restart Immediately.
 		if fid < self.ctl_concurrency + 1:
-			self.ctl_fork(fid)
+			delay = self.ctl_exit_delay(fid, int(self.system.uptime()))
+			if delay:
+				# Exited shortly after starting; avoid a fork loop.
+				r = self.ctl_pending[fid] = Restart(self, fid)
+				self.system.defer(timetypes.Measure(delay), r)
+			else:
+				self.ctl_restart(fid)
 
 	def xact_void(self, final):
 		if self.terminating:
@@ -61,6 +165,7 @@ class ProcessManager(kcore.Context):
 		##
 
 		# Record forked process.
+		self.ctl_started[fid] = int(self.system.uptime())
 		subprocess = kdispatch.Subprocess(execution.reap, {pid: fid})
 
 		self.ctl_fork_id_to_subprocess[fid] = subprocess
@@ -11,6 +11,7 @@ import functools
 import weakref
 import typing
 import queue
+from time import monotonic_ns
 
 from . import core
 
@@ -103,6 +104,12 @@ class Channel(core.Processor):
 	# /f_downstream/
 		# The &Channel instance that receives events emitted by the instance
 		# holding the attribute.
+
+	# /f_fused_transfer/
+		# The &f_transfer implementation that &f_fuse is equivalent to.
+		# Stateless channels set this along with &f_fuse so that upstreams
+		# can emit directly into a composition of the stage and its downstream.
+		# Subclasses overriding &f_transfer are not fused.
 	"""
 
 	f_type = None
@@ -110,6 +117,43 @@ class Channel(core.Processor):
 	f_monitors = None
 	f_downstream = None
 	f_upstream = None
+	f_fused_transfer = None
+
+	def f_fuse(self, emit):
+		"""
+		# Construct a callable performing &f_transfer with &emit as the recipient.
+		# Implemented by channels that set &f_fused_transfer.
+		"""
+		raise NotImplementedError("channel cannot be fused")
+
+	def f_receiver(self):
+		"""
+		# The callable that upstream channels should emit into.
+		"""
+
+		if self.f_downstream is None or 'f_transfer' in self.__dict__:
+			return self.f_transfer
+
+		cls = self.__class__
+		if cls.f_transfer is not cls.f_fused_transfer:
+			return self.f_transfer
+
+		return self.f_fuse(self.f_emit)
+
+	def _f_propagate(self):
+		# Update the upstream's emitter after the receiver of &self changed.
+		if self.f_fused_transfer is None:
+			return
+
+		ref = self.f_upstream
+		us = ref() if ref is not None else None
+		if us is None or us.f_downstream is not self:
+			return
+		if us.f_emit == us.f_discarding:
+			return
+
+		us.f_emit = self.f_receiver()
+		us._f_propagate()
 
 	def f_connect(self, flow:core.Processor, partial=functools.partial, Ref=weakref.ref):
 		"""
@@ -131,7 +175,10 @@ class Channel(core.Processor):
 		self.f_downstream = flow
 		flow.f_upstream = Ref(self)
 		flow.f_watch(self.f_obstruct, self.f_clear)
-		self.f_emit = flow.f_transfer
+
+		receiver = getattr(flow, 'f_receiver', None)
+		self.f_emit = receiver() if receiver is not None else flow.f_transfer
+		self._f_propagate()
 
 	def f_disconnect(self):
 		"""
@@ -144,6 +191,7 @@ class Channel(core.Processor):
 			flow.f_ignore(self.f_obstruct, self.f_clear)
 			flow.f_upstream = None
 		self.f_emit = self.f_discarding
+		self._f_propagate()
 
 	def f_collapse(self):
 		"""
@@ -217,6 +265,7 @@ class Channel(core.Processor):
 
 		self.f_transfer = self.f_discarding
 		self.f_emit = self.f_discarding
+		self._f_propagate()
 
 		if self.f_downstream:
 			self.f_downstream.f_ignore(self.f_obstruct, self.f_clear)
@@ -228,6 +277,7 @@ class Channel(core.Processor):
 		self.f_transfer = self.f_discarding
 		self.f_emit = self.f_discarding
 		self.f_terminate = self.f_discarding
+		self._f_propagate()
 
 	def f_transfer(self, event):
 		"""
@@ -359,6 +409,15 @@ class Dispatch(Channel):
 	def f_transfer(self, event):
 		self.d_endpoint(event)
 		self.f_emit(event)
+	f_fused_transfer = f_transfer
+
+	def f_fuse(self, emit):
+		endpoint = self.d_endpoint
+
+		def dispatch(event):
+			endpoint(event)
+			emit(event)
+		return dispatch
 
 class Terminal(Channel):
 	"""
@@ -378,72 +437,196 @@ class Terminal(Channel):
 		self._f_terminated()
 		self.t_endpoint(self)
 
-class Monitor(Terminal):
+class Meter(object):
 	"""
-	# Terminal measuring transfer throughput.
+	# Transfer rate meter using a fixed ring of time buckets.
+
+	# Recording adds the units to the current bucket; when time moves into a new bucket,
+	# the buckets passed over are cleared and the completed bucket is folded into
+	# an exponentially weighted average. Memory is constant and reads do not modify
+	# the meter, so the rates can be read from other threads.
+
+	# [ Properties ]
+	# /m_resolution/
+		# The width of a bucket in nanoseconds.
+	# /m_ring/
+		# The units recorded in each bucket.
+	# /m_bucket/
+		# The absolute index of the most recently recorded bucket.
+	# /m_total/
+		# The units recorded over the lifetime of the meter.
+	# /m_start/
+		# The time of the first record; &None if nothing has been recorded.
+	# /m_last/
+		# The time of the most recent record.
+	# /m_average/
+		# Exponentially weighted units per second as of the completion of
+		# the bucket preceding &m_bucket.
 	"""
 
-	def actuate(self):
-		# XXX: Use system transaction context for monotonic clock.
-		from ..time import system as time
-		self.tm_clockread = time.elapsed
+	__slots__ = (
+		'm_clock', 'm_resolution', 'm_decay',
+		'm_ring', 'm_bucket', 'm_total', 'm_start', 'm_last', 'm_average',
+	)
 
-		self.tm_measure = (lambda x: sum(map(len, x)))
-		self.tm_reference = self.tm_clockread()
-		self.tm_transfers = [(0, self.tm_reference)]
-		self.tm_aggregate = (0, self.tm_reference.__class__(0)) # units, time before &t_reference
+	def __init__(self, buckets=16, resolution=250000000, halflife=2000000000, clock=monotonic_ns):
+		"""
+		# [ Parameters ]
+		# /buckets/
+			# The number of buckets in the ring; the maximum window is
+			# `buckets * resolution`.
+		# /resolution/
+			# The width of the buckets in nanoseconds.
+		# /halflife/
+			# The time, in nanoseconds, for a past rate to lose half of its weight
+			# in &m_average.
+		# /clock/
+			# Monotonic clock returning nanoseconds.
+		"""
+
+		self.m_clock = clock
+		self.m_resolution = resolution
+		self.m_decay = 0.5 ** (resolution / halflife)
+		self.m_ring = [0] * buckets
+		self.m_bucket = 0
+		self.m_total = 0
+		self.m_start = None
+		self.m_last = None
+		self.m_average = 0.0
+
+	def m_record(self, units:int, now=None):
+		"""
+		# Add &units to the bucket of the current time.
+		"""
+
+		if now is None:
+			now = self.m_clock()
+
+		b = now // self.m_resolution
+		ring = self.m_ring
+
+		if self.m_start is None:
+			self.m_start = now
+			self.m_bucket = b
+		elif b != self.m_bucket:
+			current = self.m_bucket
+			n = len(ring)
+
+			# Fold the completed bucket and decay across the empty ones.
+			rate = ring[current % n] * (1000000000 / self.m_resolution)
+			decay = self.m_decay
+			avg = self.m_average * decay + rate * (1.0 - decay)
+			if b - current > 1:
+				avg *= decay ** (b - current - 1)
+			self.m_average = avg
+
+			for i in range(current + 1, current + 1 + min(b - current, n)):
+				ring[i % n] = 0
+			self.m_bucket = b
+
+		ring[b % len(ring)] += units
+		self.m_total += units
+		self.m_last = now
+
+	def m_rate(self, window=None, now=None) -> float:
+		"""
+		# Units per second over the most recent &window nanoseconds; defaults to,
+		# and is limited by, the span of the ring.
+		"""
+
+		if self.m_start is None:
+			return 0.0
+		if now is None:
+			now = self.m_clock()
+
+		res = self.m_resolution
+		ring = self.m_ring
+		n = len(ring)
+		if window is None:
+			count = n
+		else:
+			count = max(1, min(n, -(-window // res)))
 
-	def f_transfer(self, event):
-		units = self.tm_measure(event)
-		self.tm_transfers.append((units, self.tm_clockread()))
+		b = now // res
+		first = b - count + 1
+		latest = self.m_bucket
+		units = sum(ring[i % n] for i in range(max(first, latest - n + 1), latest + 1))
 
-	@property
-	def tm_start(self):
-		return self.tm_reference.decrease(self.tm_aggregate[-1])
+		# Partial current bucket and a ring not yet filled.
+		span = (count - 1) * res + (now % res)
+		span = min(span, now - self.m_start)
+		if span <= 0:
+			return float(units)
+
+		return units * (1000000000 / span)
 
-	def tm_archive(self, pit):
+	def m_overall(self) -> float:
 		"""
-		# Archive transfer data occurring before &pit.
+		# Units per second between the first and most recent record.
 		"""
-		u_total = self.tm_aggregate
 
-		i = 0
-		# XXX: bisect for &pit
-		for u, t in reversed(self.tm_transfers):
-			if t < pit:
-				break
-			i += 1
+		if self.m_start is None:
+			return 0.0
+
+		span = self.m_last - self.m_start
+		if span <= 0:
+			return float(self.m_total)
+		return self.m_total * (1000000000 / span)
+
+def _measure(event, sum=sum, map=map, len=len):
+	# Bytes in a sequence of buffers, or one for other events.
+	try:
+		return sum(map(len, event))
+	except TypeError:
+		return 1
 
-		offset = len(self.tm_transfers) - i
-		prefix = self.tm_transfers[:offset]
-		del self.tm_transfers[:offset]
+class Metering(Channel):
+	"""
+	# Transparent channel recording the transferred units in a &Meter.
 
-		# Archive prefix into tm_aggregate.
-		if prefix:
-			t_last = self.tm_reference
-			u_total, t_total = self.tm_aggregate
+	# [ Properties ]
+	# /mt_meter/
+		# The &Meter updated by the transfers.
+	# /mt_measure/
+		# Callable identifying the units of a transfer.
+	"""
 
-			for u, t in prefix:
-				u_total += u
-				t_total = t_total.elapse(t.__class__(t - t_last))
-				t_last = t
+	f_type = 'transformer'
 
-			self.tm_aggregate = (u_total, t_total)
-			self.tm_reference = prefix[-1][-1]
+	def __init__(self, meter=None, measure=_measure):
+		self.mt_meter = meter if meter is not None else Meter()
+		self.mt_measure = measure
 
-	def tm_rate(self, window):
-		pit = self.tm_clockread()
-		area = pit.decrease(window)
-		self.tm_archive(area)
-		suffix = self.tm_transfers
+	def f_transfer(self, event):
+		self.mt_meter.m_record(self.mt_measure(event))
+		self.f_emit(event)
+	f_fused_transfer = f_transfer
 
-		if not suffix or pit.decrease(suffix[-1][-1]).select('second') >= 1:
-			suffix.append((0, pit))
+	def f_fuse(self, emit):
+		record = self.mt_meter.m_record
+		measure = self.mt_measure
 
-		latest = suffix[-1][-1]
-		t_total = latest.__class__(latest - self.tm_reference)
+		def transfer(event):
+			record(measure(event))
+			emit(event)
+		return transfer
 
-		return sum(x[0] for x in suffix), t_total
+class Monitor(Terminal):
+	"""
+	# Terminal measuring transfer throughput.
+
+	# [ Properties ]
+	# /tm_meter/
+		# The &Meter updated by the transfers.
+	"""
+
+	def __init__(self, endpoint, meter=None):
+		super().__init__(endpoint)
+		self.tm_meter = meter if meter is not None else Meter()
+
+	def f_transfer(self, event, measure=_measure):
+		self.tm_meter.m_record(measure(event))
+		self.f_emit(event)
 
 class Relay(Channel):
 	"""
@@ -461,6 +644,15 @@ class Relay(Channel):
 	def f_transfer(self, event):
 		self.r_emit(event)
 		self.f_emit(event)
+	f_fused_transfer = f_transfer
+
+	def f_fuse(self, emit):
+		relay = self.r_emit
+
+		def transfer(event):
+			relay(event)
+			emit(event)
+		return transfer
 
 	def f_terminate(self):
 		self.r_integral.int_terminate(self.r_key)
@@ -512,6 +704,11 @@ class Transformation(Channel):
 
 	def f_transfer(self, event):
 		self.f_emit(self.tf_transform(event))
+	f_fused_transfer = f_transfer
+
+	def f_fuse(self, emit):
+		transform = self.tf_transform
+		return (lambda event: emit(transform(event)))
 
 class Iteration(Channel):
 	"""
@@ -694,8 +891,16 @@ class Parallel(Channel):
 class Protocol(Channel):
 	"""
 	# Protocol class for containing the state of a protocol layer.
+
+	# [ Properties ]
+	# /p_sequenced/
+		# Whether the channels joined into the protocol must be delivered in order.
+		# &False for protocols that multiplex channels causing the &Catenation
+		# connected by &.io.Transport.tp_connect to interleave them.
 	"""
 
+	p_sequenced = True
+
 	def __init__(self, shared, local, transfer):
 		self.p_shared = shared
 		self.p_local = local
@@ -747,9 +952,32 @@ class Catenation(Channel):
 		# queue, &Layer, and termination state.
 	# /cat_flows/
 		# Channel identifier associated with weak reference to upstream.
+	# /cat_sequenced/
+		# Whether flows are carried in order; &False after &cat_interleave.
+
+	# /cat_queue_limit/
+		# The number of transfers a waiting flow may queue before being obstructed.
+	# /cat_channel_limit/
+		# The number of bytes a waiting flow may queue before being obstructed.
+	# /cat_limit/
+		# The number of bytes that all waiting flows may queue before any
+		# flow adding to its queue is obstructed.
+	# /cat_queued/
+		# Mapping of channel identifiers to the number of bytes in their queue.
+	# /cat_queued_total/
+		# The sum of &cat_queued.
+	# /cat_high_water/
+		# The largest &cat_queued_total observed.
+	# /cat_obstructed_count/
+		# The number of times an upstream was obstructed by a queue limit.
 	"""
 
 	f_type = 'join'
+	cat_sequenced = True
+
+	cat_queue_limit = 8
+	cat_channel_limit = 1024 * 256
+	cat_limit = 1024 * 1024 * 4
 
 	def __init__(self, Queue=collections.deque):
 		self.cat_order = Queue() # order of flows deciding next in line
@@ -758,9 +986,17 @@ class Catenation(Channel):
 		self.cat_flows = dict() # Channel-Id -> Flow Reference
 		self.cat_events = [] # event aggregator
 
+		self.cat_queued = dict() # Channel-Id -> Queued bytes
+		self.cat_queued_total = 0
+		self.cat_high_water = 0
+		self.cat_obstructed_count = 0
+
+	# The number of bytes held by a transfer.
+	cat_measure = staticmethod(_measure)
+
 	def cat_overflowing(self, channel_id):
 		"""
-		# Whether the given flow's queue has too many items.
+		# Whether the given flow's queue has exceeded a limit.
 		"""
 
 		q = self.cat_connections[channel_id][0]
@@ -768,17 +1004,34 @@ class Catenation(Channel):
 		if q is None:
 			# front flow does not have a queue
 			return False
-		elif len(q) > 8:
+		elif len(q) > self.cat_queue_limit:
+			return True
+		elif self.cat_queued.get(channel_id, 0) > self.cat_channel_limit:
+			return True
+		elif self.cat_queued_total > self.cat_limit:
 			return True
 		else:
 			return False
 
+	def _cat_dequeued(self, channel_id):
+		# Release the accounting of a queue that was drained or discarded.
+		self.cat_queued_total -= self.cat_queued.pop(channel_id, 0)
+
+	def structure(self):
+		p, sr = super().structure()
+		p.extend([
+			('cat_queued_total', self.cat_queued_total),
+			('cat_high_water', self.cat_high_water),
+			('cat_obstructed_count', self.cat_obstructed_count),
+		])
+		return (p, sr)
+
 	def int_transfer(self, channel_id, events, fc_xfer=fe_transfer):
 		"""
 		# Emit point for Sequenced Flows
 		"""
 
-		if channel_id == self.cat_order[0]:
+		if not self.cat_sequenced or channel_id == self.cat_order[0]:
 			if not self.cat_events:
 				# Only enqueue if there hasn't been an enqueue.
 				self.enqueue(self.cat_flush)
@@ -789,8 +1042,16 @@ class Catenation(Channel):
 
 			if q is not None:
 				q.append(events)
+
+				size = self.cat_measure(events)
+				self.cat_queued[channel_id] = self.cat_queued.get(channel_id, 0) + size
+				self.cat_queued_total += size
+				if self.cat_queued_total > self.cat_high_water:
+					self.cat_high_water = self.cat_queued_total
+
 				us = upstream()
 				if not us.f_obstructed and self.cat_overflowing(channel_id):
+					self.cat_obstructed_count += 1
 					us.f_obstruct(self, None, core.Condition(self, ('cat_overflowing',), channel_id))
 			else:
 				raise Exception("flow has not been connected")
@@ -806,7 +1067,7 @@ class Catenation(Channel):
 		else:
 			flowref = (lambda: None)
 
-		if self.cat_order[0] == channel_id:
+		if not self.cat_sequenced or self.cat_order[0] == channel_id:
 			# HoL connect, emit open.
 			if flow is not None:
 				self.cat_connections[channel_id] = (None, initiate, None, flowref)
@@ -818,7 +1079,10 @@ class Catenation(Channel):
 				self.enqueue(self.cat_flush)
 			self.cat_events.append((fc_init, channel_id, initiate))
 			if flow is None:
-				self.cat_transition()
+				if self.cat_sequenced:
+					self.cat_transition()
+				else:
+					self.cat_release(channel_id)
 		else:
 			# Not head of line, enqueue events iff flow is not None.
 			self.cat_flows[channel_id] = flowref
@@ -847,7 +1111,9 @@ class Catenation(Channel):
 
 	def int_terminate(self, channel_id, parameter=None):
 
-		if channel_id == self.cat_order[0]:
+		if not self.cat_sequenced:
+			self.cat_release(channel_id)
+		elif channel_id == self.cat_order[0]:
 			# Head of line.
 			self.cat_transition()
 			# assert initiate != self.cat_order[0]
@@ -903,6 +1169,7 @@ class Catenation(Channel):
 		pop = q.popleft
 		while q:
 			add((fc_xfer, channel_id, pop()))
+		self._cat_dequeued(channel_id)
 
 		if term is None:
 			self.cat_connections[channel_id] = (None, l, term, fr)
@@ -940,6 +1207,65 @@ class Catenation(Channel):
 				# Connected, drain and clear any obstructions.
 				self.enqueue(self.cat_drain)
 
+	def cat_release(self, channel_id, fc_terminate=fe_terminate):
+		"""
+		# Remove the channel emitting its termination.
+		# The interleaved counterpart of &cat_transition.
+		"""
+
+		self.cat_order.remove(channel_id)
+		self.cat_flows.pop(channel_id, None)
+		self.cat_connections.pop(channel_id, None)
+		self._cat_dequeued(channel_id)
+
+		if not self.cat_events:
+			self.enqueue(self.cat_flush)
+		self.cat_events.append((fc_terminate, channel_id, None))
+
+	def cat_interleave(self, fc_init=fe_initiate, fc_xfer=fe_transfer):
+		"""
+		# Cease sequencing the flows. Connected flows waiting for the head of line
+		# are drained and subsequent events are emitted as they are received.
+
+		# Used by protocols that multiplex channels, HTTP/2 for instance.
+		"""
+
+		if not self.cat_sequenced:
+			return
+		self.cat_sequenced = False
+
+		if not self.cat_order:
+			return
+
+		head = self.cat_order[0]
+		for channel_id in list(self.cat_order):
+			if channel_id == head or channel_id not in self.cat_flows:
+				# Active or only reserved.
+				continue
+
+			if channel_id not in self.cat_connections:
+				# Initiate only connect; the initiate was not retained.
+				self.cat_release(channel_id)
+				continue
+
+			q, l, term, fr = self.cat_connections[channel_id]
+			if not self.cat_events:
+				self.enqueue(self.cat_flush)
+
+			add = self.cat_events.append
+			add((fc_init, channel_id, l))
+			while q:
+				add((fc_xfer, channel_id, q.popleft()))
+			self._cat_dequeued(channel_id)
+
+			if term is None:
+				self.cat_connections[channel_id] = (None, l, term, fr)
+				f = fr()
+				if f is not None:
+					f.f_clear(self)
+			else:
+				self.cat_release(channel_id)
+
 class Division(Channel):
 	"""
 	# Coordination of the routing of a protocol's content.
@@ -273,7 +273,10 @@ class Transport(core.Context):
 			end.append(sc)
 			start.append(rc)
 
-		end.append(flows.Catenation())
+		cat = flows.Catenation()
+		if not getattr(protocol[1][1], 'p_sequenced', True):
+			cat.cat_interleave()
+		end.append(cat)
 		end.reverse()
 		self.tp_output = o = Output.create(Transfer())
 		self.xact_dispatch(o)
@@ -4,6 +4,7 @@
 
 import os
 import sys
+import stat
 import functools
 import collections
 import contextlib
@@ -24,6 +25,8 @@ from ..system import io
 from ..system import process
 from ..system import thread
 from ..system import memory
+from ..system import metrics
+from ..system import sampling
 from ..system import execution
 
 from ..time import system as time
@@ -713,6 +716,369 @@ class KOutput(KChannel):
 		# Note termination signalled.
 		return True
 
+def _kf_write(fd, buffers, position, pwritev=os.pwritev, writev=os.writev):
+	# Performed by a worker thread; write all &buffers handling partial writes.
+	views = [memoryview(x) for x in buffers]
+	written = 0
+
+	while views:
+		if position is None:
+			n = writev(fd, views)
+		else:
+			n = pwritev(fd, views, position + written)
+		written += n
+
+		while views and n >= len(views[0]):
+			n -= len(views[0])
+			del views[0]
+		if n:
+			views[0] = views[0][n:]
+
+	return written
+
+class KFile(flows.Channel):
+	"""
+	# Channel performing positional transfers to or from a regular file.
+
+	# Regular files are always ready according to the system's event interfaces,
+	# so the transfers are performed by the process's worker pool and
+	# completed in the task queue rather than by an &io.Array.
+
+	# [ Properties ]
+	# /kf_fd/
+		# The file descriptor; &None once the channel terminates or is interrupted.
+	# /kf_position/
+		# The offset of the next transfer; &None when appending.
+	# /kf_pending/
+		# Whether a transfer is being performed by a worker.
+	# /kf_release/
+		# The descriptor of a closed channel whose transfer is still pending.
+		# Closed by the completion so that the worker cannot use a reused number.
+	"""
+
+	kf_pending = False
+	kf_release = None
+
+	def __init__(self, fd, position):
+		self.kf_fd = fd
+		self.kf_position = position
+
+	def kf_close(self):
+		fd = self.kf_fd
+		if fd is not None:
+			self.kf_fd = None
+			if self.kf_pending:
+				self.kf_release = fd
+			else:
+				os.close(fd)
+
+	def kf_settle(self):
+		"""
+		# Note that the pending transfer finished and close the descriptor
+		# if the channel was closed while it was performed.
+		"""
+
+		self.kf_pending = False
+		fd = self.kf_release
+		if fd is not None:
+			self.kf_release = None
+			os.close(fd)
+
+	def kf_failed(self, exception):
+		"""
+		# Completion of a transfer that raised; closes the descriptor and faults the channel.
+		"""
+
+		self.kf_settle()
+		self.kf_close()
+		self.fault(exception)
+
+	def _f_terminated(self):
+		self.kf_close()
+		super()._f_terminated()
+
+	def interrupt(self):
+		self.kf_close()
+		super().interrupt()
+
+	def structure(self):
+		p = [
+			('fd', self.kf_fd),
+			('position', self.kf_position),
+			('pending', self.kf_pending),
+		]
+		return (p, ())
+
+class KFileInput(KFile):
+	"""
+	# Read a range of a regular file using positional reads.
+
+	# [ Properties ]
+	# /kf_stop/
+		# The offset at which reading stops.
+	# /kf_read_size/
+		# The size of the reads performed.
+	# /kf_readahead/
+		# The number of bytes beyond the current read that the system is advised
+		# to prefetch; zero disables the hints.
+	"""
+
+	kf_read_size = 1024 * 64
+	kf_readahead = 1024 * 256
+
+	def __init__(self, fd, start, stop, readahead=None):
+		super().__init__(fd, start)
+		self.kf_stop = stop
+		if readahead is not None:
+			self.kf_readahead = readahead
+
+	def kf_advise(self, offset, size, advice):
+		try:
+			os.posix_fadvise(self.kf_fd, offset, size, advice)
+		except (AttributeError, OSError):
+			# Hints are not available on all systems.
+			pass
+
+	def actuate(self):
+		super().actuate()
+		if self.kf_readahead:
+			size = self.kf_stop - self.kf_position
+			self.kf_advise(self.kf_position, size, getattr(os, 'POSIX_FADV_SEQUENTIAL', 0))
+		self.kf_transition()
+
+	def kf_transition(self, pread=os.pread):
+		"""
+		# Submit the next read unless one is pending or the flow is obstructed.
+		"""
+
+		if self.kf_pending or self.f_obstructed or self.kf_fd is None:
+			return
+
+		position = self.kf_position
+		size = min(self.kf_read_size, self.kf_stop - position)
+		if size <= 0:
+			self._f_terminated()
+			return
+
+		if self.kf_readahead:
+			# Prefetch the window following this read.
+			start = position + size
+			window = min(self.kf_readahead, self.kf_stop - start)
+			if window > 0:
+				self.kf_advise(start, window, getattr(os, 'POSIX_FADV_WILLNEED', 0))
+
+		self.kf_pending = True
+		self.system.submit(self, self.kf_complete, pread, self.kf_fd, size, position,
+			failure=self.kf_failed)
+
+	def kf_complete(self, data):
+		self.kf_settle()
+		if self.kf_fd is None:
+			# Interrupted or terminated while the read was performed.
+			return
+
+		if not data:
+			# Truncated after the range was selected.
+			self._f_terminated()
+			return
+
+		self.kf_position += len(data)
+		self.f_emit((data,))
+		self.kf_transition()
+
+	def f_clear(self, obstruction):
+		if super().f_clear(obstruction):
+			self.kf_transition()
+
+	def f_transfer(self, event, source=None):
+		"""
+		# Normally ignored, but will induce a transition if no read is pending.
+		"""
+		self.kf_transition()
+
+class KFileOutput(KFile):
+	"""
+	# Write the transferred buffers to a regular file using positional writes.
+	# When the position is &None, the buffers are written at the end of the file.
+
+	# [ Properties ]
+	# /kf_queue/
+		# The buffers waiting to be written.
+	# /kf_limit/
+		# The number of queued buffers that causes the flow to be obstructed.
+	# /kf_batch/
+		# The maximum number of buffers given to a single write.
+	"""
+
+	kf_limit = 16
+	kf_batch = 64
+
+	@property
+	def kf_overflow(self):
+		"""
+		# Queue entries exceeds limit.
+		"""
+		return len(self.kf_queue) > self.kf_limit
+
+	@property
+	def f_empty(self):
+		return not self.kf_queue and not self.kf_pending
+
+	def __init__(self, fd, position=None, Queue=collections.deque):
+		super().__init__(fd, position)
+		self.kf_queue = Queue()
+
+	def kf_transition(self):
+		q = self.kf_queue
+		if not q:
+			self.f_clear(self)
+			if self.terminating:
+				self._f_terminated()
+			return
+
+		batch = [q.popleft() for x in range(min(len(q), self.kf_batch))]
+		self.kf_pending = True
+		self.system.submit(self, self.kf_complete, _kf_write, self.kf_fd, batch, self.kf_position,
+			failure=self.kf_failed)
+
+	def kf_complete(self, written):
+		self.kf_settle()
+		if self.kf_fd is None:
+			return
+
+		if self.kf_position is not None:
+			self.kf_position += written
+		self.kf_transition()
+
+	def f_transfer(self, event, source=None):
+		"""
+		# Enqueue a sequence of buffers to be written.
+		"""
+
+		self.kf_queue.extend(event)
+
+		if not self.kf_pending:
+			self.kf_transition()
+		elif len(self.kf_queue) > self.kf_limit:
+			self.f_obstruct(self, None,
+				core.Condition(self, ('kf_overflow',))
+			)
+
+	def f_terminate(self):
+		if self.terminating:
+			return False
+
+		self.start_termination()
+
+		if self.f_empty:
+			self._f_terminated()
+
+		return True
+
+class Deferrals(object):
+	"""
+	# Processors waiting for a period to elapse, grouped by expiration slot.
+
+	# Expirations are rounded up to a multiple of the slack so that processors
+	# expiring within the same window share a single wakeup. The heap holds
+	# one entry per slot rather than one per processor and each processor
+	# is indexed by its slot, so deferring and cancelling do not scan.
+
+	# A processor has at most one pending deferral; deferring it again replaces
+	# the previous expiration. Processors are weakly referenced.
+
+	# [ Properties ]
+	# /d_slack/
+		# The width of the slots in nanoseconds.
+	# /d_slots/
+		# Mapping of slot numbers to the set of processors expiring within them.
+	# /d_index/
+		# Mapping of processors to the slot that they are currently in.
+	# /d_heap/
+		# Heap of the slot numbers present in &d_slots.
+	"""
+
+	def __init__(self, slack=1000000):
+		self.d_slack = max(1, int(slack))
+		self.d_slots = {}
+		self.d_index = weakref.WeakKeyDictionary()
+		self.d_heap = []
+
+	def __len__(self):
+		return len(self.d_index)
+
+	def put(self, deadline:int, processor, push=heapq.heappush, WeakSet=weakref.WeakSet) -> int:
+		"""
+		# Defer &processor until &deadline; returns the slot that it was placed in.
+		"""
+
+		slot = -(-deadline // self.d_slack)
+		previous = self.d_index.get(processor)
+		if previous == slot:
+			return slot
+		elif previous is not None:
+			self.d_slots[previous].discard(processor)
+
+		self.d_index[processor] = slot
+		try:
+			self.d_slots[slot].add(processor)
+		except KeyError:
+			self.d_slots[slot] = WeakSet((processor,))
+			push(self.d_heap, slot)
+
+		return slot
+
+	def discard(self, processor) -> bool:
+		"""
+		# Remove the pending deferral of &processor.
+		"""
+
+		slot = self.d_index.pop(processor, None)
+		if slot is None:
+			return False
+
+		self.d_slots[slot].discard(processor)
+		return True
+
+	def next(self, pop=heapq.heappop):
+		"""
+		# The time, in nanoseconds, at which the earliest occupied slot expires;
+		# &None when nothing is deferred.
+		"""
+
+		heap = self.d_heap
+		slots = self.d_slots
+
+		while heap:
+			slot = heap[0]
+			if slots[slot]:
+				return slot * self.d_slack
+
+			# Emptied by cancellations.
+			pop(heap)
+			del slots[slot]
+
+		return None
+
+	def get(self, current:int, pop=heapq.heappop) -> list:
+		"""
+		# Remove and return the processors whose slots expired at or before &current.
+		"""
+
+		events = []
+		heap = self.d_heap
+		slots = self.d_slots
+		index = self.d_index
+		limit = current // self.d_slack
+
+		while heap and heap[0] <= limit:
+			slot = pop(heap)
+			for x in slots.pop(slot):
+				del index[x]
+				events.append(x)
+
+		return events
+
 class Context(core.Context):
 	"""
 	# System Transaction Context implementation providing
@@ -770,117 +1136,80 @@ class Context(core.Context):
 		self.executables = weakref.WeakValueDictionary()
 		self.attachments = []
 		# Scheduler
-		self._defer_heap = []
-		self._defer_tasks = collections.defaultdict(weakref.WeakSet)
-		self._defer_cancelled = weakref.WeakSet()
+		self._defer_set = Deferrals(self.defer_slack)
 
 	uptime = staticmethod(time.elapsed)
 	time = staticmethod(time.utc)
 
 	_defer_reference = None
+	_defer_time = None
+
+	# Width of the windows in which deferred processors are coalesced into one wakeup.
+	defer_slack = 1000000
 
 	def _defer_execute(self, link=None):
 		"""
 		# Execute all tasks whose wait period has elapsed according to the system's clock.
 		"""
 
+		self._defer_reference = None
+		self._defer_time = None
+
 		if self.terminated or self.interrupted:
 			# Do nothing if not inside the functioning window.
 			return
 
-		snapshot = self.uptime()
-
-		events = self._defer_get(snapshot)
-		for overflow, processor in events:
-			if self in self._defer_cancelled:
-				self._defer_cancelled.discard(self)
-			else:
-				try:
-					processor.occur()
-				except BaseException as scheduled_task_exception:
-					raise
-		else:
-			p = self._defer_period(snapshot)
+		events = self._defer_set.get(int(self.uptime()))
+		try:
+			for processor in events:
+				processor.occur()
+		finally:
+			self._defer_update(self.uptime())
 
-			try:
-				self._defer_reference = None
-				if p is not None:
-					# re-schedule the transition
-					self._defer_update(snapshot)
-			except BaseException as scheduling_exception:
-				raise
+			m = self.process.metrics
+			m.counter('kernel.deferred.executed').increment(len(events))
+			m.gauge('kernel.deferred').set(len(self._defer_set))
 
 	def defer(self, measure, *processors):
 		"""
 		# Defer the execution of the (id)`occur` methods on the given &processors
 		# by the given &measure.
+
+		# Processors already deferred are rescheduled; expirations within
+		# &defer_slack of each other are performed by the same wakeup.
 		"""
 
 		snapshot = self.uptime()
-		p = self._defer_period(snapshot)
+		deadline = int(snapshot) + int(measure)
+		put = self._defer_set.put
 
-		self._defer_put(snapshot, measure, processors)
+		for x in processors:
+			put(deadline, x)
 
-		if p is None:
+		t = self._defer_time
+		if t is None or self._defer_set.next() < t:
 			self._defer_update(snapshot)
-		else:
-			np = self._defer_period(snapshot)
-			if np < p:
-				self._defer_update(snapshot)
 
 	def cancel(self, processor):
-		# Currently, this is somewhat automatic (weakset).
-		self._defer_cancelled.add(processor)
+		"""
+		# Remove the pending deferral of &processor, if any.
+		"""
+		self._defer_set.discard(processor)
 
 	def _defer_update(self, snapshot):
 		# Update the scheduled transition callback.
-		nr = weak.Method(self._defer_execute)
 		if self._defer_reference is not None:
 			self._cancel(self._defer_reference)
+			self._defer_reference = None
+			self._defer_time = None
 
-		self._defer_reference = self._recur(self._defer_period(snapshot), nr.zero, cyclic=False)
-
-	def _defer_period(self, current):
-		# The period before the next event should occur.
-		try:
-			smallest = self._defer_heap[0]
-			return smallest.__class__(smallest - current)
-		except IndexError:
-			return None
-
-	def _defer_put(self, current, measure, processors, push=heapq.heappush) -> int:
-		# Schedules the given events for execution.
-		pit = measure.__class__(measure + current)
-		push(self._defer_heap, pit)
-		self._defer_tasks[pit].update(processors)
-
-	def _defer_get(self, current, pop=heapq.heappop, push=heapq.heappush):
-		# Return all events whose sheduled delay has elapsed beyond &current.
-		events = []
-
-		while self._defer_heap:
-			# repeat some work in case of concurrent pop
-			item = pop(self._defer_heap)
-			overflow = item.__class__(current - item)
-
-			# the set of callbacks have passed their time.
-			if overflow < 0:
-				# not ready; put it back
-				push(self._defer_heap, item)
-				break
-			else:
-				# If an identical item has already been popped,
-				# an empty set can be returned in order to perform a no-op.
-				eventq = self._defer_tasks.pop(item, ())
-				for x in eventq:
-					if x in self._defer_cancelled:
-						# filter any cancellations
-						# schedule is already popped, so remove event and cancel*
-						self._defer_cancelled.discard(x)
-					else:
-						events.append((overflow, x))
+		t = self._defer_set.next()
+		if t is None:
+			return
 
-		return events
+		nr = weak.Method(self._defer_execute)
+		self._defer_time = t
+		self._defer_reference = self._recur(snapshot.__class__(max(0, t - snapshot)), nr.zero, cyclic=False)
 
 	def structure(self):
 		proc = self.process
@@ -889,6 +1218,8 @@ class Context(core.Context):
 		p = [
 			('tasks', proc.executed_task_count),
 			('threads', len(proc.fabric.threading)),
+			('workers', len(proc.fabric.workers)),
+			('deferred', len(self._defer_set)),
 
 			# Track basic (task loop) cycle stats.
 			('cycles', proc.cycle_count),
@@ -992,6 +1323,25 @@ class Context(core.Context):
 
 		return self.process.fabric.execute(controller, function, *parameters)
 
+	def submit(self, controller, completion, function, *parameters, failure=None):
+		"""
+		# Execute the given function in a worker thread of the process's pool and
+		# enqueue &completion with its result. Used for short-lived operations;
+		# long-lived loops should use &execute.
+
+		# When the function raises, &failure is enqueued with the exception;
+		# without a &failure, the exception faults &controller.
+		"""
+
+		return self.process.fabric.submit(controller, completion, function, *parameters, failure=failure)
+
+	@property
+	def metrics(self) -> metrics.Registry:
+		"""
+		# The metrics registry of the process.
+		"""
+		return self.process.metrics
+
 	def environ(self, identifier, default=None):
 		"""
 		# Access the environment from the perspective of the context.
@@ -1051,15 +1401,37 @@ class Context(core.Context):
 		i, o = io.alloc_octets(fd)
 		return i.port, (KInput(i), KOutput(o))
 
-	def read_file(self, path):
+	def _file_status(self, fd):
+		# Status of a newly opened descriptor; closes &fd when it fails.
+		try:
+			return os.fstat(fd)
+		except:
+			os.close(fd)
+			raise
+
+	def _file_output(self, fd, position):
+		# Positional writes are only used for regular files; pipes, devices,
+		# and sockets are written when the system's event interfaces report readiness.
+		if stat.S_ISREG(self._file_status(fd).st_mode):
+			return KFileOutput(fd, position)
+
+		return KOutput(io.alloc_output(fd))
+
+	def read_file(self, path, readahead=None):
 		"""
 		# Construct a channel for reading an entire file from the filesystem.
-		# The returned channel terminates when EOF occurs; often,
+		# The size of a regular file is identified when the channel is created; often,
 		# &read_file_range is preferrable to avoid status inconsistencies.
+		# Other files, such as pipes and devices, are read until EOF.
 		"""
 
 		fd = os.open(path, os.O_RDONLY)
-		return KInput(io.alloc_input(fd))
+		st = self._file_status(fd)
+
+		if not stat.S_ISREG(st.st_mode):
+			return KInput(io.alloc_input(fd))
+
+		return KFileInput(fd, 0, st.st_size, readahead=readahead)
 
 	def write_file(self, path, *, mode=os.O_WRONLY):
 		"""
@@ -1067,37 +1439,42 @@ class Context(core.Context):
 		"""
 
 		fd = os.open(path, mode)
-		return KOutput(io.alloc_output(fd))
+		return self._file_output(fd, None if mode & os.O_APPEND else 0)
 
-	def read_file_range(self, path, start, stop,
-			open=os.open, seek=os.lseek, close=os.close,
-		):
+	def read_file_range(self, path, start, stop, readahead=None):
 		"""
 		# Construct a channel to read a specific range of a file.
+
+		# [ Parameters ]
+		# /readahead/
+			# The number of bytes that the system is advised to prefetch
+			# beyond each read; zero disables the hints.
 		"""
 
 		size = stop - start
 		if size < 0:
 			raise ValueError("start exceeds stop")
 
-		fd = open(path, os.O_RDONLY)
+		fd = os.open(path, os.O_RDONLY)
+		if stat.S_ISREG(self._file_status(fd).st_mode):
+			return KFileInput(fd, start, stop, readahead=readahead)
 
 		try:
 			if start:
-				seek(fd, start, 0)
+				os.lseek(fd, start, 0)
 
 			return KLimit(io.alloc_input(fd)).k_set_limit(size)
 		except:
-			close(fd)
+			os.close(fd)
 			raise
 
 	def append_file(self, path):
 		"""
-		# Open a set of files for appending through a &.library.KernelPort.
+		# Construct a channel for appending to the file identified by &path.
 		"""
 
 		fd = os.open(path, os.O_WRONLY|os.O_APPEND|os.O_CREAT)
-		return KOutput(io.alloc_output(fd))
+		return self._file_output(fd, None)
 
 	def update_file(self, path, offset, size):
 		"""
@@ -1105,11 +1482,8 @@ class Context(core.Context):
 		# the designated file.
 		"""
 
-		fd = os.open(path, os.O_WRONLY|os.O_APPEND|os.O_CREAT)
-		position = os.lseek(fd, 0, offset)
-		t = io.alloc_output(fd)
-
-		return KOutput(t)
+		fd = os.open(path, os.O_WRONLY|os.O_CREAT)
+		return self._file_output(fd, offset)
 
 	def listen(self, interfaces):
 		"""
@@ -1234,6 +1608,8 @@ class Context(core.Context):
 		"""
 
 		segs = Segments.open(path)
+		if range is not None:
+			segs = segs.select(*range)
 		return flows.Iteration((x,) for x in segs)
 
 	def coprocess(self, identifier, exit, invocation, application):
@@ -1245,11 +1621,43 @@ class Context(core.Context):
 class Fabric(object):
 	"""
 	# Thread manager for processes; thread pool with capacity to manage dedicated threads.
+
+	# Dedicated threads are created by &execute and &critical, and should be reserved
+	# for long-lived loops. Short-lived callables are given to &submit and executed by
+	# a bounded set of worker threads. Each worker takes from its own queue and steals
+	# from the queues of the other workers when its own is empty.
+
+	# [ Properties ]
+	# /threading/
+		# The dedicated threads indexed by their identifier.
+	# /workers/
+		# The queues of the worker threads indexed by their identifier.
+	# /worker_limit/
+		# The maximum number of worker threads.
+	# /accounting/
+		# Mapping of controllers to the number of their submitted callables
+		# that have not completed.
 	"""
 
-	def __init__(self, process, proxy=weakref.proxy):
+	worker_limit = min(32, (os.cpu_count() or 1) + 4)
+
+	def __init__(self, process, workers=None, proxy=weakref.proxy):
 		self.process = proxy(process) # report unhandled thread exceptions
 		self.threading = dict() # dedicated purpose threads
+		if workers is not None:
+			self.worker_limit = workers
+		self._init_pool()
+
+	def _init_pool(self):
+		self.workers = dict()
+		self.accounting = weakref.WeakKeyDictionary()
+		self._queues = []
+		self._idle = 0
+		self._cursor = 0
+		self._available = thread.amutex()
+		self._available.acquire()
+		self._tasks = 0
+		self._state = thread.amutex()
 
 	def void(self):
 		"""
@@ -1257,6 +1665,7 @@ class Fabric(object):
 		"""
 
 		self.threading.clear()
+		self._init_pool()
 
 	def execute(self, controller, callable, *args):
 		"""
@@ -1285,6 +1694,113 @@ class Fabric(object):
 		tid = create_thread(self.thread, (controller, (callable, args)))
 		return tid
 
+	def submit(self, controller, completion, callable, *args, failure=None):
+		"""
+		# Execute &callable in a worker thread and enqueue &completion with its result
+		# into the process's task queue. When &callable raises, &completion is not
+		# performed; &failure is enqueued with the exception instead, or, when
+		# &failure is &None, the exception is reported as a fault of &controller.
+
+		# A worker is created when none are idle and the &worker_limit has not been reached.
+		"""
+
+		self.accounting[controller] = self.accounting.get(controller, 0) + 1
+		task = (weakref.ref(controller), completion, failure, callable, args)
+
+		with self._state:
+			if self._idle == 0 and len(self._queues) < self.worker_limit:
+				q = collections.deque()
+				self._queues.append(q)
+				self._idle += 1
+				self.spawn_worker(q)
+			else:
+				q = self._queues[self._cursor % len(self._queues)]
+				self._cursor += 1
+
+			q.append(task)
+			self._tasks += 1
+			if self._tasks == 1:
+				self._available.release()
+
+	def _take(self, queue):
+		# Wait for a task and select it from &queue, or steal it from the other queues.
+		while True:
+			self._available.acquire()
+			with self._state:
+				if self._tasks > 1:
+					# Allow other workers to proceed.
+					self._available.release()
+				self._tasks -= 1
+				self._idle -= 1
+
+				if queue:
+					return queue.pop()
+
+				for q in self._queues:
+					if q:
+						return q.popleft()
+
+	def _account(self, controller):
+		ctl = controller()
+		if ctl is not None:
+			n = self.accounting.get(ctl, 1) - 1
+			if n > 0:
+				self.accounting[ctl] = n
+			else:
+				self.accounting.pop(ctl, None)
+		return ctl
+
+	def _complete(self, controller, completion, result):
+		# Performed in the task queue.
+		self._account(controller)
+		if completion is not None:
+			completion(result)
+
+	def _failed(self, controller, failure, exception):
+		# Performed in the task queue.
+		ctl = self._account(controller)
+		if failure is not None:
+			failure(exception)
+		elif ctl is not None:
+			ctl.fault(exception)
+		else:
+			# Controller was released before the failure could be delivered.
+			self.process.error(None, exception, "Worker")
+
+	def worker(self, queue, gettid=thread.identify, partial=functools.partial):
+		"""
+		# Execute the tasks submitted to the pool.
+		"""
+
+		signal.pthread_sigmask(signal.SIG_BLOCK, {signal.SIGINT, signal.SIGTERM})
+		tid = gettid()
+		self.workers[tid] = queue
+
+		try:
+			while True:
+				controller, completion, failure, call, args = self._take(queue)
+				try:
+					result = call(*args)
+				except BaseException as exception:
+					self.process.enqueue(partial(self._failed, controller, failure, exception))
+					del exception
+				else:
+					self.process.enqueue(partial(self._complete, controller, completion, result))
+					del result
+				del controller, completion, failure, call, args
+
+				with self._state:
+					self._idle += 1
+		finally:
+			del self.workers[tid]
+
+	def spawn_worker(self, queue, create_thread=thread.create):
+		"""
+		# Add a worker thread to the pool's fabric.
+		"""
+
+		return create_thread(self.worker, (queue,))
+
 	def thread(self, *parameters, gettid=thread.identify):
 		"""
 		# Manage the execution of a thread.
@@ -1316,7 +1832,7 @@ class Fabric(object):
 		# Whether or not the given thread [identifier] is executing in this Fabric instance.
 		"""
 
-		return tid in self.threading
+		return tid in self.threading or tid in self.workers
 
 class Process(object):
 	"""
@@ -1330,8 +1846,18 @@ class Process(object):
 
 	# /fabric/
 		# The &Fabric instance managing the threads controlled by the process.
+	# /metrics/
+		# The &metrics.Registry of the process; exported into the directory
+		# identified by (env)`METRICS_EXPORT` when it is set.
+	# /sampler/
+		# The &sampling.Sampler profiling the process when (env)`SAMPLING_PROFILE`
+		# identifies a directory; &None otherwise. The samples are written to
+		# `<pid>.samples` in that directory when the process exits, and
+		# (env)`SAMPLING_INTERVAL` overrides the seconds between samples.
 	"""
 
+	sampler = None
+
 	@staticmethod
 	def current(tid=thread.identify):
 		"""
@@ -1423,12 +1949,39 @@ class Process(object):
 
 		self.enqueue = self.kernel.enqueue
 		self._init_exit()
+		self._init_metrics()
+		self._init_sampling()
 		self._init_io()
 
 	def _init_exit(self):
 		self._exit_stack = contextlib.ExitStack()
 		self._exit_stack.__enter__()
 
+	def _init_metrics(self):
+		self.metrics = metrics.Registry.environment()
+		self._exit_stack.callback(self.metrics.unlink)
+
+	def _init_sampling(self, variable='SAMPLING_PROFILE'):
+		directory = os.environ.get(variable)
+		if not directory:
+			self.sampler = None
+			return
+
+		interval = float(os.environ.get('SAMPLING_INTERVAL') or 0.005)
+		# The scheduler's loop is only retained as the default of &process.Scheduling.
+		loop = process.Scheduling.__defaults__[-1]
+		boundaries = [loop.__code__, protect.__code__]
+		self.sampler = sampling.Sampler(interval, boundaries=boundaries)
+		self.sampler.start()
+
+		path = os.path.join(directory, str(os.getpid()) + '.samples')
+		self._exit_stack.callback(self._write_samples, self.sampler, path)
+
+	@staticmethod
+	def _write_samples(sampler, path):
+		sampler.stop()
+		sampler.write(path)
+
 	def _init_io(self):
 		exe = functools.partial(self.fabric.critical, self)
 		self.iomatrix = Matrix(self.error, self.enqueue, exe)
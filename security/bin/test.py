@@ -191,6 +191,250 @@ def test_enciphered_transfers_signals(test):
 	test/('server-received-close' in signals) == True
 	test/server.receive_closed == True
 
+def negotiate(client, server):
+	"""
+	# Exchange protocol data until the handshake is complete.
+	"""
+	for x in range(4):
+		server.decipher(client.encipher(()))
+		client.decipher(server.encipher(()))
+
+def test_enciphered_records(test):
+	"""
+	# Validate that queued writes are coalesced and returned as a single buffer.
+	"""
+	sctx = module.Context(key = key, certificates = [certificate])
+	cctx = module.Context(certificates = [certificate])
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+	negotiate(client, server)
+
+	messages = [bytes([x % 256]) * 100 for x in range(400)]
+	ciphertexts = client.encipher(messages)
+	test/len(ciphertexts) == 1
+	test/len(client.output_queue) == 0
+
+	plaintexts = server.decipher(ciphertexts)
+	test/len(plaintexts) == 1
+	test/b''.join(plaintexts) == b''.join(messages)
+
+	# Larger than a record.
+	large = b'x' * (1024 * 64)
+	plaintexts = server.decipher(client.encipher([b'', large, b'y']))
+	test/b''.join(plaintexts) == large + b'y'
+
+def test_decipher_into(test):
+	"""
+	# Validate readinto-style deciphering.
+	"""
+	sctx = module.Context(key = key, certificates = [certificate])
+	cctx = module.Context(certificates = [certificate])
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+	negotiate(client, server)
+
+	target = bytearray(8)
+	test/server.decipher_into(client.encipher([b'plaintext data']), target) == 8
+	test/target == b'plaintex'
+	test/server.pending_input() > 0
+
+	test/server.decipher_into((), target) == 6
+	test/target[:6] == b't data'
+	test/server.decipher_into((), target) == 0
+
+def test_applications(test):
+	"""
+	# Validate that servers select the application protocol by their own preference.
+	"""
+	sctx = module.Context(key = key, certificates = [certificate], applications = (b'h2', b'http/1.1'))
+	cctx = module.Context(certificates = [certificate], applications = (b'http/1.1', b'h2'))
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+	negotiate(client, server)
+	test/server.application == b'h2'
+	test/client.application == b'h2'
+
+	# No overlap; proceeds without ALPN.
+	cctx = module.Context(certificates = [certificate], applications = (b'spdy/3',))
+	client = cctx.connect(None)
+	server = sctx.accept()
+	negotiate(client, server)
+	test/server.application == None
+	test/client.application == None
+
+def test_sessions(test):
+	"""
+	# Validate session resumption across Contexts sharing &module.Sessions.
+	"""
+	import os
+	import tempfile
+
+	shared = module.Sessions(16)
+	test/shared.capacity == 16
+	test/shared.count == 0
+	client_sessions = module.Sessions(16)
+
+	sctxs = [
+		module.Context(key = key, certificates = [certificate], sessions = shared)
+		for x in range(2)
+	]
+	cctx = module.Context(certificates = [certificate], sessions = client_sessions)
+
+	def connect(sctx):
+		client = cctx.connect(b'test.fault.io')
+		server = sctx.accept()
+		negotiate(client, server)
+		server.decipher(client.encipher([b'request']))
+		client.decipher(server.encipher([b'response']))
+		return client, server
+
+	client, server = connect(sctxs[0])
+	test/client.resumed == False
+	test/client_sessions.misses == 1
+	test/client_sessions.count > 0
+
+	# Resume using the other Context.
+	client, server = connect(sctxs[1])
+	test/client.resumed == True
+	test/server.resumed == True
+	test/client_sessions.hits == 1
+	test/shared.tickets == 1
+
+	# Rotated keys reject the previously issued tickets.
+	with tempfile.TemporaryDirectory() as d:
+		path = os.path.join(d, 'tickets')
+		with open(path, 'wb') as f:
+			f.write(os.urandom(80 * 2))
+		test/shared.rotate(path) == 2
+
+		with open(path, 'wb') as f:
+			f.write(b'short')
+		test/ValueError ^ (lambda: shared.rotate(path))
+
+	client, server = connect(sctxs[0])
+	test/server.resumed == False
+	test/shared.tickets == 1
+
+def test_negotiation(test):
+	"""
+	# Validate handshakes performed by &module.Negotiation workers.
+	"""
+	import threading
+
+	ng = module.Negotiation(2)
+	test/ng.threads == 0
+	sctx = module.Context(key = key, certificates = [certificate])
+	cctx = module.Context(certificates = [certificate])
+	done = threading.Semaphore(0)
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+
+	test/ng.negotiate(server, client.encipher(()), done.release) == True
+	test/done.acquire(timeout=16) == True
+	test/ng.threads == 1
+
+	client.decipher(server.encipher(()))
+	test/ng.negotiate(server, client.encipher(()), done.release) == True
+	test/done.acquire(timeout=16) == True
+
+	# Negotiated; subsequent transfers are deciphered directly.
+	test/ng.negotiate(server, (), done.release) == False
+	test/b''.join(server.decipher(client.encipher([b'request']))) == b'request'
+	test/b''.join(client.decipher(server.encipher([b'response']))) == b'response'
+
+	# Failures are raised by the next decipher.
+	server = sctx.accept()
+	test/ng.negotiate(server, [b'\x16\x03\x01\x00\x05hello'], done.release) == True
+	test/done.acquire(timeout=16) == True
+	test/module.IError ^ (lambda: server.decipher(()))
+
+def test_negotiation_busy(test):
+	"""
+	# Validate that the SSL state is not accessed while a worker is negotiating.
+	"""
+	import sys
+	import threading
+
+	ng = module.Negotiation(1)
+	sctx = module.Context(key = key, certificates = [certificate])
+	cctx = module.Context(certificates = [certificate])
+	done = threading.Semaphore(0)
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+	test/ng.negotiate(server, client.encipher(()), done.release) == True
+	test/done.acquire(timeout=16) == True
+	client.decipher(server.encipher(()))
+
+	# The completion requires the GIL; keep it until the assertions are made.
+	interval = sys.getswitchinterval()
+	sys.setswitchinterval(60)
+	try:
+		test/ng.negotiate(server, client.encipher(()), done.release) == True
+		test/server.close() == False
+		test/server.pending_output() == 0
+		test/server.pending_input() == 0
+		test/RuntimeError ^ server.status
+		test/RuntimeError ^ (lambda: server.application)
+		test/RuntimeError ^ (lambda: server.transmit_closed)
+		test/('negotiating' in repr(server)) == True
+	finally:
+		sys.setswitchinterval(interval)
+	test/done.acquire(timeout=16) == True
+
+	# The deferred close was performed by the completion.
+	test/server.transmit_closed == True
+	client.decipher(server.encipher(()))
+	test/client.receive_closed == True
+
+def test_offload(test):
+	"""
+	# Validate kernel TLS hand-off over a loopback connection.
+	"""
+	import socket
+
+	sctx = module.Context(key = key, certificates = [certificate], offload = True)
+	cctx = module.Context(certificates = [certificate])
+
+	client = cctx.connect(None)
+	server = sctx.accept()
+	test/server.offloaded == False
+	test/server.offload(-1) == False # Not negotiated.
+	negotiate(client, server)
+
+	listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+	listener.bind(('127.0.0.1', 0))
+	listener.listen(1)
+	csock = socket.create_connection(listener.getsockname())
+	ssock, addr = listener.accept()
+	listener.close()
+
+	try:
+		try:
+			test/server.offload(ssock.fileno()) == True
+		except OSError as err:
+			test.skip("kernel TLS unavailable: " + str(err))
+		test/server.offloaded == True
+
+		# Pass-through once offloaded.
+		test/server.encipher([b'plain']) == [b'plain']
+		test/server.decipher([b'plain']) == [b'plain']
+
+		ssock.sendall(b'server message')
+		plaintexts = []
+		while b''.join(plaintexts) != b'server message':
+			plaintexts.extend(client.decipher([csock.recv(1024)]))
+
+		csock.sendall(b''.join(client.encipher([b'client message'])))
+		test/ssock.recv(1024) == b'client message'
+	finally:
+		csock.close()
+		ssock.close()
+
 if __name__ == '__main__':
 	import sys; from ...test import library as libtest
 	libtest.execute(sys.modules[__name__])
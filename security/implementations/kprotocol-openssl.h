@@ -22,6 +22,22 @@
 #include <openssl/evp.h>
 
 #include <openssl/objects.h>
+#include <openssl/kdf.h>
+
+/**
+	// Kernel TLS is only supported for TLS 1.3 connections on Linux.
+*/
+#if defined(__linux__) && !defined(OPENSSL_NO_TLS1_3) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+	#include <netinet/tcp.h>
+	#include <linux/tls.h>
+	#define TRANSPORT_OFFLOAD 1
+
+	#ifndef SOL_TLS
+		#define SOL_TLS 282
+	#endif
+#else
+	#define TRANSPORT_OFFLOAD 0
+#endif
 
 #define VERIFY_FAILURE 337047686
 
@@ -85,6 +101,12 @@ struct Context {
 	PyObject_HEAD
 	context_t tls_context;
 	PyObj ctx_queue_type;
+	int ctx_offload; /* Capture traffic secrets for kernel TLS. */
+	PyObj ctx_sessions; /* Shared session storage or NULL. */
+
+	/* ALPN list in preference order; selected from by servers. */
+	unsigned char *ctx_applications;
+	unsigned int ctx_applications_length;
 };
 typedef struct Context *Context;
 
@@ -94,6 +116,29 @@ typedef struct Context *Context;
 #define output_buffer_initial(tls) PySequence_GetItem(tls->output_queue, 0)
 #define output_buffer_pop(tls) PySequence_DelItem(tls->output_queue, 0)
 
+/**
+	// Kernel TLS hand-off state.
+	// Allocated for Transports whose Context was created with offloading enabled.
+*/
+struct transport_offload {
+	/* Application traffic secrets; client then server. */
+	unsigned char ofl_secrets[2][EVP_MAX_MD_SIZE];
+	size_t ofl_secret_size[2];
+
+	/* Record sequence numbers of the application traffic epoch; read then write. */
+	uint64_t ofl_sequence[2];
+	char ofl_epoch[2];
+
+	char ofl_offloaded;
+
+	/**
+		// Set when the kernel accepted the transmit keys, but not the receive keys.
+		// Outgoing data is enciphered by the kernel while the Transport's own state
+		// is no longer consistent with the socket; the connection must be closed.
+	*/
+	char ofl_failed;
+};
+
 /**
 	// TLS connection state.
 */
@@ -110,9 +155,52 @@ struct Transport {
 	PyObj output_queue; /* when SSL_write is not possible */
 	PyObj recv_closed_cb;
 	PyObj send_queued_cb;
+
+	struct transport_offload *tls_offload;
+
+	/**
+		// Set while a handshake step is performed by a &Negotiation worker.
+		// Ciphertext received in the meantime is held by &tls_deferred, and
+		// a failure of the step is held by &tls_failure until the next decipher.
+	*/
+	char tls_busy;
+	PyObj tls_deferred;
+	PyObj tls_failure;
+
+	/**
+		// Requests of &transport_leak and &transport_close_output made while
+		// &tls_busy; performed by &transport_settle once the step has completed.
+	*/
+	char tls_leak_deferred;
+	char tls_close_deferred;
+
+	/**
+		// The length of a record write that must be retried; zero when none is pending.
+		// SSL_write requires the retry to use the same length.
+	*/
+	size_t tls_retry_size;
 };
 typedef struct Transport *Transport;
 
+#define Transport_Offloaded(tls) (tls->tls_offload != NULL && tls->tls_offload->ofl_offloaded)
+
+/**
+	// Refuse transfers after a partial kernel hand-off.
+*/
+#define Transport_OffloadFailed(tls) ( \
+	(tls->tls_offload != NULL && tls->tls_offload->ofl_failed) ? \
+		(PyErr_SetString(PyExc_RuntimeError, "transport was partially offloaded and must be closed"), 1) : 0 \
+)
+
+/**
+	// Refuse access to the SSL state and memory BIOs while a &Negotiation
+	// worker is performing a handshake step with them.
+*/
+#define Transport_Negotiating(tls) ( \
+	tls->tls_busy ? \
+		(PyErr_SetString(PyExc_RuntimeError, "transport is negotiating on a worker thread"), 1) : 0 \
+)
+
 static PyTypeObject KeyType, CertificateType, ContextType, TransportType;
 
 /**
@@ -248,6 +336,8 @@ library_error(void)
 		return(0);
 }
 
+#include "openssl-sessions.h"
+
 /**
 	// Allocate and initialize the ALPN list from a Python object.
 
@@ -334,6 +424,248 @@ ialpn(PyObj ob, unsigned char **aprotocols, unsigned int *alength)
 	return(0);
 }
 
+#if OPENSSL_VERSION_NUMBER >= 0x1000200fL
+/**
+	// Select the application protocol for a server using the Context's
+	// preference order. Connections proceed without ALPN when there is no overlap.
+*/
+static int
+context_select_application(SSL *ssl,
+	const unsigned char **out, unsigned char *outlen,
+	const unsigned char *in, unsigned int inlen, void *arg)
+{
+	Context ctx = (Context) arg;
+	unsigned char *selected = NULL;
+
+	if (SSL_select_next_proto(&selected, outlen,
+		ctx->ctx_applications, ctx->ctx_applications_length, in, inlen) != OPENSSL_NPN_NEGOTIATED)
+		return(SSL_TLSEXT_ERR_NOACK);
+
+	*out = selected;
+	return(SSL_TLSEXT_ERR_OK);
+}
+#endif
+
+#if TRANSPORT_OFFLOAD
+/**
+	// Capture the application traffic secrets as they are derived.
+*/
+static void
+transport_keylog(const SSL *ssl, const char *line)
+{
+	static const char *labels[2] = {
+		"CLIENT_TRAFFIC_SECRET_0 ",
+		"SERVER_TRAFFIC_SECRET_0 ",
+	};
+	Transport tls = (Transport) SSL_get_app_data(ssl);
+	struct transport_offload *ofl;
+	const char *hex;
+	size_t i, size;
+	int side;
+
+	if (tls == NULL || tls->tls_offload == NULL)
+		return;
+	ofl = tls->tls_offload;
+
+	for (side = 0; side < 2; ++side)
+	{
+		if (strncmp(line, labels[side], strlen(labels[side])) == 0)
+			break;
+	}
+	if (side == 2)
+		return;
+
+	/* Skip the client random field. */
+	hex = strchr(line + strlen(labels[side]), ' ');
+	if (hex == NULL)
+		return;
+	hex += 1;
+
+	size = strlen(hex) / 2;
+	if (size > EVP_MAX_MD_SIZE)
+		return;
+
+	for (i = 0; i < size; ++i)
+	{
+		unsigned int octet;
+
+		if (sscanf(hex + (i * 2), "%2x", &octet) != 1)
+			return;
+		ofl->ofl_secrets[side][i] = (unsigned char) octet;
+	}
+
+	ofl->ofl_secret_size[side] = size;
+}
+
+/**
+	// Track the record sequence numbers of the application traffic epoch.
+	// Records are reported before the messages they carry, so the epoch
+	// of a direction begins after its Finished message.
+*/
+static void
+transport_record(int write_p, int version, int content_type,
+	const void *buf, size_t len, SSL *ssl, void *arg)
+{
+	Transport tls = (Transport) SSL_get_app_data(ssl);
+	struct transport_offload *ofl;
+
+	if (tls == NULL || tls->tls_offload == NULL)
+		return;
+	ofl = tls->tls_offload;
+	write_p = write_p ? 1 : 0;
+
+	switch (content_type)
+	{
+		case SSL3_RT_HANDSHAKE:
+			if (len > 0 && ((const unsigned char *) buf)[0] == SSL3_MT_FINISHED)
+			{
+				ofl->ofl_epoch[write_p] = 1;
+				ofl->ofl_sequence[write_p] = 0;
+			}
+		break;
+
+		case SSL3_RT_INNER_CONTENT_TYPE:
+			if (ofl->ofl_epoch[write_p])
+				ofl->ofl_sequence[write_p] += 1;
+		break;
+	}
+}
+
+/**
+	// HKDF-Expand-Label from RFC 8446 with an empty context.
+*/
+static int
+hkdf_expand_label(const EVP_MD *md, const unsigned char *secret, size_t ssize,
+	const char *label, unsigned char *out, size_t osize)
+{
+	unsigned char info[2 + 1 + 255 + 1];
+	size_t lsize = strlen(label), isize = 0;
+	EVP_PKEY_CTX *pctx;
+	int r = 0;
+
+	info[isize++] = (osize >> 8) & 0xFF;
+	info[isize++] = osize & 0xFF;
+	info[isize++] = 6 + lsize;
+	memcpy(info + isize, "tls13 ", 6);
+	isize += 6;
+	memcpy(info + isize, label, lsize);
+	isize += lsize;
+	info[isize++] = 0;
+
+	pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+	if (pctx == NULL)
+		return(0);
+
+	if (EVP_PKEY_derive_init(pctx) > 0
+		&& EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0
+		&& EVP_PKEY_CTX_set_hkdf_md(pctx, md) > 0
+		&& EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, ssize) > 0
+		&& EVP_PKEY_CTX_add1_hkdf_info(pctx, info, isize) > 0
+		&& EVP_PKEY_derive(pctx, out, &osize) > 0)
+		r = 1;
+
+	EVP_PKEY_CTX_free(pctx);
+	return(r);
+}
+
+union transport_crypto_info {
+	struct tls_crypto_info info;
+	struct tls12_crypto_info_aes_gcm_128 aes128;
+	struct tls12_crypto_info_aes_gcm_256 aes256;
+
+	#ifdef TLS_CIPHER_CHACHA20_POLY1305
+		struct tls12_crypto_info_chacha20_poly1305 chacha;
+	#endif
+};
+
+#define X_OFFLOAD_FIELDS(FIELD, TYPE) \
+	ci->info.cipher_type = TYPE; \
+	memcpy(ci->FIELD.key, key, sizeof(ci->FIELD.key)); \
+	memcpy(ci->FIELD.salt, iv, sizeof(ci->FIELD.salt)); \
+	memcpy(ci->FIELD.iv, iv + sizeof(ci->FIELD.salt), sizeof(ci->FIELD.iv)); \
+	memcpy(ci->FIELD.rec_seq, seq, sizeof(ci->FIELD.rec_seq)); \
+	*size = sizeof(ci->FIELD);
+
+/**
+	// Derive the kernel crypto parameters for the read or write direction.
+	// Returns zero when the negotiated cipher is not supported.
+*/
+static int
+transport_offload_parameters(Transport tls, int write_p,
+	union transport_crypto_info *ci, socklen_t *size)
+{
+	struct transport_offload *ofl = tls->tls_offload;
+	const SSL_CIPHER *cipher = SSL_get_current_cipher(tls->tls_state);
+	const EVP_MD *md;
+	unsigned char key[32], iv[12], seq[8];
+	size_t klen;
+	uint64_t n;
+	int i, side, r = 0;
+
+	if (cipher == NULL)
+		return(0);
+
+	switch (SSL_CIPHER_get_protocol_id(cipher))
+	{
+		case 0x1301: /* TLS_AES_128_GCM_SHA256 */
+			klen = 16;
+		break;
+
+		case 0x1302: /* TLS_AES_256_GCM_SHA384 */
+		#ifdef TLS_CIPHER_CHACHA20_POLY1305
+			case 0x1303: /* TLS_CHACHA20_POLY1305_SHA256 */
+		#endif
+			klen = 32;
+		break;
+
+		default:
+			return(0);
+		break;
+	}
+
+	/* The write secret is the local side's, the read secret is the peer's. */
+	side = (write_p == SSL_is_server(tls->tls_state)) ? 1 : 0;
+	md = SSL_CIPHER_get_handshake_digest(cipher);
+
+	if (!hkdf_expand_label(md, ofl->ofl_secrets[side], ofl->ofl_secret_size[side], "key", key, klen)
+		|| !hkdf_expand_label(md, ofl->ofl_secrets[side], ofl->ofl_secret_size[side], "iv", iv, sizeof(iv)))
+		goto exit;
+
+	n = ofl->ofl_sequence[write_p];
+	for (i = 0; i < 8; ++i)
+		seq[7 - i] = (n >> (8 * i)) & 0xFF;
+
+	memset(ci, 0, sizeof(*ci));
+	ci->info.version = TLS_1_3_VERSION;
+
+	switch (SSL_CIPHER_get_protocol_id(cipher))
+	{
+		case 0x1301:
+			X_OFFLOAD_FIELDS(aes128, TLS_CIPHER_AES_GCM_128)
+		break;
+
+		case 0x1302:
+			X_OFFLOAD_FIELDS(aes256, TLS_CIPHER_AES_GCM_256)
+		break;
+
+		#ifdef TLS_CIPHER_CHACHA20_POLY1305
+			case 0x1303:
+				X_OFFLOAD_FIELDS(chacha, TLS_CIPHER_CHACHA20_POLY1305)
+			break;
+		#endif
+	}
+	r = 1;
+
+	exit:
+	{
+		OPENSSL_cleanse(key, sizeof(key));
+		OPENSSL_cleanse(iv, sizeof(iv));
+		return(r);
+	}
+}
+#undef X_OFFLOAD_FIELDS
+#endif
+
 /**
 	// primary &transport_new parts. Normally called by the Context methods.
 */
@@ -369,6 +701,18 @@ create_tls_state(PyTypeObject *typ, Context ctx)
 		return(tls);
 	}
 
+	SSL_set_app_data(tls->tls_state, tls);
+
+	if (ctx->ctx_offload)
+	{
+		tls->tls_offload = PyMem_Calloc(1, sizeof(struct transport_offload));
+		if (tls->tls_offload == NULL)
+		{
+			PyErr_NoMemory();
+			goto error;
+		}
+	}
+
 	Py_INCREF(((PyObj) ctx));
 
 	/**
@@ -868,6 +1212,9 @@ context_connect(PyObj self, PyObj hostname)
 	if (_transport_set_hostname(tls, hostname))
 		goto error;
 
+	if (ctx->ctx_sessions != NULL)
+		sessions_resume((Sessions) ctx->ctx_sessions, tls->tls_state);
+
 	SSL_set_connect_state(tls->tls_state);
 
 	if (SSL_do_handshake(tls->tls_state) != 0 && library_error())
@@ -935,6 +1282,9 @@ context_clear(PyObj self)
 	Py_XDECREF(ctx->ctx_queue_type);
 	ctx->ctx_queue_type = NULL;
 
+	Py_XDECREF(ctx->ctx_sessions);
+	ctx->ctx_sessions = NULL;
+
 	return(0);
 }
 
@@ -944,6 +1294,7 @@ context_traverse(PyObj self, visitproc visit, void *arg)
 	Context ctx = (Context) self;
 
 	Py_VISIT(ctx->ctx_queue_type);
+	Py_VISIT(ctx->ctx_sessions);
 	return(0);
 }
 
@@ -955,6 +1306,9 @@ context_dealloc(PyObj self)
 	if (ctx->tls_context)
 		SSL_CTX_free(ctx->tls_context);
 
+	if (ctx->ctx_applications != NULL)
+		PyMem_Free(ctx->ctx_applications);
+
 	context_clear(self);
 	Py_TYPE(self)->tp_free(self);
 }
@@ -979,6 +1333,8 @@ context_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 		"requirements",
 		"ciphers",
 		"applications",
+		"offload",
+		"sessions",
 		NULL,
 	};
 
@@ -990,17 +1346,21 @@ context_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 	PyObj certificates = NULL; /* iterable */
 	PyObj requirements = NULL; /* iterable */
 	PyObj applications = NULL; /* iterable of bytes */
+	int offload = 0;
+	PyObj sessions = NULL;
 
 	char *ciphers = FAULT_OPENSSL_CIPHERS;
 
 	if (!PyArg_ParseTupleAndKeywords(args, kw,
-		"|Os#OOsO", kwlist,
+		"|Os#OOsOpO!", kwlist,
 		&key_ob,
 		&(pwp.words), &(pwp.length),
 		&certificates,
 		&requirements,
 		&ciphers,
-		&applications
+		&applications,
+		&offload,
+		&SessionsType, &sessions
 	))
 		return(NULL);
 
@@ -1039,7 +1399,8 @@ context_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 		/*
 			// Context initialization.
 		*/
-		SSL_CTX_set_mode(ctx->tls_context, SSL_MODE_RELEASE_BUFFERS|SSL_MODE_AUTO_RETRY);
+		SSL_CTX_set_mode(ctx->tls_context,
+			SSL_MODE_RELEASE_BUFFERS|SSL_MODE_AUTO_RETRY|SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 		SSL_CTX_set_read_ahead(ctx->tls_context, 1);
 
 		if (applications != NULL)
@@ -1056,7 +1417,13 @@ context_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 				goto ierror;
 			}
 
-			PyMem_Free(aproto);
+			/* Retained for server selection; released by dealloc. */
+			ctx->ctx_applications = aproto;
+			ctx->ctx_applications_length = alength-1;
+
+			#if OPENSSL_VERSION_NUMBER >= 0x1000200fL
+				SSL_CTX_set_alpn_select_cb(ctx->tls_context, context_select_application, ctx);
+			#endif
 		}
 	}
 
@@ -1092,6 +1459,27 @@ context_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 	if (!SSL_CTX_set_cipher_list(ctx->tls_context, ciphers))
 		goto ierror;
 
+	if (sessions != NULL)
+	{
+		if (!sessions_connect((Sessions) sessions, ctx->tls_context))
+			goto ierror;
+
+		ctx->ctx_sessions = sessions;
+		Py_INCREF(sessions);
+	}
+
+	if (offload)
+	{
+		#if TRANSPORT_OFFLOAD
+			SSL_CTX_set_keylog_callback(ctx->tls_context, transport_keylog);
+			SSL_CTX_set_msg_callback(ctx->tls_context, transport_record);
+			ctx->ctx_offload = 1;
+		#else
+			PyErr_SetString(PyExc_NotImplementedError, "kernel TLS is not supported on this platform");
+			goto error;
+		#endif
+	}
+
 	/*
 		// Load certificates.
 	*/
@@ -1194,6 +1582,9 @@ transport_status(PyObj self)
 	Transport tls = (Transport) self;
 	PyObj rob;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	rob = Py_BuildValue("(sssi)",
 		SSL_get_version(tls->tls_state),
 		SSL_state_string(tls->tls_state),
@@ -1261,6 +1652,116 @@ transport_flush(Transport tls)
 	return(r); /* r < 0 on python error */
 }
 
+/**
+	// Maximum plaintext size of a single TLS record.
+	// Queued writes are coalesced up to this size before being enciphered.
+*/
+#ifndef TRANSPORT_RECORD_SIZE
+	#define TRANSPORT_RECORD_SIZE SSL3_RT_MAX_PLAIN_LENGTH
+#endif
+
+/**
+	// SSL_write_ex the queued buffers as full records.
+
+	// Consecutive buffers are copied into a record sized staging area and
+	// written with a single call; a buffer larger than a record is written directly.
+	// The staging area moves between calls, so the context accepts moving write buffers,
+	// and a failed write is retried with the same length by only coalescing up to
+	// &tls_retry_size; the head of the queue is not popped until the write succeeds.
+*/
+static int
+transport_flush_records(Transport tls)
+{
+	char record[TRANSPORT_RECORD_SIZE];
+	size_t rsize = 0, written = 0, limit = TRANSPORT_RECORD_SIZE;
+	Py_ssize_t i, count = 0, qsize;
+	Py_buffer pb;
+	PyObj cwb;
+	int r;
+
+	qsize = PyObject_Length(tls->output_queue);
+	if (qsize < 0)
+		return(-1);
+
+	if (tls->tls_retry_size > 0 && tls->tls_retry_size <= TRANSPORT_RECORD_SIZE)
+		limit = tls->tls_retry_size;
+
+	for (i = 0; i < qsize && rsize < limit; ++i)
+	{
+		cwb = PySequence_GetItem(tls->output_queue, i);
+		if (cwb == NULL)
+			return(-1);
+
+		if (PyObject_GetBuffer(cwb, &pb, PyBUF_SIMPLE))
+		{
+			Py_DECREF(cwb);
+			return(-1);
+		}
+
+		if (rsize + GetSize(pb) > limit)
+		{
+			if (rsize == 0)
+			{
+				/* Oversized buffer; let the library divide it into records. */
+				rsize = GetSize(pb);
+				r = SSL_write_ex(tls->tls_state, GetPointer(pb), rsize, &written);
+				PyBuffer_Release(&pb);
+				Py_DECREF(cwb);
+
+				/* Any preceding buffers were empty. */
+				count += 1;
+				goto check;
+			}
+
+			PyBuffer_Release(&pb);
+			Py_DECREF(cwb);
+			break;
+		}
+
+		memcpy(record + rsize, GetPointer(pb), GetSize(pb));
+		rsize += GetSize(pb);
+		count += 1;
+
+		PyBuffer_Release(&pb);
+		Py_DECREF(cwb);
+	}
+
+	if (count == 0)
+		return(0);
+
+	if (rsize > 0)
+		r = SSL_write_ex(tls->tls_state, record, rsize, &written);
+	else
+		/* Only empty buffers were present. */
+		r = 1;
+
+	check:
+	{
+		if (r < 1)
+		{
+			if (library_error())
+			{
+				tls->tls_retry_size = 0;
+				return(-2);
+			}
+
+			/* Retried with the same length. */
+			tls->tls_retry_size = rsize;
+			return(0);
+		}
+
+		tls->tls_retry_size = 0;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		if (output_buffer_pop(tls) < 0)
+			return(-1);
+	}
+
+	return(1);
+}
+
 /**
 	// EOF signals.
 */
@@ -1283,17 +1784,14 @@ transport_enciphered_write_eof(PyObj self, PyObj buffer)
 #define DEFAULT_READ_SIZE (1024 * 4)
 
 /**
-	// Write enciphered protocol data from the remote end into the transport.
-	// Either for deciphered reads or for internal protocol management.
-	// It is possible that empty buffer sequences return deciphered data.
+	// Write enciphered protocol data from the remote end into the read BIO.
 */
-static PyObj
-transport_decipher(PyObj self, PyObj buffer_sequence)
+static int
+transport_inject(Transport tls, PyObj buffer_sequence)
 {
-	Transport tls = (Transport) self;
 	Py_buffer pb;
 	int xfer;
-	PyObj rob, bufobj;
+	PyObj bufobj;
 
 	/**
 		// No need for a queue on decipher as the BIO will function
@@ -1326,83 +1824,142 @@ transport_decipher(PyObj self, PyObj buffer_sequence)
 	PyLoop_CatchError(buffer_sequence)
 	{
 		/* XXX: note Transport as broken? */
-		return(NULL);
+		return(-1);
 	}
 	PyLoop_End()
 
-	/* Construct deciphered transmission. */
-	rob = PyList_New(0);
-	if (rob == NULL)
-		return(NULL);
+	return(0);
+}
+
+/**
+	// Retain the ciphertext buffers while the Transport is negotiating on a worker.
+*/
+static int
+transport_defer(Transport tls, PyObj buffer_sequence)
+{
+	PyObj r;
 
-	xfer = 0;
-	do
+	if (tls->tls_deferred == NULL)
 	{
-		char *bufptr;
-		PyObj buffer;
+		tls->tls_deferred = PyList_New(0);
+		if (tls->tls_deferred == NULL)
+			return(-1);
+	}
 
-		buffer = PyByteArray_FromStringAndSize("", 0);
-		if (buffer == NULL)
-		{
-			Py_DECREF(rob);
-			return(NULL);
-		}
+	r = PyObject_CallMethod(tls->tls_deferred, "extend", "(O)", buffer_sequence);
+	if (r == NULL)
+		return(-1);
 
-		if (PyByteArray_Resize(buffer, DEFAULT_READ_SIZE))
-		{
-			Py_DECREF(buffer);
-			Py_DECREF(rob);
-			return(NULL);
-		}
+	Py_DECREF(r);
+	return(0);
+}
 
-		/* Only reference to this bytearray, so don't bother with buffer protocol. */
-		bufptr = PyByteArray_AS_STRING(buffer);
+/**
+	// Raise the failure of a worker performed handshake step, or
+	// write the ciphertext that was retained while it was performed.
+*/
+static int
+transport_resume(Transport tls)
+{
+	PyObj deferred;
+	int r;
 
-		xfer = SSL_read(tls->tls_state, bufptr, DEFAULT_READ_SIZE);
-		if (xfer < 1 && library_error())
-		{
-			Py_DECREF(buffer);
-			Py_DECREF(rob);
-			return(NULL);
-		}
-		else if (xfer > 0)
-		{
-			if (PyByteArray_Resize(buffer, MAX(0, xfer)) || PyList_Append(rob, buffer))
-			{
-				Py_DECREF(buffer);
-				Py_DECREF(rob);
-				return(NULL);
-			}
-		}
-		else
-		{
-			/* Check for termination. */
-			if (tls->recv_closed_cb != NULL && SSL_get_shutdown(tls->tls_state) & SSL_RECEIVED_SHUTDOWN)
-			{
-				PyObj cbout;
+	if (tls->tls_failure != NULL)
+	{
+		PyErr_SetObject((PyObj) Py_TYPE(tls->tls_failure), tls->tls_failure);
+		Py_DECREF(tls->tls_failure);
+		tls->tls_failure = NULL;
+		return(-1);
+	}
 
-				cbout = PyObject_CallFunction(tls->recv_closed_cb, NULL);
-				Py_DECREF(tls->recv_closed_cb);
-				tls->recv_closed_cb = NULL;
+	if (tls->tls_deferred == NULL)
+		return(0);
 
-				if (cbout)
-					Py_DECREF(cbout);
-				else
-					PyErr_WriteUnraisable(NULL);
-			}
+	deferred = tls->tls_deferred;
+	tls->tls_deferred = NULL;
 
-		}
+	r = transport_inject(tls, deferred);
+	Py_DECREF(deferred);
+	return(r);
+}
 
-		Py_DECREF(buffer); /* New reference owned by return list or error */
+/**
+	// Perform the requests that were deferred while a worker's handshake step
+	// was in progress. The close is retained until the handshake has finished.
+*/
+static void
+transport_settle(Transport tls)
+{
+	if (tls->tls_leak_deferred)
+	{
+		tls->tls_leak_deferred = 0;
+		SSL_set_quiet_shutdown(tls->tls_state, 1);
+	}
+
+	if (tls->tls_close_deferred && tls->tls_failure == NULL && !SSL_in_init(tls->tls_state))
+	{
+		tls->tls_close_deferred = 0;
+		if (SSL_shutdown(tls->tls_state) < 0 && library_error())
+			PyErr_WriteUnraisable((PyObj) tls);
+	}
+}
+
+/**
+	// SSL_read_ex into &buf until it is full or no more plaintext is available.
+	// The status of the final read is stored in &last.
+*/
+static Py_ssize_t
+transport_read(Transport tls, char *buf, Py_ssize_t size, int *last)
+{
+	Py_ssize_t total = 0;
+	size_t xfer = 0;
+	int r = 1;
+
+	while (total < size)
+	{
+		r = SSL_read_ex(tls->tls_state, buf + total, (size_t) (size - total), &xfer);
+		if (r < 1)
+		{
+			if (library_error())
+				return(-1);
+			break;
+		}
+
+		total += (Py_ssize_t) xfer;
+	}
+
+	*last = r;
+	return(total);
+}
+
+/**
+	// Dispatch the connected callbacks after a read has been performed.
+*/
+static void
+transport_signal(Transport tls, int last)
+{
+	/* Check for termination. */
+	if (last < 1 && tls->recv_closed_cb != NULL
+		&& SSL_get_shutdown(tls->tls_state) & SSL_RECEIVED_SHUTDOWN)
+	{
+		PyObj cbout;
+
+		cbout = PyObject_CallFunction(tls->recv_closed_cb, NULL);
+		Py_DECREF(tls->recv_closed_cb);
+		tls->recv_closed_cb = NULL;
+
+		if (cbout)
+			Py_DECREF(cbout);
+		else
+			PyErr_WriteUnraisable(NULL);
 	}
-	while (xfer > 0);
 
 	/**
 		// Check if deciphering caused any writes and drain the transmit side
 		// if any callbacks are available.
 	*/
 	if (BIO_ctrl_pending(Transport_GetWriteBuffer(tls))
-		|| SSL_get_error(tls->tls_state, xfer) == SSL_ERROR_WANT_WRITE
+		|| SSL_get_error(tls->tls_state, last) == SSL_ERROR_WANT_WRITE
 		|| output_buffer_has_content(tls) == 1)
 	{
 		if (tls->send_queued_cb != NULL)
@@ -1417,13 +1974,151 @@ transport_decipher(PyObj self, PyObj buffer_sequence)
 				PyErr_WriteUnraisable(NULL);
 		}
 	}
+}
+
+/**
+	// Write enciphered protocol data from the remote end into the transport.
+	// Either for deciphered reads or for internal protocol management.
+	// It is possible that empty buffer sequences return deciphered data.
+
+	// The available plaintext is read into a single buffer sized from the pending
+	// ciphertext; plaintext never exceeds the records it was deciphered from.
+*/
+static PyObj
+transport_decipher(PyObj self, PyObj buffer_sequence)
+{
+	Transport tls = (Transport) self;
+	Py_ssize_t size, total = 0, xfer;
+	int last = 0;
+	PyObj rob, buffer;
+
+	/* Kernel deciphers; the buffers are plaintext. */
+	if (Transport_Offloaded(tls))
+		return(PySequence_List(buffer_sequence));
+
+	if (Transport_OffloadFailed(tls))
+		return(NULL);
+
+	if (tls->tls_busy)
+	{
+		if (transport_defer(tls, buffer_sequence))
+			return(NULL);
+		return(PyList_New(0));
+	}
+
+	if (transport_resume(tls) || transport_inject(tls, buffer_sequence))
+		return(NULL);
+
+	/* Construct deciphered transmission. */
+	rob = PyList_New(0);
+	if (rob == NULL)
+		return(NULL);
+
+	size = BIO_ctrl_pending(Transport_GetReadBuffer(tls)) + SSL_pending(tls->tls_state);
+	size = MAX(size, DEFAULT_READ_SIZE);
+
+	buffer = PyByteArray_FromStringAndSize(NULL, size);
+	if (buffer == NULL)
+	{
+		Py_DECREF(rob);
+		return(NULL);
+	}
+
+	for (;;)
+	{
+		/* Only reference to this bytearray, so don't bother with buffer protocol. */
+		xfer = transport_read(tls, PyByteArray_AS_STRING(buffer) + total, size - total, &last);
+		if (xfer < 0)
+			goto error;
+
+		total += xfer;
+		if (total < size)
+			break;
+
+		/* Filled; read-ahead may have more records available. */
+		size *= 2;
+		if (PyByteArray_Resize(buffer, size))
+			goto error;
+	}
+
+	if (total > 0)
+	{
+		if (PyByteArray_Resize(buffer, total) || PyList_Append(rob, buffer))
+			goto error;
+	}
+	Py_DECREF(buffer); /* New reference owned by return list */
 
+	transport_signal(tls, last);
 	return(rob);
+
+	error:
+	{
+		Py_DECREF(buffer);
+		Py_DECREF(rob);
+		return(NULL);
+	}
+}
+
+/**
+	// Write enciphered protocol data into the transport and read the available
+	// plaintext into the given writable buffer. Returns the number of bytes written.
+	// When the buffer is filled, &transport_pending_input may indicate remaining plaintext.
+*/
+static PyObj
+transport_decipher_into(PyObj self, PyObj args)
+{
+	Transport tls = (Transport) self;
+	Py_ssize_t xfer;
+	Py_buffer target;
+	int last = 0;
+	PyObj buffer_sequence;
+
+	if (!PyArg_ParseTuple(args, "Ow*", &buffer_sequence, &target))
+		return(NULL);
+
+	if (Transport_Offloaded(tls))
+	{
+		PyBuffer_Release(&target);
+		PyErr_SetString(PyExc_RuntimeError, "transport is offloaded to the kernel");
+		return(NULL);
+	}
+
+	if (Transport_OffloadFailed(tls))
+	{
+		PyBuffer_Release(&target);
+		return(NULL);
+	}
+
+	if (tls->tls_busy)
+	{
+		PyBuffer_Release(&target);
+		if (transport_defer(tls, buffer_sequence))
+			return(NULL);
+		return(PyLong_FromLong(0));
+	}
+
+	if (transport_resume(tls) || transport_inject(tls, buffer_sequence))
+	{
+		PyBuffer_Release(&target);
+		return(NULL);
+	}
+
+	xfer = transport_read(tls, GetPointer(target), GetSize(target), &last);
+	PyBuffer_Release(&target);
+
+	if (xfer < 0)
+		return(NULL);
+
+	transport_signal(tls, last);
+	return(PyLong_FromSsize_t(xfer));
 }
 
 /**
 	// Write plaintext data to be enciphered and return the ciphertext to be written
 	// to the remote end.
+
+	// Once negotiated, queued plaintext is coalesced into full records and the
+	// ciphertext is returned as a single contiguous buffer.
 */
 static PyObj
 transport_encipher(PyObj self, PyObj buffer_sequence)
@@ -1431,15 +2126,27 @@ transport_encipher(PyObj self, PyObj buffer_sequence)
 	Transport tls = (Transport) self;
 	int xfer;
 	int flush_result;
-	char wrote = 0;
-	Py_ssize_t queued = 0;
-	PyObj rob, r; /* used to check deque operation results */
+	size_t pending;
+	PyObj rob, buffer, r; /* used to check deque operation results */
 	BIO *wb = Transport_GetWriteBuffer(tls);
 
+	/* Kernel enciphers; pass the plaintext through. */
+	if (Transport_Offloaded(tls))
+		return(PySequence_List(buffer_sequence));
+
+	/* Kernel enciphers, but the Transport cannot decipher; refuse rather than encipher twice. */
+	if (Transport_OffloadFailed(tls))
+		return(NULL);
+
 	/* Extend queue unconditionally */
 	r = output_buffer_extend(tls, buffer_sequence);
 	if (r == NULL)
 		return(NULL);
+	Py_DECREF(r);
+
+	/* Flushed once the worker's handshake step completes. */
+	if (tls->tls_busy)
+		return(PyTuple_New(0));
 
 	/* Move buffers out of queue and into the Transport. */
 	flushing:
@@ -1451,7 +2158,11 @@ transport_encipher(PyObj self, PyObj buffer_sequence)
 			break;
 
 			case 1:
-				flush_result = transport_flush(tls);
+				if (SSL_is_init_finished(tls->tls_state))
+					flush_result = transport_flush_records(tls);
+				else
+					flush_result = transport_flush(tls);
+
 				if (flush_result > 0)
 					goto flushing; /* continue */
 				else if (flush_result == -2)
@@ -1477,11 +2188,13 @@ transport_encipher(PyObj self, PyObj buffer_sequence)
 		}
 	}
 
+	pending = BIO_ctrl_pending(wb);
+
 	#if !(FV_INJECTIONS())
 		/**
 			// Avoid early return during tests.
 		*/
-		if (BIO_ctrl_pending(wb) == 0)
+		if (pending == 0)
 		{
 			return(PyTuple_New(0));
 		}
@@ -1491,47 +2204,32 @@ transport_encipher(PyObj self, PyObj buffer_sequence)
 	if (rob == NULL)
 		return(NULL);
 
-	xfer = 0;
-	do
+	buffer = PyByteArray_FromStringAndSize(NULL, pending);
+	if (buffer == NULL)
 	{
-		char *bufptr = 0;
-		PyObj buffer;
-
-		buffer = PyByteArray_FromStringAndSize("", 0);
-		if (buffer == NULL)
-			return(NULL);
-
-		if (PyByteArray_Resize(buffer, DEFAULT_READ_SIZE))
-		{
-			Py_DECREF(buffer);
-			Py_DECREF(rob);
-			return(NULL);
-		}
+		Py_DECREF(rob);
+		return(NULL);
+	}
 
+	if (pending > 0)
+	{
 		/* Only reference to this bytearray, so don't bother with buffer protocol. */
-		bufptr = PyByteArray_AS_STRING(buffer);
-
-		xfer = BIO_read(wb, bufptr, DEFAULT_READ_SIZE);
-		if (xfer < 0)
-		{
-			assert(xfer != -2); /* Not Implemented? Memory BIOs implement read */
-		}
-		else
-		{
-			if (PyByteArray_Resize(buffer, MAX(0, xfer)) || PyList_Append(rob, buffer))
-			{
-				/* failed to resize and append */
+		xfer = BIO_read(wb, PyByteArray_AS_STRING(buffer), pending);
+		assert(xfer != -2); /* Not Implemented? Memory BIOs implement read */
+	}
+	else
+		xfer = 0;
 
-				Py_DECREF(buffer);
-				Py_DECREF(rob);
-				return(NULL);
-			}
-		}
+	if (PyByteArray_Resize(buffer, MAX(0, xfer)) || PyList_Append(rob, buffer))
+	{
+		/* failed to resize and append */
 
-		Py_DECREF(buffer); /* New reference owned by rob; drop our reference. */
+		Py_DECREF(buffer);
+		Py_DECREF(rob);
+		return(NULL);
 	}
-	while (xfer == DEFAULT_READ_SIZE);
 
+	Py_DECREF(buffer); /* New reference owned by rob; drop our reference. */
 	return(rob);
 }
 
@@ -1540,14 +2238,25 @@ transport_leak(PyObj self)
 {
 	Transport tls = (Transport) self;
 
-	SSL_set_quiet_shutdown(tls->tls_state, 1);
+	if (tls->tls_busy)
+		tls->tls_leak_deferred = 1;
+	else
+		SSL_set_quiet_shutdown(tls->tls_state, 1);
+
 	Py_RETURN_NONE;
 }
 
+/**
+	// The worker's output is signalled by the completion; report none while busy.
+*/
 static PyObj
 transport_pending_output(PyObj self)
 {
 	Transport tls = (Transport) self;
+
+	if (tls->tls_busy)
+		return(PyLong_FromLong(0));
+
 	return(PyLong_FromLong(BIO_pending(Transport_GetWriteBuffer(tls))));
 }
 
@@ -1555,17 +2264,32 @@ static PyObj
 transport_pending_input(PyObj self)
 {
 	Transport tls = (Transport) self;
+
+	if (tls->tls_busy)
+		return(PyLong_FromLong(0));
+
 	return(PyLong_FromLong(SSL_pending(tls->tls_state)));
 }
 
 /**
 	// Close writes.
+
+	// While a &Negotiation worker is performing a handshake step, the close is
+	// noted and &False is returned; &transport_settle performs it once the step
+	// completes and the following drain transmits the shutdown.
 */
 static PyObj
 transport_close_output(PyObj self)
 {
 	Transport tls = (Transport) self;
 
+	if (tls->tls_busy)
+	{
+		tls->tls_close_deferred = 1;
+		Py_INCREF(Py_False);
+		return(Py_False);
+	}
+
 	if (SSL_in_init(tls->tls_state))
 	{
 		Py_INCREF(Py_False);
@@ -1616,6 +2340,121 @@ transport_connect_receive_closed(PyObj self, PyObj ob)
 	Py_RETURN_NONE;
 }
 
+#if TRANSPORT_OFFLOAD
+/**
+	// Whether the negotiated state can be handed to the kernel.
+	// Requires a completed TLS 1.3 handshake and no buffered records.
+*/
+static int
+transport_offload_ready(Transport tls)
+{
+	struct transport_offload *ofl = tls->tls_offload;
+
+	if (tls->tls_busy || tls->tls_deferred != NULL)
+		return(0);
+
+	if (!SSL_is_init_finished(tls->tls_state) || SSL_version(tls->tls_state) != TLS1_3_VERSION)
+		return(0);
+
+	if (ofl->ofl_secret_size[0] == 0 || ofl->ofl_secret_size[1] == 0)
+		return(0);
+
+	if (!ofl->ofl_epoch[0] || !ofl->ofl_epoch[1])
+		return(0);
+
+	if (BIO_ctrl_pending(Transport_GetReadBuffer(tls)) || SSL_has_pending(tls->tls_state))
+		return(0);
+
+	if (BIO_ctrl_pending(Transport_GetWriteBuffer(tls)) || output_buffer_has_content(tls) != 0)
+		return(0);
+
+	return(1);
+}
+#endif
+
+/**
+	// Hand the application traffic keys to the kernel for the given socket.
+	// Once offloaded, &transport_encipher and &transport_decipher pass buffers through.
+
+	// Kernels supporting only transmit offload accept the transmit keys and then
+	// reject the receive keys; the socket already enciphers its output at that point.
+	// The OSError is raised and the Transport is marked as failed so that further
+	// transfers raise as well; the caller must close the connection.
+*/
+static PyObj
+transport_offload(PyObj self, PyObj args)
+{
+	Transport tls = (Transport) self;
+	int fd;
+
+	if (!PyArg_ParseTuple(args, "i", &fd))
+		return(NULL);
+
+	if (tls->tls_offload == NULL)
+	{
+		PyErr_SetString(PyExc_RuntimeError, "transport context was not created with offload enabled");
+		return(NULL);
+	}
+
+	if (tls->tls_offload->ofl_offloaded)
+	{
+		Py_INCREF(Py_True);
+		return(Py_True);
+	}
+
+	if (Transport_OffloadFailed(tls))
+		return(NULL);
+
+	#if TRANSPORT_OFFLOAD
+	{
+		union transport_crypto_info rx, tx;
+		socklen_t rxsize = 0, txsize = 0;
+		int r;
+
+		if (!transport_offload_ready(tls)
+			|| !transport_offload_parameters(tls, 0, &rx, &rxsize)
+			|| !transport_offload_parameters(tls, 1, &tx, &txsize))
+		{
+			Py_INCREF(Py_False);
+			return(Py_False);
+		}
+
+		r = setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls"));
+		if (r == 0)
+		{
+			r = setsockopt(fd, SOL_TLS, TLS_TX, &tx, txsize);
+			if (r == 0)
+			{
+				r = setsockopt(fd, SOL_TLS, TLS_RX, &rx, rxsize);
+				if (r != 0)
+				{
+					/* Transmit is enciphered by the kernel; no longer usable. */
+					tls->tls_offload->ofl_failed = 1;
+				}
+			}
+		}
+
+		OPENSSL_cleanse(&rx, sizeof(rx));
+		OPENSSL_cleanse(&tx, sizeof(tx));
+
+		if (r != 0)
+		{
+			PyErr_SetFromErrno(PyExc_OSError);
+			if (tls->tls_offload->ofl_failed)
+				OPENSSL_cleanse(tls->tls_offload->ofl_secrets, sizeof(tls->tls_offload->ofl_secrets));
+			return(NULL);
+		}
+
+		/* The secrets are no longer needed by the process. */
+		OPENSSL_cleanse(tls->tls_offload->ofl_secrets, sizeof(tls->tls_offload->ofl_secrets));
+		tls->tls_offload->ofl_offloaded = 1;
+	}
+	#endif
+
+	Py_INCREF(Py_True);
+	return(Py_True);
+}
+
 static PyMethodDef
 transport_methods[] = {
 	{"status", (PyCFunction) transport_status,
@@ -1658,6 +2497,22 @@ transport_methods[] = {
 		)
 	},
 
+	{"decipher_into", (PyCFunction) transport_decipher_into,
+		METH_VARARGS, PyDoc_STR(
+			"Decrypt the ciphertext buffers into the given writable buffer "
+			"and return the number of plaintext bytes written."
+		)
+	},
+
+	{"offload", (PyCFunction) transport_offload,
+		METH_VARARGS, PyDoc_STR(
+			"Hand the negotiated keys to the kernel for the given socket file descriptor. "
+			"Returns False when the Transport's state does not permit offloading. "
+			"When the kernel accepts only the transmit keys, OSError is raised and the "
+			"Transport refuses further transfers; the connection must be closed."
+		)
+	},
+
 	{"connect_transmit_ready", (PyCFunction) transport_connect_transmit_ready,
 		METH_O, PyDoc_STR("Set callback to be used when an operation causes transmit data.")},
 
@@ -1692,6 +2547,9 @@ transport_get_application(PyObj self, void *_)
 	const unsigned char *data = NULL;
 	unsigned int l = 0;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	SSL_get0_alpn_selected(tls->tls_state, &data, &l);
 	if (l > 0)
 	{
@@ -1714,6 +2572,9 @@ transport_get_hostname(PyObj self, void *_)
 	const char *name = NULL;
 	unsigned int l = 0;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	name = SSL_get_servername(tls->tls_state, TLSEXT_NAMETYPE_host_name);
 	if (name != NULL)
 	{
@@ -1736,7 +2597,12 @@ transport_get_protocol(PyObj self, void *_)
 {
 	Transport tls = (Transport) self;
 	PyObj rob = NULL;
-	const SSL_METHOD *p = SSL_get_ssl_method(tls->tls_state);
+	const SSL_METHOD *p;
+
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
+	p = SSL_get_ssl_method(tls->tls_state);
 
 	#define X_TLS_PROTOCOL(ORG, STD, SID, NAME, MAJOR_VERSION, MINOR_VERSION, OPENSSL_METHOD) \
 		if (p == (OPENSSL_METHOD##_method()) \
@@ -1761,7 +2627,12 @@ transport_get_standard(PyObj self, void *_)
 {
 	Transport tls = (Transport) self;
 	PyObj rob = NULL;
-	const SSL_METHOD *p = SSL_get_ssl_method(tls->tls_state);
+	const SSL_METHOD *p;
+
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
+	p = SSL_get_ssl_method(tls->tls_state);
 
 	#define X_TLS_PROTOCOL(ORG, STD, SID, NAME, MAJOR_VERSION, MINOR_VERSION, OPENSSL_METHOD) \
 		if (p == (OPENSSL_METHOD##_method()) \
@@ -1786,6 +2657,9 @@ transport_get_peer_certificate(PyObj self, void *_)
 {
 	Transport tls = (Transport) self;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	if (tls->tls_peer_certificate != NULL)
 	{
 		Py_INCREF(tls->tls_peer_certificate);
@@ -1818,6 +2692,9 @@ transport_get_receive_closed(PyObj self, void *_)
 {
 	Transport tls = (Transport) self;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	if (SSL_get_shutdown(tls->tls_state) & SSL_RECEIVED_SHUTDOWN)
 	{
 		Py_INCREF(Py_True);
@@ -1833,6 +2710,9 @@ transport_get_transmit_closed(PyObj self, void *_)
 {
 	Transport tls = (Transport) self;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	if (SSL_get_shutdown(tls->tls_state) & SSL_SENT_SHUTDOWN)
 	{
 		Py_INCREF(Py_True);
@@ -1891,6 +2771,9 @@ transport_get_violation(PyObj self, void *_)
 	long vr;
 	const char *x;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	vr = SSL_get_verify_result(tls->tls_state);
 	if (vr == X509_V_OK)
 	{
@@ -1908,6 +2791,9 @@ transport_get_client_ca_list(PyObj self, void *_)
 	STACK_OF(X509_NAME) *calist;
 	int i;
 
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
 	rob = PyList_New(0);
 	calist = SSL_get_client_CA_list(tls->tls_state);
 
@@ -1954,6 +2840,39 @@ transport_get_client_ca_list(PyObj self, void *_)
 	}
 }
 
+static PyObj
+transport_get_offloaded(PyObj self, void *_)
+{
+	Transport tls = (Transport) self;
+
+	if (Transport_Offloaded(tls))
+	{
+		Py_INCREF(Py_True);
+		return(Py_True);
+	}
+
+	Py_INCREF(Py_False);
+	return(Py_False);
+}
+
+static PyObj
+transport_get_resumed(PyObj self, void *_)
+{
+	Transport tls = (Transport) self;
+
+	if (Transport_Negotiating(tls))
+		return(NULL);
+
+	if (SSL_session_reused(tls->tls_state))
+	{
+		Py_INCREF(Py_True);
+		return(Py_True);
+	}
+
+	Py_INCREF(Py_False);
+	return(Py_False);
+}
+
 static PyGetSetDef transport_getset[] = {
 	{"application", transport_get_application, NULL,
 		PyDoc_STR(
@@ -1962,6 +2881,20 @@ static PyGetSetDef transport_getset[] = {
 		NULL,
 	},
 
+	{"resumed", transport_get_resumed, NULL,
+		PyDoc_STR(
+			"Whether the Transport's session was resumed from a previous connection."
+		),
+		NULL,
+	},
+
+	{"offloaded", transport_get_offloaded, NULL,
+		PyDoc_STR(
+			"Whether the Transport's records are processed by the kernel."
+		),
+		NULL,
+	},
+
 	{"hostname", transport_get_hostname, NULL,
 		PyDoc_STR(
 			"Get the hostname used by the Transport"
@@ -2027,7 +2960,10 @@ transport_repr(PyObj self)
 	char *tls_state;
 	PyObj rob;
 
-	tls_state = (char *) SSL_state_string(tls->tls_state);
+	if (tls->tls_busy)
+		tls_state = "negotiating";
+	else
+		tls_state = (char *) SSL_state_string(tls->tls_state);
 
 	rob = PyUnicode_FromFormat("<%s [%s] at %p>", Py_TYPE(self)->tp_name, tls_state, self);
 	return(rob);
@@ -2042,11 +2978,15 @@ transport_clear(PyObj self)
 	Py_XDECREF(tls->ctx_object);
 	Py_XDECREF(tls->recv_closed_cb);
 	Py_XDECREF(tls->send_queued_cb);
+	Py_XDECREF(tls->tls_deferred);
+	Py_XDECREF(tls->tls_failure);
 
 	(tls->output_queue) = NULL;
 	(tls->ctx_object) = NULL;
 	(tls->recv_closed_cb) = NULL;
 	(tls->send_queued_cb) = NULL;
+	(tls->tls_deferred) = NULL;
+	(tls->tls_failure) = NULL;
 
 	return(0);
 }
@@ -2060,6 +3000,8 @@ transport_traverse(PyObj self, visitproc visit, void *arg)
 	Py_VISIT(tls->ctx_object);
 	Py_VISIT(tls->recv_closed_cb);
 	Py_VISIT(tls->send_queued_cb);
+	Py_VISIT(tls->tls_deferred);
+	Py_VISIT(tls->tls_failure);
 
 	return(0);
 }
@@ -2072,6 +3014,13 @@ transport_dealloc(PyObj self)
 	if (tls->tls_state == NULL)
 		SSL_free(tls->tls_state);
 
+	if (tls->tls_offload != NULL)
+	{
+		OPENSSL_cleanse(tls->tls_offload, sizeof(struct transport_offload));
+		PyMem_Free(tls->tls_offload);
+		tls->tls_offload = NULL;
+	}
+
 	transport_clear(self);
 	Py_TYPE(self)->tp_free(self);
 }
@@ -2209,10 +3158,14 @@ TransportType = {
 	transport_new,                   /* tp_new */
 };
 
+#include "openssl-negotiation.h"
+
 #define PYTHON_TYPES() \
 	ID(EData) \
 	ID(Certificate) \
 	ID(Context) \
+	ID(Sessions) \
+	ID(Negotiation) \
 	ID(Transport)
 
 #define MODULE_FUNCTIONS()
@@ -2254,6 +3207,16 @@ init_implementation_data(PyObj module)
 	if (PyModule_AddIntConstant(module, "version_code", OPENSSL_VERSION_NUMBER))
 		goto error;
 
+	if (sessions_index < 0)
+	{
+		sessions_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+		if (sessions_index < 0)
+		{
+			library_error();
+			goto error;
+		}
+	}
+
 	if (PyModule_AddStringConstant(module, "version", OPENSSL_VERSION_TEXT))
 		goto error;
 
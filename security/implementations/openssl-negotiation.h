@@ -0,0 +1,388 @@
+/**
+	// Worker threads performing handshakes without the GIL.
+
+	// While a Transport is negotiating on a worker, it is marked busy and
+	// received ciphertext is retained by &transport_decipher until the
+	// completion callable has been invoked. Other methods accessing the SSL
+	// state either defer their effect to the completion, or raise.
+*/
+
+struct negotiation {
+	struct negotiation *n_next;
+	Transport n_transport;
+	PyObj n_completion;
+};
+
+/**
+	// Thread shared state; released by the last exiting worker once the
+	// Python object has been deallocated.
+*/
+struct negotiation_pool {
+	pthread_mutex_t np_lock;
+	pthread_cond_t np_ready;
+
+	struct negotiation *np_head, *np_tail;
+	int np_limit, np_threads, np_idle;
+	char np_terminating;
+};
+
+struct Negotiation {
+	PyObject_HEAD
+	struct negotiation_pool *ng_pool;
+};
+typedef struct Negotiation *Negotiation;
+
+static PyTypeObject NegotiationType;
+
+/**
+	// Perform the handshake step and signal the completion with the GIL.
+*/
+static void
+negotiation_perform(struct negotiation *job)
+{
+	Transport tls = job->n_transport;
+	PyGILState_STATE gs;
+	PyObj cbout;
+	int r;
+
+	r = SSL_do_handshake(tls->tls_state);
+
+	gs = PyGILState_Ensure();
+	{
+		/* OpenSSL's error queue is per-thread; convert it here. */
+		if (r <= 0 && library_error())
+		{
+			PyObj exc, val, tb;
+
+			PyErr_Fetch(&exc, &val, &tb);
+			PyErr_NormalizeException(&exc, &val, &tb);
+			Py_XDECREF(exc);
+			Py_XDECREF(tb);
+
+			Py_XDECREF(tls->tls_failure);
+			tls->tls_failure = val;
+		}
+
+		tls->tls_busy = 0;
+		transport_settle(tls);
+
+		cbout = PyObject_CallObject(job->n_completion, NULL);
+		if (cbout != NULL)
+			Py_DECREF(cbout);
+		else
+			PyErr_WriteUnraisable(job->n_completion);
+
+		Py_DECREF(job->n_completion);
+		Py_DECREF((PyObj) tls);
+	}
+	PyGILState_Release(gs);
+
+	free(job);
+}
+
+static void *
+negotiation_worker(void *arg)
+{
+	struct negotiation_pool *np = arg;
+	struct negotiation *job;
+	int last = 0;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&np->np_lock);
+		{
+			while (np->np_head == NULL && !np->np_terminating)
+			{
+				np->np_idle += 1;
+				pthread_cond_wait(&np->np_ready, &np->np_lock);
+				np->np_idle -= 1;
+			}
+
+			job = np->np_head;
+			if (job != NULL)
+			{
+				np->np_head = job->n_next;
+				if (np->np_head == NULL)
+					np->np_tail = NULL;
+			}
+			else
+			{
+				/* Terminating and drained. */
+				np->np_threads -= 1;
+				last = (np->np_threads == 0);
+			}
+		}
+		pthread_mutex_unlock(&np->np_lock);
+
+		if (job == NULL)
+			break;
+
+		negotiation_perform(job);
+	}
+
+	if (last)
+	{
+		pthread_cond_destroy(&np->np_ready);
+		pthread_mutex_destroy(&np->np_lock);
+		free(np);
+	}
+
+	return(NULL);
+}
+
+/**
+	// Queue the job and start a worker if none are idle and the limit allows.
+*/
+static int
+negotiation_enqueue(struct negotiation_pool *np, struct negotiation *job)
+{
+	pthread_t tid;
+	int r = 0;
+
+	pthread_mutex_lock(&np->np_lock);
+	{
+		job->n_next = NULL;
+		if (np->np_tail != NULL)
+			np->np_tail->n_next = job;
+		else
+			np->np_head = job;
+		np->np_tail = job;
+
+		if (np->np_idle == 0 && np->np_threads < np->np_limit)
+		{
+			r = pthread_create(&tid, NULL, negotiation_worker, np);
+			if (r == 0)
+			{
+				pthread_detach(tid);
+				np->np_threads += 1;
+			}
+			else if (np->np_threads > 0)
+			{
+				/* Existing workers will process the job. */
+				r = 0;
+			}
+			else
+			{
+				np->np_head = np->np_tail = NULL;
+			}
+		}
+
+		pthread_cond_signal(&np->np_ready);
+	}
+	pthread_mutex_unlock(&np->np_lock);
+
+	return(r);
+}
+
+/**
+	// Perform the Transport's handshake on a worker thread.
+*/
+static PyObj
+negotiation_negotiate(PyObj self, PyObj args)
+{
+	Negotiation ng = (Negotiation) self;
+	Transport tls;
+	PyObj buffer_sequence, completion;
+	struct negotiation *job;
+	int r;
+
+	if (!PyArg_ParseTuple(args, "O!OO", &TransportType, &tls, &buffer_sequence, &completion))
+		return(NULL);
+
+	if (tls->tls_busy)
+	{
+		if (transport_defer(tls, buffer_sequence))
+			return(NULL);
+
+		Py_INCREF(Py_True);
+		return(Py_True);
+	}
+
+	/* Negotiated or failed; the caller deciphers directly. */
+	if (tls->tls_failure != NULL || Transport_Offloaded(tls) || !SSL_in_init(tls->tls_state))
+	{
+		Py_INCREF(Py_False);
+		return(Py_False);
+	}
+
+	if (transport_resume(tls) || transport_inject(tls, buffer_sequence))
+		return(NULL);
+
+	/* Nothing to progress the handshake with. */
+	if (BIO_ctrl_pending(Transport_GetReadBuffer(tls)) == 0)
+	{
+		Py_INCREF(Py_True);
+		return(Py_True);
+	}
+
+	job = malloc(sizeof(struct negotiation));
+	if (job == NULL)
+		return(PyErr_NoMemory());
+
+	job->n_transport = tls;
+	job->n_completion = completion;
+	Py_INCREF((PyObj) tls);
+	Py_INCREF(completion);
+	tls->tls_busy = 1;
+
+	r = negotiation_enqueue(ng->ng_pool, job);
+	if (r != 0)
+	{
+		tls->tls_busy = 0;
+		Py_DECREF(completion);
+		Py_DECREF((PyObj) tls);
+		free(job);
+
+		errno = r;
+		PyErr_SetFromErrno(PyExc_OSError);
+		return(NULL);
+	}
+
+	Py_INCREF(Py_True);
+	return(Py_True);
+}
+
+static PyMethodDef
+negotiation_methods[] = {
+	{"negotiate", (PyCFunction) negotiation_negotiate,
+		METH_VARARGS, PyDoc_STR(
+			"Write the ciphertext buffers into the Transport and progress its handshake "
+			"on a worker thread calling the completion with the GIL when finished. "
+			"Returns False when the Transport is not negotiating."
+		)
+	},
+
+	{NULL,},
+};
+
+static PyObj
+negotiation_get_threads(PyObj self, void *_)
+{
+	Negotiation ng = (Negotiation) self;
+	int n;
+
+	pthread_mutex_lock(&ng->ng_pool->np_lock);
+	n = ng->ng_pool->np_threads;
+	pthread_mutex_unlock(&ng->ng_pool->np_lock);
+
+	return(PyLong_FromLong(n));
+}
+
+static PyGetSetDef negotiation_getset[] = {
+	{"threads", negotiation_get_threads, NULL,
+		PyDoc_STR(
+			"The number of running worker threads."
+		),
+		NULL,
+	},
+
+	{NULL,},
+};
+
+static void
+negotiation_dealloc(PyObj self)
+{
+	Negotiation ng = (Negotiation) self;
+	struct negotiation_pool *np = ng->ng_pool;
+	int release = 0;
+
+	if (np != NULL)
+	{
+		pthread_mutex_lock(&np->np_lock);
+		{
+			np->np_terminating = 1;
+			release = (np->np_threads == 0);
+			pthread_cond_broadcast(&np->np_ready);
+		}
+		pthread_mutex_unlock(&np->np_lock);
+
+		if (release)
+		{
+			pthread_cond_destroy(&np->np_ready);
+			pthread_mutex_destroy(&np->np_lock);
+			free(np);
+		}
+	}
+
+	Py_TYPE(self)->tp_free(self);
+}
+
+static PyObj
+negotiation_new(PyTypeObject *subtype, PyObj args, PyObj kw)
+{
+	static char *kwlist[] = {"limit", NULL,};
+	struct negotiation_pool *np;
+	Negotiation ng;
+	int limit = 4;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "|i", kwlist, &limit))
+		return(NULL);
+
+	if (limit < 1)
+	{
+		PyErr_SetString(PyExc_ValueError, "negotiation limit must be positive");
+		return(NULL);
+	}
+
+	ng = (Negotiation) subtype->tp_alloc(subtype, 0);
+	if (ng == NULL)
+		return(NULL);
+
+	np = calloc(1, sizeof(struct negotiation_pool));
+	if (np == NULL)
+	{
+		Py_DECREF(ng);
+		return(PyErr_NoMemory());
+	}
+
+	pthread_mutex_init(&np->np_lock, NULL);
+	pthread_cond_init(&np->np_ready, NULL);
+	np->np_limit = limit;
+	ng->ng_pool = np;
+
+	return((PyObj) ng);
+}
+
+PyDoc_STRVAR(negotiation_doc, "Bounded set of threads performing Transport handshakes.");
+
+static PyTypeObject
+NegotiationType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	PYTHON_MODULE_PATH("Negotiation"), /* tp_name */
+	sizeof(struct Negotiation),        /* tp_basicsize */
+	0,                                 /* tp_itemsize */
+	negotiation_dealloc,               /* tp_dealloc */
+	0,                                 /* (tp_print) */
+	NULL,                              /* tp_getattr */
+	NULL,                              /* tp_setattr */
+	NULL,                              /* tp_compare */
+	NULL,                              /* tp_repr */
+	NULL,                              /* tp_as_number */
+	NULL,                              /* tp_as_sequence */
+	NULL,                              /* tp_as_mapping */
+	NULL,                              /* tp_hash */
+	NULL,                              /* tp_call */
+	NULL,                              /* tp_str */
+	NULL,                              /* tp_getattro */
+	NULL,                              /* tp_setattro */
+	NULL,                              /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,                /* tp_flags */
+	negotiation_doc,                   /* tp_doc */
+	NULL,                              /* tp_traverse */
+	NULL,                              /* tp_clear */
+	NULL,                              /* tp_richcompare */
+	0,                                 /* tp_weaklistoffset */
+	NULL,                              /* tp_iter */
+	NULL,                              /* tp_iternext */
+	negotiation_methods,               /* tp_methods */
+	NULL,                              /* tp_members */
+	negotiation_getset,                /* tp_getset */
+	NULL,                              /* tp_base */
+	NULL,                              /* tp_dict */
+	NULL,                              /* tp_descr_get */
+	NULL,                              /* tp_descr_set */
+	0,                                 /* tp_dictoffset */
+	NULL,                              /* tp_init */
+	NULL,                              /* tp_alloc */
+	negotiation_new,                   /* tp_new */
+};
@@ -0,0 +1,735 @@
+/**
+	// Session resumption storage shared by Contexts.
+
+	// Servers store sessions by identifier and clients by hostname.
+	// Entries are DER encoded and evicted in least recently used order.
+	// The ticket keys used for stateless resumption are held alongside.
+*/
+#include <pthread.h>
+#include <openssl/rand.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	#include <openssl/core_names.h>
+#else
+	#include <openssl/hmac.h>
+#endif
+
+#define SESSIONS_KEY_SIZE (1 + 255)
+#define SESSIONS_SERVER_KEY 's'
+#define SESSIONS_CLIENT_KEY 'c'
+
+struct session_entry {
+	struct session_entry *se_next; /* hash chain */
+	struct session_entry *se_newer, *se_older;
+
+	unsigned long se_hash;
+	unsigned int se_keysize;
+	unsigned char se_key[SESSIONS_KEY_SIZE];
+
+	long se_size;
+	unsigned char *se_data;
+};
+
+/**
+	// Ticket key file record: name, HMAC key, and AES key.
+*/
+struct ticket_key {
+	unsigned char tk_name[16];
+	unsigned char tk_hmac[32];
+	unsigned char tk_aes[32];
+};
+
+/**
+	// Sessions object structure.
+*/
+struct Sessions {
+	PyObject_HEAD
+	pthread_mutex_t s_lock;
+
+	struct session_entry **s_table;
+	size_t s_buckets;
+	struct session_entry *s_newest, *s_oldest;
+	Py_ssize_t s_capacity, s_count;
+
+	/* First key is used for encryption; all are used for decryption. */
+	struct ticket_key *s_keys;
+	Py_ssize_t s_nkeys;
+
+	unsigned long long s_hits, s_misses, s_tickets;
+};
+typedef struct Sessions *Sessions;
+
+static PyTypeObject SessionsType;
+
+/**
+	// SSL_CTX ex_data index referring to the Sessions instance.
+*/
+static int sessions_index = -1;
+
+#define Sessions_FromContext(SCTX) ((Sessions) SSL_CTX_get_ex_data(SCTX, sessions_index))
+#define sessions_lock(S) pthread_mutex_lock(&(S)->s_lock)
+#define sessions_unlock(S) pthread_mutex_unlock(&(S)->s_lock)
+
+static unsigned long
+sessions_hash(const unsigned char *key, unsigned int size)
+{
+	unsigned long h = 2166136261UL;
+	unsigned int i;
+
+	for (i = 0; i < size; ++i)
+	{
+		h ^= key[i];
+		h *= 16777619UL;
+	}
+
+	return(h);
+}
+
+static struct session_entry *
+sessions_find(Sessions s, const unsigned char *key, unsigned int size, unsigned long h)
+{
+	struct session_entry *e;
+
+	for (e = s->s_table[h % s->s_buckets]; e != NULL; e = e->se_next)
+	{
+		if (e->se_hash == h && e->se_keysize == size && memcmp(e->se_key, key, size) == 0)
+			return(e);
+	}
+
+	return(NULL);
+}
+
+/**
+	// Remove the entry from the recency list.
+*/
+static void
+sessions_detach(Sessions s, struct session_entry *e)
+{
+	if (e->se_newer != NULL)
+		e->se_newer->se_older = e->se_older;
+	else
+		s->s_newest = e->se_older;
+
+	if (e->se_older != NULL)
+		e->se_older->se_newer = e->se_newer;
+	else
+		s->s_oldest = e->se_newer;
+
+	e->se_newer = e->se_older = NULL;
+}
+
+static void
+sessions_attach(Sessions s, struct session_entry *e)
+{
+	e->se_older = s->s_newest;
+	e->se_newer = NULL;
+
+	if (s->s_newest != NULL)
+		s->s_newest->se_newer = e;
+	else
+		s->s_oldest = e;
+
+	s->s_newest = e;
+}
+
+static void
+sessions_discard(Sessions s, struct session_entry *e)
+{
+	struct session_entry **chain = &(s->s_table[e->se_hash % s->s_buckets]);
+
+	while (*chain != e)
+		chain = &((*chain)->se_next);
+	*chain = e->se_next;
+
+	sessions_detach(s, e);
+	s->s_count -= 1;
+
+	OPENSSL_free(e->se_data);
+	free(e);
+}
+
+/**
+	// Store the session under the given key replacing any existing entry.
+*/
+static void
+sessions_store(Sessions s, const unsigned char *key, unsigned int size, SSL_SESSION *sess)
+{
+	struct session_entry *e;
+	unsigned char *data = NULL;
+	unsigned long h = sessions_hash(key, size);
+	int dsize;
+
+	dsize = i2d_SSL_SESSION(sess, &data);
+	if (dsize <= 0)
+		return;
+
+	sessions_lock(s);
+	{
+		e = sessions_find(s, key, size, h);
+		if (e != NULL)
+			sessions_discard(s, e);
+
+		while (s->s_count >= s->s_capacity && s->s_oldest != NULL)
+			sessions_discard(s, s->s_oldest);
+
+		e = malloc(sizeof(struct session_entry));
+		if (e != NULL)
+		{
+			e->se_hash = h;
+			e->se_keysize = size;
+			memcpy(e->se_key, key, size);
+			e->se_size = dsize;
+			e->se_data = data;
+			data = NULL;
+
+			e->se_next = s->s_table[h % s->s_buckets];
+			s->s_table[h % s->s_buckets] = e;
+			sessions_attach(s, e);
+			s->s_count += 1;
+		}
+	}
+	sessions_unlock(s);
+
+	if (data != NULL)
+		OPENSSL_free(data);
+}
+
+/**
+	// Decode the session stored under the given key.
+	// Returns a new session reference or NULL when missing.
+*/
+static SSL_SESSION *
+sessions_load(Sessions s, const unsigned char *key, unsigned int size)
+{
+	struct session_entry *e;
+	SSL_SESSION *sess = NULL;
+	const unsigned char *data;
+
+	sessions_lock(s);
+	{
+		e = sessions_find(s, key, size, sessions_hash(key, size));
+		if (e != NULL)
+		{
+			data = e->se_data;
+			sess = d2i_SSL_SESSION(NULL, &data, e->se_size);
+
+			sessions_detach(s, e);
+			sessions_attach(s, e);
+		}
+
+		if (sess != NULL)
+			s->s_hits += 1;
+		else
+			s->s_misses += 1;
+	}
+	sessions_unlock(s);
+
+	return(sess);
+}
+
+static void
+sessions_remove(Sessions s, const unsigned char *key, unsigned int size)
+{
+	struct session_entry *e;
+
+	sessions_lock(s);
+	{
+		e = sessions_find(s, key, size, sessions_hash(key, size));
+		if (e != NULL)
+			sessions_discard(s, e);
+	}
+	sessions_unlock(s);
+}
+
+/**
+	// Construct the storage key of a session.
+	// Servers use the session identifier; clients use the hostname.
+*/
+static unsigned int
+sessions_key(unsigned char *key, char role, const unsigned char *id, size_t size)
+{
+	if (size > SESSIONS_KEY_SIZE - 1)
+		size = SESSIONS_KEY_SIZE - 1;
+
+	key[0] = role;
+	memcpy(key + 1, id, size);
+	return(size + 1);
+}
+
+static unsigned int
+sessions_host_key(unsigned char *key, const SSL *ssl)
+{
+	const char *hostname = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+
+	if (hostname == NULL)
+		return(0);
+
+	return(sessions_key(key, SESSIONS_CLIENT_KEY, (const unsigned char *) hostname, strlen(hostname)));
+}
+
+/**
+	// SSL_CTX_sess_set_new_cb callback.
+*/
+static int
+sessions_new_cb(SSL *ssl, SSL_SESSION *sess)
+{
+	Sessions s = Sessions_FromContext(SSL_get_SSL_CTX(ssl));
+	unsigned char key[SESSIONS_KEY_SIZE];
+	unsigned int size, idsize = 0;
+	const unsigned char *id;
+
+	if (s == NULL)
+		return(0);
+
+	if (SSL_is_server(ssl))
+	{
+		id = SSL_SESSION_get_id(sess, &idsize);
+		size = sessions_key(key, SESSIONS_SERVER_KEY, id, idsize);
+	}
+	else
+	{
+		size = sessions_host_key(key, ssl);
+		if (size == 0)
+			return(0);
+	}
+
+	sessions_store(s, key, size, sess);
+
+	/* Not retaining the reference. */
+	return(0);
+}
+
+/**
+	// SSL_CTX_sess_set_get_cb callback for servers.
+*/
+static SSL_SESSION *
+sessions_get_cb(SSL *ssl, const unsigned char *id, int idsize, int *copy)
+{
+	Sessions s = Sessions_FromContext(SSL_get_SSL_CTX(ssl));
+	unsigned char key[SESSIONS_KEY_SIZE];
+	unsigned int size;
+
+	*copy = 0;
+	if (s == NULL)
+		return(NULL);
+
+	size = sessions_key(key, SESSIONS_SERVER_KEY, id, idsize);
+	return(sessions_load(s, key, size));
+}
+
+/**
+	// SSL_CTX_sess_set_remove_cb callback.
+*/
+static void
+sessions_remove_cb(SSL_CTX *sctx, SSL_SESSION *sess)
+{
+	Sessions s = Sessions_FromContext(sctx);
+	unsigned char key[SESSIONS_KEY_SIZE];
+	unsigned int size, idsize = 0;
+	const unsigned char *id;
+
+	if (s == NULL)
+		return;
+
+	id = SSL_SESSION_get_id(sess, &idsize);
+	if (idsize == 0)
+		return;
+
+	size = sessions_key(key, SESSIONS_SERVER_KEY, id, idsize);
+	sessions_remove(s, key, size);
+}
+
+/**
+	// Assign the stored session of the client's hostname for resumption.
+*/
+static void
+sessions_resume(Sessions s, SSL *ssl)
+{
+	unsigned char key[SESSIONS_KEY_SIZE];
+	unsigned int size;
+	SSL_SESSION *sess;
+
+	size = sessions_host_key(key, ssl);
+	if (size == 0)
+		return;
+
+	sess = sessions_load(s, key, size);
+	if (sess != NULL)
+	{
+		SSL_set_session(ssl, sess);
+		SSL_SESSION_free(sess);
+	}
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	#define TICKET_MAC_CTX EVP_MAC_CTX
+#else
+	#define TICKET_MAC_CTX HMAC_CTX
+#endif
+
+static int
+ticket_mac_init(TICKET_MAC_CTX *hctx, struct ticket_key *tk)
+{
+	#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		OSSL_PARAM params[3];
+
+		params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+			tk->tk_hmac, sizeof(tk->tk_hmac));
+		params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "sha256", 0);
+		params[2] = OSSL_PARAM_construct_end();
+
+		return(EVP_MAC_CTX_set_params(hctx, params));
+	#else
+		return(HMAC_Init_ex(hctx, tk->tk_hmac, sizeof(tk->tk_hmac), EVP_sha256(), NULL));
+	#endif
+}
+
+/**
+	// Session ticket key callback using the rotated key set.
+	// Tickets encrypted with a previous key are accepted and renewed.
+*/
+static int
+sessions_ticket_cb(SSL *ssl, unsigned char name[16], unsigned char *iv,
+	EVP_CIPHER_CTX *cctx, TICKET_MAC_CTX *hctx, int enc)
+{
+	Sessions s = Sessions_FromContext(SSL_get_SSL_CTX(ssl));
+	struct ticket_key tk;
+	Py_ssize_t i;
+	int r = 0;
+
+	if (s == NULL)
+		return(0);
+
+	sessions_lock(s);
+	{
+		if (enc)
+		{
+			if (s->s_nkeys > 0)
+			{
+				tk = s->s_keys[0];
+				r = 1;
+			}
+		}
+		else
+		{
+			for (i = 0; i < s->s_nkeys; ++i)
+			{
+				if (memcmp(name, s->s_keys[i].tk_name, sizeof(tk.tk_name)) == 0)
+				{
+					tk = s->s_keys[i];
+					s->s_tickets += 1;
+
+					/* Renew tickets encrypted with an older key. */
+					r = (i == 0) ? 1 : 2;
+					break;
+				}
+			}
+		}
+	}
+	sessions_unlock(s);
+
+	if (r == 0)
+		return(0);
+
+	if (enc)
+	{
+		memcpy(name, tk.tk_name, sizeof(tk.tk_name));
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0)
+			r = -1;
+		else if (!EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, tk.tk_aes, iv))
+			r = -1;
+	}
+	else
+	{
+		if (!EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, tk.tk_aes, iv))
+			r = -1;
+	}
+
+	if (r > 0 && !ticket_mac_init(hctx, &tk))
+		r = -1;
+
+	OPENSSL_cleanse(&tk, sizeof(tk));
+	return(r);
+}
+
+/**
+	// Configure the SSL_CTX to use the Sessions instance.
+*/
+static int
+sessions_connect(Sessions s, SSL_CTX *sctx)
+{
+	static const unsigned char sid_context[] = "fault.security";
+
+	if (!SSL_CTX_set_ex_data(sctx, sessions_index, s))
+		return(0);
+
+	if (!SSL_CTX_set_session_id_context(sctx, sid_context, sizeof(sid_context) - 1))
+		return(0);
+
+	SSL_CTX_set_session_cache_mode(sctx, SSL_SESS_CACHE_BOTH|SSL_SESS_CACHE_NO_INTERNAL);
+	SSL_CTX_sess_set_new_cb(sctx, sessions_new_cb);
+	SSL_CTX_sess_set_get_cb(sctx, sessions_get_cb);
+	SSL_CTX_sess_set_remove_cb(sctx, sessions_remove_cb);
+
+	#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		SSL_CTX_set_tlsext_ticket_key_evp_cb(sctx, sessions_ticket_cb);
+	#else
+		SSL_CTX_set_tlsext_ticket_key_cb(sctx, sessions_ticket_cb);
+	#endif
+
+	return(1);
+}
+
+/**
+	// Replace the ticket keys with those stored in the file at the given path.
+*/
+static PyObj
+sessions_rotate(PyObj self, PyObj args)
+{
+	Sessions s = (Sessions) self;
+	struct ticket_key *keys, *old;
+	Py_ssize_t nkeys;
+	PyObj path = NULL;
+	FILE *fp;
+	long size;
+
+	if (!PyArg_ParseTuple(args, "O&", PyUnicode_FSConverter, &path))
+		return(NULL);
+
+	Py_BEGIN_ALLOW_THREADS
+	fp = fopen(PyBytes_AS_STRING(path), "rb");
+	Py_END_ALLOW_THREADS
+	Py_DECREF(path);
+
+	if (fp == NULL)
+	{
+		PyErr_SetFromErrno(PyExc_OSError);
+		return(NULL);
+	}
+
+	if (fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET))
+	{
+		PyErr_SetFromErrno(PyExc_OSError);
+		fclose(fp);
+		return(NULL);
+	}
+
+	if (size == 0 || size % sizeof(struct ticket_key) != 0)
+	{
+		fclose(fp);
+		PyErr_Format(PyExc_ValueError,
+			"ticket key file must consist of %d byte records", (int) sizeof(struct ticket_key));
+		return(NULL);
+	}
+
+	nkeys = size / sizeof(struct ticket_key);
+	keys = PyMem_Malloc(size);
+	if (keys == NULL)
+	{
+		fclose(fp);
+		return(PyErr_NoMemory());
+	}
+
+	if (fread(keys, sizeof(struct ticket_key), nkeys, fp) != (size_t) nkeys)
+	{
+		PyErr_SetFromErrno(PyExc_OSError);
+		fclose(fp);
+		OPENSSL_cleanse(keys, size);
+		PyMem_Free(keys);
+		return(NULL);
+	}
+	fclose(fp);
+
+	sessions_lock(s);
+	{
+		old = s->s_keys;
+		size = s->s_nkeys * sizeof(struct ticket_key);
+
+		s->s_keys = keys;
+		s->s_nkeys = nkeys;
+	}
+	sessions_unlock(s);
+
+	if (old != NULL)
+	{
+		OPENSSL_cleanse(old, size);
+		PyMem_Free(old);
+	}
+
+	return(PyLong_FromSsize_t(nkeys));
+}
+
+static PyObj
+sessions_clear(PyObj self)
+{
+	Sessions s = (Sessions) self;
+
+	sessions_lock(s);
+	{
+		while (s->s_oldest != NULL)
+			sessions_discard(s, s->s_oldest);
+	}
+	sessions_unlock(s);
+
+	Py_RETURN_NONE;
+}
+
+static PyMethodDef
+sessions_methods[] = {
+	{"rotate", (PyCFunction) sessions_rotate,
+		METH_VARARGS, PyDoc_STR(
+			"Load the session ticket keys from the file at the given path. "
+			"The first key encrypts new tickets; the others are accepted and renewed."
+		)
+	},
+
+	{"clear", (PyCFunction) sessions_clear,
+		METH_NOARGS, PyDoc_STR(
+			"Remove all the stored sessions."
+		)
+	},
+
+	{NULL,},
+};
+
+static PyMemberDef
+sessions_members[] = {
+	{"capacity", T_PYSSIZET,
+		offsetof(struct Sessions, s_capacity), READONLY,
+		PyDoc_STR("Maximum number of stored sessions.")
+	},
+	{"count", T_PYSSIZET,
+		offsetof(struct Sessions, s_count), READONLY,
+		PyDoc_STR("Number of stored sessions.")
+	},
+	{"hits", T_ULONGLONG,
+		offsetof(struct Sessions, s_hits), READONLY,
+		PyDoc_STR("Number of lookups that found a stored session.")
+	},
+	{"misses", T_ULONGLONG,
+		offsetof(struct Sessions, s_misses), READONLY,
+		PyDoc_STR("Number of lookups that did not find a stored session.")
+	},
+	{"tickets", T_ULONGLONG,
+		offsetof(struct Sessions, s_tickets), READONLY,
+		PyDoc_STR("Number of session tickets decrypted with a known key.")
+	},
+	{NULL,},
+};
+
+static void
+sessions_dealloc(PyObj self)
+{
+	Sessions s = (Sessions) self;
+
+	if (s->s_table != NULL)
+	{
+		while (s->s_oldest != NULL)
+			sessions_discard(s, s->s_oldest);
+		PyMem_Free(s->s_table);
+	}
+
+	if (s->s_keys != NULL)
+	{
+		OPENSSL_cleanse(s->s_keys, s->s_nkeys * sizeof(struct ticket_key));
+		PyMem_Free(s->s_keys);
+	}
+
+	pthread_mutex_destroy(&s->s_lock);
+	Py_TYPE(self)->tp_free(self);
+}
+
+static PyObj
+sessions_new(PyTypeObject *subtype, PyObj args, PyObj kw)
+{
+	static char *kwlist[] = {"capacity", NULL,};
+	Py_ssize_t capacity = 1024 * 20;
+	Sessions s;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "|n", kwlist, &capacity))
+		return(NULL);
+
+	if (capacity < 1)
+	{
+		PyErr_SetString(PyExc_ValueError, "session capacity must be positive");
+		return(NULL);
+	}
+
+	s = (Sessions) subtype->tp_alloc(subtype, 0);
+	if (s == NULL)
+		return(NULL);
+
+	pthread_mutex_init(&s->s_lock, NULL);
+	s->s_capacity = capacity;
+	s->s_buckets = (size_t) capacity;
+	s->s_table = PyMem_Calloc(s->s_buckets, sizeof(struct session_entry *));
+	if (s->s_table == NULL)
+	{
+		Py_DECREF(s);
+		return(PyErr_NoMemory());
+	}
+
+	/* Initial ticket key so tickets can be issued before any rotation. */
+	s->s_keys = PyMem_Malloc(sizeof(struct ticket_key));
+	if (s->s_keys == NULL)
+	{
+		Py_DECREF(s);
+		return(PyErr_NoMemory());
+	}
+
+	if (RAND_bytes((unsigned char *) s->s_keys, sizeof(struct ticket_key)) <= 0)
+	{
+		PyMem_Free(s->s_keys);
+		s->s_keys = NULL;
+		Py_DECREF(s);
+		library_error();
+		return(NULL);
+	}
+	s->s_nkeys = 1;
+
+	return((PyObj) s);
+}
+
+PyDoc_STRVAR(sessions_doc, "Session resumption storage that can be shared by Contexts.");
+
+static PyTypeObject
+SessionsType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	PYTHON_MODULE_PATH("Sessions"),  /* tp_name */
+	sizeof(struct Sessions),         /* tp_basicsize */
+	0,                               /* tp_itemsize */
+	sessions_dealloc,                /* tp_dealloc */
+	0,                               /* (tp_print) */
+	NULL,                            /* tp_getattr */
+	NULL,                            /* tp_setattr */
+	NULL,                            /* tp_compare */
+	NULL,                            /* tp_repr */
+	NULL,                            /* tp_as_number */
+	NULL,                            /* tp_as_sequence */
+	NULL,                            /* tp_as_mapping */
+	NULL,                            /* tp_hash */
+	NULL,                            /* tp_call */
+	NULL,                            /* tp_str */
+	NULL,                            /* tp_getattro */
+	NULL,                            /* tp_setattro */
+	NULL,                            /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,              /* tp_flags */
+	sessions_doc,                    /* tp_doc */
+	NULL,                            /* tp_traverse */
+	NULL,                            /* tp_clear */
+	NULL,                            /* tp_richcompare */
+	0,                               /* tp_weaklistoffset */
+	NULL,                            /* tp_iter */
+	NULL,                            /* tp_iternext */
+	sessions_methods,                /* tp_methods */
+	sessions_members,                /* tp_members */
+	NULL,                            /* tp_getset */
+	NULL,                            /* tp_base */
+	NULL,                            /* tp_dict */
+	NULL,                            /* tp_descr_get */
+	NULL,                            /* tp_descr_set */
+	0,                               /* tp_dictoffset */
+	NULL,                            /* tp_init */
+	NULL,                            /* tp_alloc */
+	sessions_new,                    /* tp_new */
+};
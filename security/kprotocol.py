@@ -3,6 +3,7 @@
 """
 import weakref
 import types
+import functools
 import importlib.machinery
 
 from ..context import weak
@@ -121,8 +122,41 @@ class SecuredReceive(flows.Protocol):
 	# Transport stack entry for secured input.
 	# Holds a strong reference to the corresponding &SecuredTransmit instance
 	# using &srx_transmit_channel.
+
+	# [ Properties ]
+	# /srx_negotiate/
+		# Callable performing handshake transfers on worker threads;
+		# &None when deciphering is always performed directly.
+		# Cleared once the handshake has completed.
+	# /srx_completion/
+		# The callable given to &srx_negotiate that causes &srx_negotiated
+		# to be performed by the task queue.
 	"""
 
+	srx_negotiate = None
+	srx_completion = None
+
+	def srx_negotiated(self):
+		"""
+		# Continue processing after a handshake step completed on a worker.
+		"""
+		if self.terminated:
+			return
+
+		self.srx_transmit_channel.p_drain()
+		self.f_transfer(())
+
+	def f_transfer(self, event):
+		if self.srx_negotiate is not None:
+			if self.srx_negotiate(event, self.srx_completion):
+				return
+
+			# Negotiated; decipher directly.
+			self.srx_negotiate = None
+			self.srx_completion = None
+
+		return super().f_transfer(event)
+
 	def interrupt(self):
 		super().interrupt()
 		self.srx_transmit_channel.stx_receive_interrupt()
@@ -138,9 +172,18 @@ class SecuredReceive(flows.Protocol):
 			self.srx_transmit_channel.stx_receive_interrupt()
 		self._f_terminated()
 
-def allocate(tls, Method=weak.Method, Reference=weakref.ref):
+def allocate(tls, negotiation=None, enqueue=None, Method=weak.Method, Reference=weakref.ref):
 	"""
 	# Construct a protocol stack pair using the given &tls instance.
+
+	# [ Parameters ]
+	# /negotiation/
+		# Optional worker pool performing the handshake without the GIL.
+		# Requires &enqueue. Opt-in; the &..web stacks allocate without a pool
+		# and decipher handshakes directly.
+	# /enqueue/
+		# Thread safe task queue entry point used to signal handshake completion;
+		# normally, the &Scheduler.enqueue method of the executing context.
 	"""
 
 	stx = SecuredTransmit(tls, None, tls.encipher)
@@ -155,4 +198,8 @@ def allocate(tls, Method=weak.Method, Reference=weakref.ref):
 	ptermd = Method(srx.p_terminated).zero
 	tls.connect_receive_closed(ptermd)
 
+	if negotiation is not None:
+		srx.srx_negotiate = functools.partial(negotiation.negotiate, tls)
+		srx.srx_completion = functools.partial(enqueue, Method(srx.srx_negotiated).zero)
+
 	return (srx, stx)
@@ -29,24 +29,91 @@
 	SA(POSIX_SPAWN_SETSCHEDPARAM, set_schedular_parameter)
 
 extern char **environ;
-STATIC(PyObj)
-inv_spawn(PyObj self, PyObj args, PyObj kw)
+
+#ifdef __linux__
+	int pidfd_open(pid_t, unsigned int);
+#endif
+
+/**
+	// Add the dup2 mappings and inherited descriptors to &fa.
+*/
+STATIC(int)
+inv_file_actions(posix_spawn_file_actions_t *fa, PyObj fdmap, PyObj inherits)
 {
-	int r;
-	pid_t child = 0;
-	pid_t pgrp = -1;
-	short flags = 0;
-	static char *kwlist[] = {"fdmap", "inherit", "process_group", NULL,};
+	if (fdmap != NULL)
+	{
+		int fd, newfd, r;
 
-	PyObj fdmap = NULL;
-	PyObj inherits = NULL;
+		PyLoop_ForEachTuple(fdmap, "ii", &fd, &newfd)
+		{
+			r = posix_spawn_file_actions_adddup2(fa, fd, newfd);
 
-	posix_spawn_file_actions_t fa;
+			if (r != 0)
+			{
+				errno = r;
+				PyErr_SetFromErrno(PyExc_OSError);
+				break;
+			}
+		}
+		PyLoop_CatchError(fdmap)
+		{
+			return(-1);
+		}
+		PyLoop_End(fdmap)
+	}
 
-	Invocation inv = (Invocation) self;
+	#if __APPLE__
+		/*
+			// Might remove this due to portability issues.
+		*/
+		if (inherits != NULL)
+		{
+			PyObj fdo;
+			int fd, r;
 
-	if (!PyArg_ParseTupleAndKeywords(args, kw, "|OOi", kwlist, &fdmap, &inherits, &pgrp))
-		return(NULL);
+			PyLoop_ForEach(inherits, &fdo)
+			{
+				fd = PyLong_AsLong(fdo);
+				if (fd == -1 && PyErr_Occurred())
+					break;
+
+				r = posix_spawn_file_actions_addinherit_np(fa, fd);
+
+				if (r != 0)
+				{
+					errno = r;
+					PyErr_SetFromErrno(PyExc_OSError);
+					break;
+				}
+			}
+			PyLoop_CatchError(inherits)
+			{
+				return(-1);
+			}
+			PyLoop_End(inherits)
+		}
+	#else
+		if (inherits != NULL)
+		{
+			PyErr_SetString(PyExc_TypeError, "inherits only supported on Darwin");
+			return(-1);
+		}
+	#endif
+
+	return(0);
+}
+
+/**
+	// Modify the process group attribute for the next spawn.
+	// Negative &pgrp selects the prepared group or the Invocation's setting.
+*/
+STATIC(int)
+inv_process_group(Invocation inv, int pgrp)
+{
+	short flags = 0;
+
+	if (pgrp < 0)
+		pgrp = inv->ki_process_group;
 
 	/*
 		// Inherit pgroup setting from Invocation instance if not overridden.
@@ -60,12 +127,6 @@ inv_spawn(PyObj self, PyObj args, PyObj kw)
 		pgrp = 0;
 	}
 
-	if (posix_spawn_file_actions_init(&fa) != 0)
-	{
-		PyErr_SetFromErrno(PyExc_OSError);
-		return(NULL);
-	}
-
 	/*
 		// Modify attributes per-invocation.
 		// Attributes like process group need to be per-invocation.
@@ -73,7 +134,7 @@ inv_spawn(PyObj self, PyObj args, PyObj kw)
 	if (posix_spawnattr_getflags(&(inv->ki_spawnattr), &flags))
 	{
 		PyErr_SetFromErrno(PyExc_OSError);
-		return(NULL);
+		return(-1);
 	}
 
 	if (pgrp >= 0)
@@ -90,75 +151,96 @@ inv_spawn(PyObj self, PyObj args, PyObj kw)
 	if (posix_spawnattr_setflags(&(inv->ki_spawnattr), flags))
 	{
 		PyErr_SetFromErrno(PyExc_OSError);
-		return(NULL);
+		return(-1);
 	}
 
-	if (fdmap != NULL)
+	return(0);
+}
+
+/**
+	// Raise &RuntimeError when the attributes and file actions are being used
+	// by a &inv_spawn_many call that released the GIL.
+*/
+STATIC(int)
+inv_busy(Invocation inv)
+{
+	if (inv->ki_busy)
 	{
-		int fd, newfd, r;
+		PyErr_SetString(PyExc_RuntimeError, "invocation is being used by a concurrent spawn_many");
+		return(-1);
+	}
 
-		PyLoop_ForEachTuple(fdmap, "ii", &fd, &newfd)
-		{
-			r = posix_spawn_file_actions_adddup2(&fa, fd, newfd);
+	return(0);
+}
 
-			if (r != 0)
-			{
-				PyErr_SetFromErrno(PyExc_OSError);
-				break;
-			}
-		}
-		PyLoop_CatchError(fdmap)
-		{
-			posix_spawn_file_actions_destroy(&fa);
-			return(NULL);
-		}
-		PyLoop_End(fdmap)
-	}
+/**
+	// Open a process descriptor for use as the port of a process_exit &.kernel.Event.
+	// -1 when unavailable; kqueue based systems identify the process by its pid.
+*/
+STATIC(int)
+inv_pidfd(pid_t child)
+{
+	#ifdef __linux__
+		return(pidfd_open(child, 0));
+	#else
+		return(-1);
+	#endif
+}
 
-	#if __APPLE__
-		/*
-			// Might remove this due to portability issues.
-		*/
-		if (inherits != NULL)
-		{
-			PyObj fdo;
-			int fd, r;
+STATIC(PyObj)
+inv_spawn(PyObj self, PyObj args, PyObj kw)
+{
+	int r, pidfd = 0;
+	pid_t child = 0;
+	int pgrp = -1;
+	static char *kwlist[] = {"fdmap", "inherit", "process_group", "pidfd", NULL,};
 
-			PyLoop_ForEach(inherits, &fdo)
-			{
-				fd = PyLong_AsLong(fdo);
-				if (fd == -1 && PyErr_Occurred())
-					break;
+	PyObj fdmap = NULL;
+	PyObj inherits = NULL;
 
-				r = posix_spawn_file_actions_addinherit_np(&fa, fd);
+	posix_spawn_file_actions_t fa, *fap;
 
-				if (r != 0)
-				{
-					PyErr_SetFromErrno(PyExc_OSError);
-					break;
-				}
-			}
-			PyLoop_CatchError(inherits)
-			{
-				posix_spawn_file_actions_destroy(&fa);
-				return(NULL);
-			}
-			PyLoop_End(fdmap)
+	Invocation inv = (Invocation) self;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "|OOip", kwlist, &fdmap, &inherits, &pgrp, &pidfd))
+		return(NULL);
+
+	if (fdmap == NULL && inherits == NULL && inv->ki_file_actions_init)
+	{
+		/* Prepared. */
+		fap = &(inv->ki_file_actions);
+	}
+	else
+	{
+		fap = &fa;
+
+		if (posix_spawn_file_actions_init(&fa) != 0)
+		{
+			PyErr_SetFromErrno(PyExc_OSError);
+			return(NULL);
 		}
-	#else
-		if (inherits != NULL)
+
+		if (inv_file_actions(&fa, fdmap, inherits))
 		{
-			PyErr_SetString(PyExc_TypeError, "inherits only supported on Darwin");
+			posix_spawn_file_actions_destroy(&fa);
 			return(NULL);
 		}
-	#endif
+	}
 
-	r = posix_spawn(&child, (const char *) inv->ki_path, &fa,
+	/* After inv_file_actions as it may release the GIL. */
+	if (inv_busy(inv) || inv_process_group(inv, pgrp))
+	{
+		if (fap == &fa)
+			posix_spawn_file_actions_destroy(&fa);
+		return(NULL);
+	}
+
+	r = posix_spawn(&child, (const char *) inv->ki_path, fap,
 		&(inv->ki_spawnattr),
 		inv->ki_argv,
 		inv->ki_environ == NULL ? environ : inv->ki_environ);
 
-	if (posix_spawn_file_actions_destroy(&fa) != 0)
+	if (fap == &fa && posix_spawn_file_actions_destroy(&fa) != 0)
 	{
 		/*
 			// A warning would be appropriate.
@@ -173,9 +255,184 @@ inv_spawn(PyObj self, PyObj args, PyObj kw)
 		return(NULL);
 	}
 
+	if (pidfd)
+		return(Py_BuildValue("li", (long) child, inv_pidfd(child)));
+
 	return(PyLong_FromLong((long) child));
 }
 
+/**
+	// Spawn &count processes using the prepared file actions.
+	// The GIL is released once for the entire batch.
+*/
+STATIC(PyObj)
+inv_spawn_many(PyObj self, PyObj args, PyObj kw)
+{
+	static char *kwlist[] = {"count", "process_group", "pidfd", NULL,};
+	Invocation inv = (Invocation) self;
+	Py_ssize_t i, count = 0;
+	int r = 0, pgrp = -1, pidfd = 0;
+	pid_t *children;
+	int *fds = NULL;
+	char **envp;
+	PyObj rob;
+
+	posix_spawn_file_actions_t fa, *fap;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "n|ip", kwlist, &count, &pgrp, &pidfd))
+		return(NULL);
+
+	if (count < 0)
+	{
+		PyErr_SetString(PyExc_ValueError, "spawn count must not be negative");
+		return(NULL);
+	}
+
+	if (inv_busy(inv) || inv_process_group(inv, pgrp))
+		return(NULL);
+
+	children = PyMem_Malloc(sizeof(pid_t) * (count + 1));
+	if (pidfd)
+		fds = PyMem_Malloc(sizeof(int) * (count + 1));
+
+	if (children == NULL || (pidfd && fds == NULL))
+	{
+		PyMem_Free(children);
+		PyMem_Free(fds);
+		return(PyErr_NoMemory());
+	}
+
+	if (inv->ki_file_actions_init)
+		fap = &(inv->ki_file_actions);
+	else
+	{
+		fap = &fa;
+		if (posix_spawn_file_actions_init(&fa) != 0)
+		{
+			PyMem_Free(children);
+			PyMem_Free(fds);
+			PyErr_SetFromErrno(PyExc_OSError);
+			return(NULL);
+		}
+	}
+
+	envp = inv->ki_environ == NULL ? environ : inv->ki_environ;
+
+	/*
+		// Other threads may call prepare or spawn while the GIL is released;
+		// they are refused until the batch completes.
+	*/
+	inv->ki_busy = 1;
+	Py_BEGIN_ALLOW_THREADS
+	{
+		for (i = 0; i < count; ++i)
+		{
+			r = posix_spawn(&children[i], (const char *) inv->ki_path, fap,
+				&(inv->ki_spawnattr), inv->ki_argv, envp);
+
+			if (r != 0)
+				break;
+
+			if (fds != NULL)
+				fds[i] = inv_pidfd(children[i]);
+		}
+	}
+	Py_END_ALLOW_THREADS
+	inv->ki_busy = 0;
+
+	if (fap == &fa)
+		posix_spawn_file_actions_destroy(&fa);
+
+	/*
+		// Failures after the first spawn are not raised as the
+		// started processes would be lost; the list is truncated.
+	*/
+	if (r != 0 && i == 0)
+	{
+		PyMem_Free(children);
+		PyMem_Free(fds);
+
+		errno = r;
+		PyErr_SetFromErrno(PyExc_OSError);
+		return(NULL);
+	}
+
+	rob = PyList_New(i);
+	if (rob != NULL)
+	{
+		Py_ssize_t j;
+
+		for (j = 0; j < i; ++j)
+		{
+			PyObj item;
+
+			if (fds != NULL)
+				item = Py_BuildValue("li", (long) children[j], fds[j]);
+			else
+				item = PyLong_FromLong((long) children[j]);
+
+			if (item == NULL)
+			{
+				Py_DECREF(rob);
+				rob = NULL;
+				break;
+			}
+
+			PyList_SET_ITEM(rob, j, item);
+		}
+	}
+
+	PyMem_Free(children);
+	PyMem_Free(fds);
+	return(rob);
+}
+
+/**
+	// Construct and retain the file actions and process group used by
+	// spawns that do not provide their own.
+*/
+STATIC(PyObj)
+inv_prepare(PyObj self, PyObj args, PyObj kw)
+{
+	static char *kwlist[] = {"fdmap", "inherit", "process_group", NULL,};
+	Invocation inv = (Invocation) self;
+	PyObj fdmap = NULL, inherits = NULL;
+	int pgrp = -1;
+
+	posix_spawn_file_actions_t fa;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "|OOi", kwlist, &fdmap, &inherits, &pgrp))
+		return(NULL);
+
+	if (posix_spawn_file_actions_init(&fa) != 0)
+	{
+		PyErr_SetFromErrno(PyExc_OSError);
+		return(NULL);
+	}
+
+	if (inv_file_actions(&fa, fdmap, inherits))
+	{
+		posix_spawn_file_actions_destroy(&fa);
+		return(NULL);
+	}
+
+	/* Checked after inv_file_actions as it may release the GIL. */
+	if (inv_busy(inv))
+	{
+		posix_spawn_file_actions_destroy(&fa);
+		return(NULL);
+	}
+
+	if (inv->ki_file_actions_init)
+		posix_spawn_file_actions_destroy(&(inv->ki_file_actions));
+
+	inv->ki_file_actions = fa;
+	inv->ki_file_actions_init = 1;
+	inv->ki_process_group = pgrp;
+
+	Py_RETURN_NONE;
+}
+
 STATIC(PyObj)
 inv_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 {
@@ -213,6 +470,9 @@ inv_new(PyTypeObject *subtype, PyObj args, PyObj kw)
 	inv->ki_environ = NULL;
 	inv->ki_argv = NULL;
 	inv->ki_options = 0;
+	inv->ki_file_actions_init = 0;
+	inv->ki_busy = 0;
+	inv->ki_process_group = -1;
 
 	if (set_pgroup)
 		inv->ki_options |= IOPTION_SET_PGROUP;
@@ -403,6 +663,12 @@ inv_dealloc(PyObj self)
 		inv->ki_environ = NULL;
 	}
 
+	if (inv->ki_file_actions_init)
+	{
+		posix_spawn_file_actions_destroy(&(inv->ki_file_actions));
+		inv->ki_file_actions_init = 0;
+	}
+
 	if (inv->ki_spawnattr_init)
 	{
 		if (posix_spawnattr_destroy(&(inv->ki_spawnattr)) != 0)
@@ -421,6 +687,8 @@ STATIC(PyMethodDef)
 inv_methods[] = {
 	#define PyMethod_Id(N) inv_##N
 		PyMethod_Keywords(spawn),
+		PyMethod_Keywords(spawn_many),
+		PyMethod_Keywords(prepare),
 	#undef PyMethod_Id
 	{NULL,},
 };
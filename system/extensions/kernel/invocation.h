@@ -14,6 +14,14 @@ struct Invocation {
 	posix_spawnattr_t ki_spawnattr;
 	char ki_spawnattr_init;
 	char ki_options;
+
+	/* Cached by Invocation.prepare */
+	posix_spawn_file_actions_t ki_file_actions;
+	char ki_file_actions_init;
+	int ki_process_group;
+
+	/* Set while spawn_many uses the attributes without the GIL. */
+	char ki_busy;
 };
 
 typedef struct Invocation *Invocation;
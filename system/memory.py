@@ -3,6 +3,7 @@
 # in parts of processes.
 """
 import os
+import mmap
 import weakref
 import collections
 
@@ -103,28 +104,61 @@ class MemoryContext(object):
 
 class Segments(object):
 	"""
-	# Iterate over the slices of an active memory map;
-	# Weak references of the slices are held to track when
-	# its appropriate to close the memory map.
+	# Iterate over the slices of an active memory map.
+
+	# The slices reference the map's buffer directly, so the region remains mapped
+	# until the &Segments instance and every slice have been released; no per-slice
+	# tracking is performed. &select advises the system to read ahead of the cursor.
+
+	# [ Properties ]
+	# /memory/
+		# The `mmap.mmap` instance defining the total memory region.
+	# /size/
+		# The size of the slices produced by iterating over the instance.
+	# /readahead/
+		# The number of bytes ahead of the cursor that &select advises the system
+		# to prefetch; zero disables the advice.
 	"""
 
 	from mmap import mmap as MemoryMap
 	from mmap import ACCESS_READ as ACCESS_MODE
 
+	size = 1024*16
+	readahead = 1024*1024
+
 	@classmethod
-	def open(Class, path):
+	def open(Class, path, populate=False, huge=False, sequential=True):
 		"""
 		# Open the file at the given path in read-only mode and
 		# create a &Segments providing a &MemoryMap interface
 		# to the contents.
+
+		# [ Parameters ]
+		# /populate/
+			# Read the entire file into the page cache while mapping it;
+			# ignored where `MAP_POPULATE` is not available.
+		# /huge/
+			# Advise the system to back the region with huge pages.
+		# /sequential/
+			# Advise the system that the region will be read sequentially.
 		"""
 
 		fd = os.open(path, os.O_RDONLY)
 		try:
-			s = Class(Class.MemoryMap(fd, 0, access=Class.ACCESS_MODE))
+			if populate and hasattr(mmap, 'MAP_POPULATE'):
+				m = Class.MemoryMap(fd, 0,
+					flags=mmap.MAP_SHARED|mmap.MAP_POPULATE, prot=mmap.PROT_READ)
+			else:
+				m = Class.MemoryMap(fd, 0, access=Class.ACCESS_MODE)
 		finally:
 			os.close(fd)
 
+		s = Class(m)
+		if sequential:
+			s.advise('MADV_SEQUENTIAL')
+		if huge:
+			s.advise('MADV_HUGEPAGE')
+
 		return s
 
 	def __init__(self, memory:MemoryMap):
@@ -137,80 +171,59 @@ class Segments(object):
 			# The `mmap.mmap` instance defining the total memory region.
 		"""
 		self.memory = memory
-		self.weaks = weakref.WeakSet()
 
 	def __del__(self):
 		"""
-		# Manage the final stages of &Segments deallocation by transitioning
-		# to a finalization process where &select methods can no longer occur,
-		# and existing &memoryview's referencing &self, &weaks, are
-		# used to construct a sequence of &weakref.finalize callbacks.
-
-		# Once in the final stage, a count of outstanding &memoryview instances
-		# is tracked and decremented with &decrement until there are no more references
-		# to the &Segments allowing the file descriptor associated with &memory to be closed.
-		"""
-		# The delete method is used as its
-		# the precise functionality that is needed here.
-		# A two-stage deallocation procedure is used:
-
-		if self.weaks is not None:
-			if len(self.weaks) > 0:
-				# Add references, bringing the Segments refcount back to positive.
-				self.__iter__ = None
-				self.finals = [
-					weakref.finalize(x, self.decrement) for x in self.weaks
-				]
-				self.count = len(self.finals)
-				self.weaks.clear()
-				self.weaks = None
-			else:
-				# no references to the slices, close memory
-				self.weaks.clear()
-				self.weaks = None
-				self.memory.close()
-		else:
-			# second del attempt, decrement hit zero.
+		# Close the &memory if no slices remain.
+		"""
+		try:
 			self.memory.close()
+		except BufferError:
+			# Slices are still referenced; the map is released with the last of them.
+			pass
 
-	def decrement(self):
+	def advise(self, advice:str, start=0, length=None) -> bool:
 		"""
-		# Used internally by &__del__ to manage the deallocation process
-		# when there are outstanding references to the memory mapped region.
+		# Apply the `madvise` &advice, named by its `mmap` constant, to a range of
+		# the map. Returns &False when the advice is not supported by the system.
 		"""
-		self.count -= 1
-		if self.count == 0:
-			# this should trigger del's second stage.
-			del self.finals[:]
-			del self.finals
 
-	def select(self, start, stop, size, memoryview=memoryview, iter=iter, range=range):
+		option = getattr(mmap, advice, None)
+		if option is None:
+			return False
+
+		try:
+			if length is None:
+				self.memory.madvise(option, start)
+			else:
+				self.memory.madvise(option, start, length)
+		except (AttributeError, ValueError, OSError):
+			return False
+
+		return True
+
+	def select(self, start, stop, size, memoryview=memoryview, range=range, min=min):
 		"""
 		# Constructs an iterator to the parameterized range over the
 		# &memory the &Segments instance was initialized with.
 		"""
-		add_weak = self.weaks.add # (__del__ triggered finalization)
 		stop = stop if stop is not None else len(self.memory)
+		ahead = self.readahead
+		advised = start
+		page = mmap.PAGESIZE
 
 		view = memoryview(self.memory)
-		i = iter(range(start, stop, size))
-
-		start = next(i)
-		stop = 0
-
-		for stop in i:
-			vslice = view[start:stop]
-			add_weak(vslice)
-			yield vslice
-			start = stop
-		else:
-			# use the last stop to start the final
-			vslice = view[stop:stop+size]
-			add_weak(vslice)
-			yield vslice
+		for offset in range(start, stop, size):
+			if ahead and offset >= advised:
+				# Request the next window while half of the current remains.
+				base = offset - (offset % page)
+				self.advise('MADV_WILLNEED', base, min(ahead, stop - base))
+				advised = offset + (ahead // 2)
+
+			yield view[offset:min(offset + size, stop)]
 
 	def __iter__(self):
 		"""
-		# Return an iterator to the entire region in sixteen kilobyte sizes.
+		# Return an iterator to the entire region in &size slices.
 		"""
-		return self.select(0, len(self.memory), 1024*16)
+		return self.select(0, len(self.memory), self.size)
@@ -0,0 +1,341 @@
+"""
+# Process metrics registry exported through a memory mapped file.
+
+# Counters, gauges, and histograms are allocated fixed size slots in a mapped region
+# so that the values of a running process can be read by another process without
+# interacting with it. &read interprets a region given its path.
+
+# [ Layout ]
+
+# The region begins with a header followed by an array of slots.
+# All integers are native byte order.
+
+# /Header/
+	# 8 byte magic, `fmetrics`; 32-bit layout version; 32-bit slot capacity;
+	# 32-bit count of allocated slots; 32-bit process identifier; 8 reserved bytes.
+# /Slot/
+	# 8-bit kind; 8-bit name length; 16 reserved bits; 32-bit histogram scale;
+	# 48 byte name; nine 64-bit values.
+
+# Counters use the first value as a signed integer and gauges as a double.
+# Histograms use the first value as the observation count, the second as the
+# sum of the observations, and the remaining seven as the number of observations
+# greater than the preceding bound and less than or equal to `scale * 10**i`.
+# Observations exceeding the last bound are only present in the count.
+
+# Slots are written before the header's count is incremented, so readers only see
+# complete slots. Values are aligned 64-bit fields written by a single process.
+"""
+import os
+import mmap
+import struct
+
+magic = b'fmetrics'
+version = 1
+
+header = struct.Struct('=8sIIII8x')
+descriptor = struct.Struct('=BBxxI48s')
+slot_size = 128
+value_offset = descriptor.size
+histogram_bounds = 7
+
+kinds = {
+	1: 'counter',
+	2: 'gauge',
+	3: 'histogram',
+}
+kind_codes = {v: k for k, v in kinds.items()}
+
+class Metric(object):
+	"""
+	# Base class of the registered metrics.
+
+	# [ Properties ]
+	# /m_name/
+		# The identifier of the metric.
+	# /m_values/
+		# View of the slot's values.
+	"""
+
+	__slots__ = ('m_name', 'm_values')
+
+	def __init__(self, name, values):
+		self.m_name = name
+		self.m_values = values
+
+	def __repr__(self):
+		return "<%s %s>" %(self.__class__.__name__, self.m_name)
+
+class Counter(Metric):
+	"""
+	# Monotonically increasing integer.
+	"""
+
+	__slots__ = ()
+
+	def increment(self, quantity:int=1):
+		self.m_values[0] += quantity
+
+	@property
+	def value(self) -> int:
+		return self.m_values[0]
+
+class Gauge(Metric):
+	"""
+	# Floating point value that is set to the current measurement.
+	"""
+
+	__slots__ = ()
+
+	def set(self, value:float):
+		self.m_values[0] = value
+
+	def adjust(self, delta:float):
+		self.m_values[0] += delta
+
+	@property
+	def value(self) -> float:
+		return self.m_values[0]
+
+class Histogram(Metric):
+	"""
+	# Distribution of observations over decimal buckets.
+
+	# [ Properties ]
+	# /h_bounds/
+		# The inclusive upper bounds of the buckets.
+	"""
+
+	__slots__ = ('h_bounds',)
+
+	def __init__(self, name, values, scale):
+		super().__init__(name, values)
+		self.h_bounds = tuple(scale * 10**i for i in range(histogram_bounds))
+
+	def observe(self, value:int):
+		v = self.m_values
+		v[0] += 1
+		v[1] += value
+
+		i = 2
+		for bound in self.h_bounds:
+			if value <= bound:
+				v[i] += 1
+				break
+			i += 1
+
+	@property
+	def value(self) -> tuple:
+		"""
+		# The count, sum, and bucket counts of the observations.
+		"""
+		v = self.m_values
+		return (v[0], v[1], tuple(v[2:2+histogram_bounds]))
+
+class Registry(object):
+	"""
+	# Set of metrics allocated in a mapped region.
+
+	# [ Properties ]
+	# /r_path/
+		# The file backing the region; &None when the region is anonymous.
+	# /r_capacity/
+		# The number of slots available.
+	# /r_metrics/
+		# Mapping of names to the allocated &Metric instances.
+	# /r_map/
+		# The mapped region.
+	# /r_pid/
+		# The process that created the region.
+	"""
+
+	@classmethod
+	def environment(Class, variable='METRICS_EXPORT', capacity=256):
+		"""
+		# Create a registry exported into the directory identified by the environment
+		# &variable, or an anonymous registry when it is not set.
+		"""
+
+		directory = os.environ.get(variable)
+		if not directory:
+			return Class(None, capacity)
+
+		return Class(os.path.join(directory, str(os.getpid()) + '.metrics'), capacity)
+
+	def __init__(self, path=None, capacity=256):
+		self.r_path = path
+		self.r_capacity = capacity
+		self.r_metrics = {}
+		self.r_pid = os.getpid()
+
+		size = header.size + (slot_size * capacity)
+		if path is None:
+			self.r_map = mmap.mmap(-1, size)
+		else:
+			fd = os.open(path, os.O_RDWR|os.O_CREAT|os.O_TRUNC, 0o644)
+			try:
+				os.ftruncate(fd, size)
+				self.r_map = mmap.mmap(fd, size)
+			finally:
+				os.close(fd)
+
+		header.pack_into(self.r_map, 0, magic, version, capacity, 0, self.r_pid)
+
+	def _allocate(self, name:str, kind:str, scale:int=0):
+		m = self.r_metrics.get(name)
+		if m is not None:
+			if m.__class__.__name__.lower() != kind:
+				raise ValueError("metric %r is already registered as a different kind" %(name,))
+			return m
+
+		count = len(self.r_metrics)
+		if count >= self.r_capacity:
+			raise OverflowError("metrics region is full")
+
+		encoded = name.encode('utf-8')
+		if len(encoded) > 48:
+			raise ValueError("metric names are limited to 48 bytes")
+
+		offset = header.size + (slot_size * count)
+		descriptor.pack_into(self.r_map, offset, kind_codes[kind], len(encoded), scale, encoded)
+
+		view = memoryview(self.r_map)[offset+value_offset:offset+slot_size]
+		if kind == 'gauge':
+			values = view.cast('d')
+		else:
+			values = view.cast('q')
+
+		if kind == 'counter':
+			m = Counter(name, values)
+		elif kind == 'gauge':
+			m = Gauge(name, values)
+		else:
+			m = Histogram(name, values, scale)
+
+		self.r_metrics[name] = m
+		# Publish after the slot is complete.
+		struct.pack_into('=I', self.r_map, 16, count + 1)
+		return m
+
+	def counter(self, name:str) -> Counter:
+		"""
+		# Get or allocate the counter identified by &name.
+		"""
+		return self._allocate(name, 'counter')
+
+	def gauge(self, name:str) -> Gauge:
+		"""
+		# Get or allocate the gauge identified by &name.
+		"""
+		return self._allocate(name, 'gauge')
+
+	def histogram(self, name:str, scale:int=1) -> Histogram:
+		"""
+		# Get or allocate the histogram identified by &name whose first bucket
+		# holds observations less than or equal to &scale.
+		"""
+		return self._allocate(name, 'histogram', scale)
+
+	def snapshot(self) -> dict:
+		"""
+		# The current values of the registered metrics.
+		"""
+		return {k: v.value for k, v in self.r_metrics.items()}
+
+	def unlink(self):
+		"""
+		# Remove the backing file if it was created by the current process.
+		# The region remains usable.
+		"""
+
+		if self.r_path is not None and self.r_pid == os.getpid():
+			try:
+				os.unlink(self.r_path)
+			except FileNotFoundError:
+				pass
+
+	def close(self):
+		"""
+		# Release the region and &unlink the backing file.
+		"""
+
+		for m in self.r_metrics.values():
+			m.m_values.release()
+		self.r_metrics.clear()
+		self.r_map.close()
+		self.unlink()
+
+def interpret(region) -> tuple:
+	"""
+	# Interpret the metrics stored in &region.
+	# Returns the process identifier and a list of `(name, kind, value)` tuples.
+	"""
+
+	m, v, capacity, count, pid = header.unpack_from(region, 0)
+	if m != magic:
+		raise ValueError("not a metrics region")
+	if v != version:
+		raise ValueError("unsupported metrics layout version %d" %(v,))
+
+	metrics = []
+	for i in range(min(count, capacity)):
+		offset = header.size + (slot_size * i)
+		kind, length, scale, name = descriptor.unpack_from(region, offset)
+		name = name[:length].decode('utf-8')
+		kind = kinds[kind]
+
+		if kind == 'gauge':
+			value = struct.unpack_from('=d', region, offset + value_offset)[0]
+		elif kind == 'counter':
+			value = struct.unpack_from('=q', region, offset + value_offset)[0]
+		else:
+			values = struct.unpack_from('=9q', region, offset + value_offset)
+			value = (values[0], values[1], tuple(
+				zip((scale * 10**i for i in range(histogram_bounds)), values[2:])
+			))
+
+		metrics.append((name, kind, value))
+
+	return pid, metrics
+
+def aggregate(samples) -> dict:
+	"""
+	# Combine the metrics read from a set of processes.
+	# Counters and gauges are summed; histogram counts, sums, and buckets are added.
+
+	# [ Parameters ]
+	# /samples/
+		# Iterable of `(name, kind, value)` sequences as returned by &interpret.
+	"""
+
+	totals = {}
+	for metrics in samples:
+		for name, kind, value in metrics:
+			current = totals.get(name)
+			if current is None:
+				totals[name] = (kind, value)
+				continue
+
+			if current[0] != kind:
+				# Inconsistent kinds; keep the first.
+				continue
+
+			if kind == 'histogram':
+				count, total, buckets = current[1]
+				buckets = tuple(
+					(bound, n + m) for (bound, n), (_, m) in zip(buckets, value[2])
+				)
+				totals[name] = (kind, (count + value[0], total + value[1], buckets))
+			else:
+				totals[name] = (kind, current[1] + value)
+
+	return totals
+
+def read(path) -> tuple:
+	"""
+	# Read the metrics exported by a process into the file at &path.
+	"""
+
+	with open(path, 'rb') as f:
+		with mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ) as region:
+			return interpret(region)
@@ -0,0 +1,155 @@
+"""
+# Statistical profiler sampling the stacks of selected threads.
+
+# A dedicated thread reads the frames of the sampled threads on an interval and
+# counts each distinct stack. No trace functions are installed, so the sampled
+# threads run at full speed. The counts are written in the collapsed stack format
+# consumed by flame graph tools: one line per stack with semicolon separated
+# frames, root first, followed by the number of samples.
+
+# When the stack contains a task queue's execution loop, the frame called by the
+# loop identifies the task being performed. The sample is attributed to the task
+# by prefixing the stack with a `task:` frame so that hot tasks aggregate regardless
+# of the call path leading to the loop.
+"""
+import sys
+import time
+import collections
+
+from . import thread
+
+def label(code, module) -> str:
+	"""
+	# Identify a code object for use in a collapsed stack.
+	"""
+	return module + ':' + getattr(code, 'co_qualname', code.co_name)
+
+class Sampler(object):
+	"""
+	# Sampling profiler collecting collapsed stacks.
+
+	# [ Properties ]
+	# /s_interval/
+		# Seconds between samples.
+	# /s_threads/
+		# The identifiers of the threads to sample; &None samples all threads
+		# other than the sampler's.
+	# /s_boundaries/
+		# Code objects of task execution loops; the frame called by one of these
+		# is the task that the sample is attributed to.
+	# /s_counts/
+		# Mapping of stacks to the number of samples that observed them.
+	# /s_samples/
+		# The number of sampling passes performed.
+	# /s_exit/
+		# Mutex held while the sampling thread is running; released when it exits.
+	"""
+
+	def __init__(self, interval=0.005, threads=None, boundaries=()):
+		self.s_interval = interval
+		self.s_threads = threads
+		self.s_boundaries = frozenset(boundaries)
+		self.s_counts = collections.Counter()
+		self.s_samples = 0
+		self.s_labels = {}
+		self.s_running = False
+		self.s_thread = None
+		self.s_exit = thread.amutex()
+
+	def _s_label(self, frame):
+		code = frame.f_code
+		try:
+			return self.s_labels[code]
+		except KeyError:
+			l = self.s_labels[code] = label(code, frame.f_globals.get('__name__', '?'))
+			return l
+
+	def s_stack(self, frame) -> tuple:
+		"""
+		# Construct the collapsed stack of &frame, root first.
+		"""
+
+		frames = []
+		task = None
+		boundaries = self.s_boundaries
+
+		while frame is not None:
+			if task is None and frame.f_code in boundaries and frames:
+				task = frames[-1]
+			frames.append(frame)
+			frame = frame.f_back
+
+		stack = [self._s_label(x) for x in reversed(frames)]
+		if task is not None:
+			stack.insert(0, 'task:' + self._s_label(task))
+
+		return tuple(stack)
+
+	def s_sample(self, frames=None):
+		"""
+		# Record the stacks of the selected threads in &frames.
+		"""
+
+		if frames is None:
+			frames = sys._current_frames()
+
+		if self.s_threads is None:
+			selected = [f for tid, f in frames.items() if tid != self.s_thread]
+		else:
+			selected = [frames[tid] for tid in self.s_threads if tid in frames]
+
+		counts = self.s_counts
+		for f in selected:
+			counts[self.s_stack(f)] += 1
+		self.s_samples += 1
+
+	def _s_loop(self, sleep=time.sleep):
+		self.s_thread = thread.identify()
+		try:
+			while self.s_running:
+				sleep(self.s_interval)
+				self.s_sample()
+		finally:
+			self.s_thread = None
+			self.s_exit.release()
+
+	def start(self):
+		"""
+		# Create the sampling thread.
+		"""
+
+		if self.s_running:
+			return
+		self.s_exit.acquire()
+		self.s_running = True
+		try:
+			thread.create(self._s_loop, ())
+		except:
+			self.s_running = False
+			self.s_exit.release()
+			raise
+
+	def stop(self):
+		"""
+		# Signal the sampling thread to exit and wait for its current pass to complete
+		# so that &s_counts is no longer modified.
+		"""
+		self.s_running = False
+		with self.s_exit:
+			pass
+
+	def collapsed(self):
+		"""
+		# Iterate over the lines of the collapsed stack format.
+		"""
+
+		for stack, count in self.s_counts.most_common():
+			yield ';'.join(stack) + ' ' + str(count) + '\n'
+
+	def write(self, path):
+		"""
+		# Store the collected samples at &path in the collapsed stack format.
+		"""
+
+		with open(path, 'w') as f:
+			f.writelines(self.collapsed())
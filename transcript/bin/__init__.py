@@ -0,0 +1,3 @@
+"""
+# Commands for displaying process status.
+"""
@@ -0,0 +1,40 @@
+"""
+# Display the metrics exported by a process.
+
+# Reads the file written by &...system.metrics.Registry every interval and writes
+# the current values along with the rates of the counters.
+"""
+import sys
+import time
+
+from ...system import metrics
+from .. import metrics as formatting
+
+def display(path, interval=1.0, write=sys.stdout.write, clock=time.monotonic):
+	previous = None
+	last = clock()
+
+	while True:
+		pid, current = metrics.read(path)
+		now = clock()
+
+		lines = formatting.live(previous, current, now - last)
+		write("\x1b[H\x1b[J[%d] %s\n" %(pid, path))
+		write(''.join(x + '\n' for x in lines))
+		sys.stdout.flush()
+
+		previous = current
+		last = now
+		time.sleep(interval)
+
+def main(argv):
+	path = argv[0]
+	interval = float(argv[1]) if len(argv) > 1 else 1.0
+
+	try:
+		display(path, interval)
+	except KeyboardInterrupt:
+		sys.stdout.write("\n")
+
+if __name__ == '__main__':
+	main(sys.argv[1:])
@@ -293,3 +293,42 @@ class Procedure:
 				s.append(c+str(attrv))
 
 		return ' '.join(s)
+
+def live(previous, current, elapsed:float) -> list:
+	"""
+	# Format samples of a process's exported metrics into display lines.
+
+	# [ Parameters ]
+	# /previous/
+		# The metrics read at the prior sample, or &None for the first.
+	# /current/
+		# The `(name, kind, value)` tuples read by &..system.metrics.read.
+	# /elapsed/
+		# Seconds between the samples; used to identify counter rates.
+	"""
+
+	prior = {}
+	if previous is not None:
+		prior = {name: value for name, kind, value in previous}
+
+	width = max((len(x[0]) for x in current), default=0)
+	lines = []
+
+	for name, kind, value in current:
+		label = name.ljust(width)
+
+		if kind == 'counter':
+			line = "%s %d" %(label, value)
+			if name in prior and elapsed > 0:
+				line += " (%.1f/s)" %((value - prior[name]) / elapsed,)
+		elif kind == 'gauge':
+			line = "%s %g" %(label, value)
+		else:
+			count, total, buckets = value
+			mean = (total / count) if count else 0
+			dist = ' '.join("<=%d:%d" %(bound, n) for bound, n in buckets if n)
+			line = "%s n=%d mean=%g %s" %(label, count, mean, dist)
+
+		lines.append(line.rstrip())
+
+	return lines
@@ -14,10 +14,14 @@
 """
 import typing
 import weakref
+import functools
+import collections
+import time
 
 from ..kernel import core
 from ..kernel import flows
 from ..kernel import io
+from ..time import types as timetypes
 from . import http
 
 def _prepare_http_transports_v0(ifctx, ports, Protocol=http.allocate_client_protocol):
@@ -26,13 +30,13 @@ def _prepare_http_transports_v0(ifctx, ports, Protocol=http.allocate_client_prot
 def _prepare_http_transports_v1(ifctx, ports, Protocol=http.allocate_client_protocol_v1):
 	return [(x, (), Protocol()) for x in ports]
 
-def _prepare_http_transports_v2(ifctx, ports, Protocol=None):
-	raise Exception("not implemented")
+def _prepare_http_transports_v2(ifctx, ports, Protocol=http.allocate_client_protocol_v2):
+	return [(x, (), Protocol()) for x in ports]
 
 protocols = {
 	'http': _prepare_http_transports_v0, # Adjustable.
 	'http-1': _prepare_http_transports_v1, # Strictly 1.0/1.1 only.
-	'http-2': _prepare_http_transports_v2, # Not implemented
+	'http-2': _prepare_http_transports_v2, # Prior knowledge.
 }
 
 class Controller(object):
@@ -42,8 +46,19 @@ class Controller(object):
 	# [ Properties ]
 	# /http_response/
 		# The &.http.Structures instance representing the response status and headers.
+	# /http_completion/
+		# Callable noting the completion of the response with the connection's owner;
+		# given &True when the connection cannot be reused. &None once performed.
+	# /http_failed/
+		# Callable given the exception when the response will not be received;
+		# &None when no callback is configured.
+	# /http_exception/
+		# The exception given to &http_fault; &None if the request has not failed.
 	"""
 	http_response = None
+	http_completion = None
+	http_failed = None
+	http_exception = None
 
 	@property
 	def transport(self) -> io.Transport:
@@ -63,6 +78,14 @@ class Controller(object):
 	def _correlation(self, channel_id, parameters, connect_input):
 		self._connect_input = connect_input
 		self._response_channel_id = channel_id
+
+		if isinstance(parameters, Exception):
+			# HTTP/2 stream reset or refused by GOAWAY before the response.
+			# Only the latter prevents the connection from being reused.
+			connect_input(None)
+			self.http_fault(parameters, final=not parameters.stream)
+			return
+
 		self.http_response = self.response = http.Structures(parameters[2]).set_status(*parameters[:2])
 
 	def http_add_header(self, key:bytes, value:bytes):
@@ -120,8 +143,38 @@ class Controller(object):
 		"""
 		# Accept the entity-body of the response into &channel.
 		# If &channel is &None, any entity body sent will trigger a fault.
+
+		# Channels other than &Response must call &http_complete
+		# when the entity body has been transferred.
+		"""
+		r = self._connect_input(channel)
+		if channel is None:
+			self.http_complete()
+		return r
+
+	def http_complete(self, final:bool=False):
+		"""
+		# Note that the response has been received allowing the connection to be reused.
+		# &final indicates that the connection cannot be reused.
+		"""
+		completion = self.http_completion
+		if completion is not None:
+			self.http_completion = None
+			completion(final)
+
+	def http_fault(self, exception:Exception, final:bool=True):
+		"""
+		# Note that the response will not be received as the connection was lost
+		# or the stream was reset before it was correlated. &http_failed is called
+		# with the &exception, and &final is given to &http_complete.
 		"""
-		return self._connect_input(channel)
+		self.http_exception = exception
+		self.http_complete(final)
+
+		failed = self.http_failed
+		if failed is not None:
+			self.http_failed = None
+			failed(exception)
 
 	def _http_content_headers(self, cotype:bytes, length:int):
 		"""
@@ -183,7 +236,7 @@ class Controller(object):
 		reader = io.Transfer()
 		rx = core.Transaction.create(reader)
 		storage = flows.Collection.extended_list()
-		recv = flows.Receiver(self.accept)
+		recv = Response(self)
 
 		cb = functools.partial(callback, self, storage.c_storage, *args)
 
@@ -201,7 +254,7 @@ class Controller(object):
 		rx = core.Transaction.create(reader)
 
 		ko = self.invocations.system.append_file(str(path))
-		recv = flows.Receiver(self.accept)
+		recv = Response(self)
 
 		self.invocations.sector.dispatch(rx)
 		t = reader.io_flow([recv, ko], Terminal=Terminal)
@@ -215,12 +268,272 @@ class Controller(object):
 
 		reader = io.Transfer()
 		rx = core.Transaction.create(reader)
-		recv = flows.Receiver(self.accept)
+		recv = Response(self)
 
 		self.xact_dispatch(rx)
 		reader.io_flow([recv])
 		reader.io_execute()
 
+class Response(flows.Receiver):
+	"""
+	# Receiver of a response's entity body that notes the completion of the
+	# response with its &Controller.
+	"""
+
+	def __init__(self, controller):
+		super().__init__(controller.accept)
+		self.r_controller = controller
+
+	def _f_terminated(self):
+		super()._f_terminated()
+		self.r_controller.http_complete()
+
+	def interrupt(self):
+		super().interrupt()
+		# Incomplete entity body; the state of the connection is unknown.
+		self.r_controller.http_complete(True)
+
+class Connection(object):
+	"""
+	# A transport managed by a &Pool and the requests pipelined on it.
+
+	# [ Properties ]
+	# /c_key/
+		# The pool key identifying the remote host, endpoint, and security context.
+	# /c_transport/
+		# The &io.Transport supporting the connection.
+	# /c_invocations/
+		# The &io.Invocations of the transport's protocol.
+	# /c_requests/
+		# Mapping of channel identifiers to the &Controller instances awaiting responses.
+	# /c_pending/
+		# The number of requests whose responses have not been completed.
+	# /c_final/
+		# Whether the connection will not be used for further requests.
+	# /c_released/
+		# The time at which the connection became idle.
+	"""
+
+	c_invocations = None
+	c_released = None
+
+	def __init__(self, key, transport):
+		self.c_key = key
+		self.c_transport = transport
+		self.c_requests = {}
+		self.c_pending = 0
+		self.c_final = False
+
+	def c_healthy(self) -> bool:
+		"""
+		# Whether the connection can be used for another request.
+		"""
+		if self.c_final:
+			return False
+		return self.c_transport.functioning and not self.c_transport.terminating
+
+	def c_correlate(self, invocations):
+		"""
+		# Router given to the transport's protocol connecting responses to their requests.
+		"""
+		for x in invocations.i_correlate():
+			ctl = self.c_requests.pop(x[0])
+			ctl._correlation(*x)
+			if ctl.http_exception is None and not ctl.http_response.persistent(x[1][3]):
+				self.c_final = True
+
+	def c_fault(self, exception:Exception):
+		"""
+		# Fault the requests whose responses have not been received.
+		"""
+		requests = list(self.c_requests.values())
+		self.c_requests.clear()
+		for ctl in requests:
+			ctl.http_fault(exception)
+
+	def c_request(self, Controller):
+		"""
+		# Allocate a &Controller for a request sent using the connection.
+		"""
+		channel_id, connect = next(self.c_invocations.i_allocate())
+		ctl = Controller(self.c_invocations, channel_id, connect)
+		self.c_requests[channel_id] = ctl
+		return ctl
+
+	def c_close(self):
+		"""
+		# Close the connection's output.
+		"""
+		self.c_final = True
+		if not self.c_transport.terminated:
+			self.c_transport.io_transmit_close()
+
+class Pool(object):
+	"""
+	# Client connections kept alive for reuse by subsequent requests.
+
+	# Connections are keyed by the host, endpoint, and security context used to
+	# establish them. Idle connections are reused before new connections are
+	# established, and busy connections accept pipelined requests when the
+	# host's connection limit has been reached.
+
+	# [ Properties ]
+	# /p_connect/
+		# Callable establishing a &Connection for a key.
+	# /p_host_limit/
+		# The maximum number of connections to a key.
+	# /p_idle_limit/
+		# The maximum number of idle connections retained for a key.
+	# /p_idle_timeout/
+		# The number of seconds that an idle connection is retained.
+	# /p_pipeline_depth/
+		# The maximum number of outstanding requests on a connection.
+	# /p_connections/
+		# Mapping of keys to the sets of connections established.
+	# /p_idle/
+		# Mapping of keys to idle connections; least recently released first.
+	# /p_waiting/
+		# Mapping of keys to the callbacks awaiting a connection.
+	"""
+
+	def __init__(self, connect,
+			host_limit:int=6,
+			idle_limit:int=4,
+			idle_timeout:int=30,
+			pipeline_depth:int=4,
+			clock=time.monotonic,
+		):
+		self.p_connect = connect
+		self.p_host_limit = host_limit
+		self.p_idle_limit = idle_limit
+		self.p_idle_timeout = idle_timeout
+		self.p_pipeline_depth = pipeline_depth
+		self.p_clock = clock
+
+		self.p_connections = collections.defaultdict(set)
+		self.p_idle = collections.defaultdict(collections.deque)
+		self.p_waiting = collections.defaultdict(collections.deque)
+
+	def _p_idle(self, key):
+		# Healthy, unexpired idle connection or None.
+		idle = self.p_idle.get(key)
+		if not idle:
+			return None
+
+		expiry = self.p_clock() - self.p_idle_timeout
+		while idle:
+			c = idle.pop()
+			if c.c_released >= expiry and c.c_healthy():
+				return c
+			self.p_discard(c)
+
+		return None
+
+	def _p_pipeline(self, key):
+		# Busy connection with the fewest pending requests or None.
+		selected = None
+		for c in self.p_connections.get(key, ()):
+			if c.c_pending >= self.p_pipeline_depth or not c.c_healthy():
+				continue
+			if selected is None or c.c_pending < selected.c_pending:
+				selected = c
+		return selected
+
+	def _p_establish(self, key):
+		c = self.p_connect(key)
+		self.p_connections[key].add(c)
+		return c
+
+	def p_acquire(self, key, callback, pipeline:bool=True):
+		"""
+		# Execute &callback with a &Connection for &key.
+
+		# The callback is deferred when the host's connection limit has been reached
+		# and no connection can accept the request. Requests should only be pipelined
+		# when their methods are idempotent.
+		"""
+		c = self._p_idle(key)
+		if c is None:
+			if len(self.p_connections.get(key, ())) < self.p_host_limit:
+				c = self._p_establish(key)
+			elif pipeline:
+				c = self._p_pipeline(key)
+
+		if c is None:
+			self.p_waiting[key].append(callback)
+			return None
+
+		c.c_pending += 1
+		c.c_released = None
+		callback(c)
+		return c
+
+	def p_complete(self, connection:Connection):
+		"""
+		# Note that a response received from &connection has been completed.
+		# Connections without outstanding requests are retained as idle, or
+		# closed if they are final or exceed the idle limit.
+		"""
+		connection.c_pending -= 1
+		key = connection.c_key
+
+		if not connection.c_healthy():
+			if connection.c_pending <= 0:
+				self.p_discard(connection)
+			return
+
+		waiting = self.p_waiting.get(key)
+		if waiting:
+			connection.c_pending += 1
+			waiting.popleft()(connection)
+		elif connection.c_pending == 0:
+			connection.c_released = self.p_clock()
+			idle = self.p_idle[key]
+			idle.append(connection)
+			while len(idle) > self.p_idle_limit:
+				self.p_discard(idle.popleft())
+
+	def p_discard(self, connection:Connection):
+		"""
+		# Close and remove &connection from the pool.
+		# A waiting request, if any, is given a new connection.
+		"""
+		key = connection.c_key
+		connections = self.p_connections.get(key)
+		if connections is None or connection not in connections:
+			return
+
+		connections.discard(connection)
+		try:
+			self.p_idle[key].remove(connection)
+		except ValueError:
+			pass
+		connection.c_close()
+
+		waiting = self.p_waiting.get(key)
+		if waiting:
+			c = self._p_establish(key)
+			c.c_pending += 1
+			waiting.popleft()(c)
+
+	def p_reduce(self):
+		"""
+		# Close idle connections that have exceeded the idle timeout.
+		"""
+		expiry = self.p_clock() - self.p_idle_timeout
+		for idle in list(self.p_idle.values()):
+			while idle and idle[0].c_released < expiry:
+				self.p_discard(idle[0])
+
+	def p_close(self):
+		"""
+		# Close all connections and forget the waiting requests.
+		"""
+		self.p_waiting.clear()
+		for connections in list(self.p_connections.values()):
+			for c in list(connections):
+				self.p_discard(c)
+
 class Session(core.Context):
 	"""
 	# Session dispatching invocation projections for facilitating a request.
@@ -231,6 +544,20 @@ class Session(core.Context):
 		self.s_cookies = {} # Session, per host.
 		self.s_connections = collections.defaultdict(weakref.WeakSet)
 
+	def s_request(self, key, callback, pipeline:bool=True):
+		"""
+		# Execute &callback with a &Controller for a request to &key using
+		# a connection from the navigation's pool.
+		"""
+		nav = self.navigation
+
+		def allocate(connection):
+			self.s_connections[key].add(connection)
+			ctl = connection.c_request(Controller)
+			ctl.http_completion = functools.partial(nav.nav_complete, connection)
+			callback(ctl, connection)
+		return nav.nav_pool.p_acquire(key, allocate, pipeline=pipeline)
+
 	def s_correlate(self, inv):
 		for x in inv.i_correlate():
 			ctl = self.s_controllers.pop((inv, x[0]))
@@ -245,13 +572,49 @@ class Session(core.Context):
 class Navigation(core.Context):
 	"""
 	# Root agent context managing global headers, connection strategy cache, and host state.
+
+	# [ Properties ]
+	# /nav_pool/
+		# The &Pool of connections used by the sessions.
+	# /nav_transports/
+		# Mapping of transports to the pooled &Connection that they support.
+	# /nav_reducing/
+		# Whether the navigation is deferred to close expired idle connections.
 	"""
 
-	def __init__(self):
+	nav_reducing = False
+
+	def __init__(self, **pool):
 		self._nav_session_ids = 0
 		self.nav_headers = []
 		self.nav_cookies = {} # Persistent, per host.
 		self.nav_sessions = weakref.WeakValueDictionary()
+		self.nav_pool = Pool(self.nav_establish, **pool)
+		self.nav_transports = {}
+
+	def nav_complete(self, connection, final=False):
+		"""
+		# Return &connection to the pool after a response has been received.
+		"""
+		if final:
+			connection.c_final = True
+		self.nav_pool.p_complete(connection)
+		self._nav_schedule()
+
+	def _nav_schedule(self):
+		if self.nav_reducing or not any(self.nav_pool.p_idle.values()):
+			return
+
+		self.nav_reducing = True
+		self.system.defer(timetypes.Measure.of(second=self.nav_pool.p_idle_timeout), self)
+
+	def occur(self):
+		"""
+		# Close the idle connections that expired while deferred.
+		"""
+		self.nav_reducing = False
+		self.nav_pool.p_reduce()
+		self._nav_schedule()
 
 	def nav_connect(self, endpoint):
 		"""
@@ -260,6 +623,26 @@ class Navigation(core.Context):
 		"""
 		return self.system.connect(endpoint)
 
+	def nav_establish(self, key, Protocol=http.allocate_client_protocol) -> Connection:
+		"""
+		# Establish a &Connection for the pool &key: the host name, the endpoint,
+		# and the security context; &None for cleartext connections.
+		"""
+		host, endpoint, security = key
+		tp = io.Transport.from_endpoint(self.nav_connect(endpoint))
+
+		if security is not None:
+			from ..security import kprotocol
+			tls = security.connect(host.encode('idna'))
+			tp.tp_extend([(('security', tls), kprotocol.allocate(tls))])
+
+		c = Connection(key, tp)
+		self.nav_transports[tp] = c
+		self.xact_dispatch(core.Transaction.create(tp))
+		c.c_invocations = tp.tp_connect(c.c_correlate, Protocol())
+		tp.io_execute()
+		return c
+
 	def nav_route(self, io):
 		pass
 
@@ -278,6 +661,24 @@ class Navigation(core.Context):
 	def actuate(self):
 		self.provide('navigation')
 
+	def terminate(self):
+		if not self.functioning:
+			return
+
+		self.start_termination()
+		self.nav_pool.p_close()
+		self.xact_exit_if_empty()
+
+	def xact_exit(self, xact):
+		"""
+		# Remove the connection of the exited transport from the pool
+		# and fault the requests still waiting for their responses.
+		"""
+		c = self.nav_transports.pop(xact.xact_context, None)
+		if c is not None:
+			self.nav_pool.p_discard(c)
+			c.c_fault(ConnectionError("transport exited before the response was received"))
+
 	def xact_void(self, final):
 		if self.terminating:
 			self.finish_termination()
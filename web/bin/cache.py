@@ -107,7 +107,6 @@ class Download(kcore.Context):
 		return req
 
 	def dl_status(self, time=None):
-		window = timetypes.Measure.of(second=8)
 		final = '\r'
 
 		if not self.dl_identities:
@@ -117,21 +116,17 @@ class Download(kcore.Context):
 
 		if self.dl_monitor is not None:
 			monitor = self.dl_monitor
-			units, time = monitor.tm_rate(window)
-			total = units + monitor.tm_aggregate[0]
+			meter = monitor.tm_meter
+			total = meter.m_total
 
 			if monitor.terminated:
-				units += monitor.tm_aggregate[0]
-				time = time.increase(monitor.tm_aggregate[1])
+				rate = meter.m_overall()
 				final = '\n'
+			else:
+				rate = meter.m_rate()
 		else:
 			total = 0
-			units, time = (0, window.__class__(1))
-
-		try:
-			rate = (units / time) * (1000000000) # ns
-		except ZeroDivisionError:
-			rate = units
+			rate = 0.0
 
 		try:
 			if self.dl_content_length is not None:
@@ -260,7 +260,11 @@ def integrate(name, args):
 
 def main(inv:process.Invocation) -> process.Exit:
 	optdata = integrate(inv.parameters['system']['name'], inv.argv)
-	workers = int(optdata.get('concurrency', 1))
+	workers = optdata.get('concurrency', 1)
+	if workers == 'auto':
+		# One worker per available processor.
+		workers = len(os.sched_getaffinity(0)) if hasattr(os, 'sched_getaffinity') else os.cpu_count()
+	workers = int(workers or 0)
 
 	kports = {}
 	for configpath in optdata['listening-interfaces']:
@@ -0,0 +1,267 @@
+"""
+# Content coding support for HTTP entity bodies.
+
+# Provides (http/header)`Accept-Encoding` negotiation, a streaming &Compression
+# channel for dynamic bodies, and &Variants for caching the compressed forms
+# of static files.
+
+# [ Properties ]
+# /compressors/
+	# Mapping of content codings to constructors of streaming compressors.
+	# (http/coding)`zstd` is only present when a zstd implementation is available.
+# /compressible/
+	# Media types, by prefix, whose representations are worth compressing.
+"""
+import os
+import zlib
+import collections
+
+from ..kernel import flows
+
+def _zlib(wbits, level=6, compressobj=zlib.compressobj, DEFLATED=zlib.DEFLATED):
+	return (lambda: compressobj(level, DEFLATED, wbits))
+
+compressors = {
+	'gzip': _zlib(16 + zlib.MAX_WBITS),
+	'deflate': _zlib(zlib.MAX_WBITS),
+}
+
+try:
+	from compression import zstd as _zstd
+	compressors['zstd'] = _zstd.ZstdCompressor
+except ImportError:
+	try:
+		import zstandard as _zstd
+		compressors['zstd'] = (lambda: _zstd.ZstdCompressor().compressobj())
+	except ImportError:
+		pass
+
+# Server preference when the client weighs codings equally.
+preference = ('zstd', 'gzip', 'deflate')
+
+# File name extensions of precompressed siblings.
+extensions = {
+	'gzip': '.gz',
+	'zstd': '.zst',
+}
+
+compressible = (
+	'text/',
+	'application/json',
+	'application/javascript',
+	'application/xml',
+	'application/xhtml+xml',
+	'image/svg+xml',
+)
+
+def parse(field:bytes) -> dict:
+	"""
+	# Interpret an (http/header)`Accept-Encoding` field value into
+	# a mapping of codings to their quality values.
+	"""
+	weights = {}
+
+	for item in field.split(b','):
+		coding, *params = item.split(b';')
+		coding = coding.strip().lower()
+		if not coding:
+			continue
+
+		q = 1.0
+		for p in params:
+			k, _, v = p.strip().partition(b'=')
+			if k.strip().lower() == b'q':
+				try:
+					q = float(v)
+				except ValueError:
+					q = 0.0
+
+		weights[coding.decode('ascii', 'replace')] = q
+
+	return weights
+
+def select(field:bytes, available=compressors, preference=preference):
+	"""
+	# Select the content coding to apply given the (http/header)`Accept-Encoding` &field.
+	# Returns &None when the identity coding should be used.
+	"""
+	if not field:
+		return None
+
+	weights = parse(field)
+	default = weights.get('*', 0.0)
+
+	selected = None
+	selected_q = 0.0
+	for coding in preference:
+		if coding not in available:
+			continue
+
+		q = weights.get(coding, default)
+		if q > selected_q:
+			selected = coding
+			selected_q = q
+
+	return selected
+
+def compressible_type(cotype:str) -> bool:
+	"""
+	# Whether the given media type string identifies a compressible representation.
+	"""
+	return cotype.startswith(compressible)
+
+class Compression(flows.Channel):
+	"""
+	# Transformer compressing the transferred buffers using a content coding.
+
+	# [ Properties ]
+	# /c_coding/
+		# The identifier of the content coding being applied.
+	# /c_flush/
+		# Whether every transfer should be flushed so that the
+		# receiver can decode it without waiting for more data.
+	"""
+
+	f_type = 'transformer'
+
+	def __init__(self, coding:str, flush:bool=False, compressors=compressors):
+		self.c_coding = coding
+		self.c_state = compressors[coding]()
+		self.c_flush = flush
+
+	def f_transfer(self, event, SYNC=zlib.Z_SYNC_FLUSH):
+		compress = self.c_state.compress
+		out = [x for x in map(compress, event) if x]
+
+		if self.c_flush and self.c_coding != 'zstd':
+			tail = self.c_state.flush(SYNC)
+			if tail:
+				out.append(tail)
+
+		if out:
+			self.f_emit(out)
+
+	def f_terminate(self):
+		tail = self.c_state.flush()
+		if tail:
+			self.f_emit((tail,))
+		super().f_terminate()
+
+class Variants(object):
+	"""
+	# Cache of compressed representations of files.
+
+	# Entries are keyed by path, coding, and the file's modification time and size,
+	# so changes to the file invalidate its variants. Precompressed siblings
+	# (`.gz` or `.zst` files) newer than the original are used in place of compression.
+
+	# [ Properties ]
+	# /v_limit/
+		# The maximum number of bytes held by the cache.
+	# /v_size/
+		# The number of bytes currently held.
+	# /v_entries/
+		# Ordered mapping of keys to compressed content; least recently used first.
+	# /v_pending/
+		# The keys of the variants being compressed by &prepare.
+	"""
+
+	def __init__(self, limit:int=1024*1024*32):
+		self.v_limit = limit
+		self.v_size = 0
+		self.v_entries = collections.OrderedDict()
+		self.v_pending = set()
+
+	def _v_store(self, key, data):
+		if len(data) > self.v_limit:
+			return
+
+		entries = self.v_entries
+		self.v_size += len(data)
+		entries[key] = data
+
+		while self.v_size > self.v_limit:
+			k, v = entries.popitem(last=False)
+			self.v_size -= len(v)
+
+	def _v_sibling(self, path, coding, st, stat=os.stat):
+		ext = extensions.get(coding)
+		if ext is None:
+			return None
+
+		try:
+			sst = stat(path + ext)
+		except OSError:
+			return None
+
+		if sst.st_mtime_ns < st.st_mtime_ns:
+			# Stale sibling.
+			return None
+
+		with open(path + ext, 'rb') as f:
+			return f.read()
+
+	def lookup(self, path:str, coding:str, st) -> bytes:
+		"""
+		# Retrieve the cached variant of the file at &path whose status is &st;
+		# &None when it has not been prepared.
+		"""
+		key = (path, coding, st.st_mtime_ns, st.st_size)
+
+		entries = self.v_entries
+		data = entries.get(key)
+		if data is not None:
+			entries.move_to_end(key)
+		return data
+
+	def compress(self, path:str, coding:str, st, compressors=compressors) -> bytes:
+		"""
+		# Read the precompressed sibling or compress the content of the file at &path.
+		# The cache is not modified, so this may be performed by a worker thread.
+		"""
+		data = self._v_sibling(path, coding, st)
+		if data is None:
+			c = compressors[coding]()
+			with open(path, 'rb') as f:
+				data = c.compress(f.read()) + c.flush()
+		return data
+
+	def prepare(self, system, path:str, coding:str, st):
+		"""
+		# Compress the file at &path using the worker pool of the &system context
+		# and store the variant when it completes. Does nothing when the variant
+		# is already being prepared.
+		"""
+		key = (path, coding, st.st_mtime_ns, st.st_size)
+		if key in self.v_pending:
+			return
+		self.v_pending.add(key)
+
+		def complete(data):
+			self.v_pending.discard(key)
+			if key not in self.v_entries:
+				self._v_store(key, data)
+
+		system.submit(self, complete, self.compress, path, coding, st,
+			failure=(lambda exception: self.v_pending.discard(key)))
+
+	def get(self, path:str, coding:str, stat=os.stat) -> bytes:
+		"""
+		# Retrieve the compressed content of the file at &path using &coding,
+		# compressing it in the calling thread when it is not cached.
+		"""
+		st = stat(path)
+		data = self.lookup(path, coding, st)
+		if data is not None:
+			return data
+
+		data = self.compress(path, coding, st)
+		self._v_store((path, coding, st.st_mtime_ns, st.st_size), data)
+		return data
+
+	def clear(self):
+		"""
+		# Remove all entries from the cache.
+		"""
+		self.v_entries.clear()
+		self.v_size = 0
@@ -9,6 +9,7 @@ import typing
 import collections
 import itertools
 import functools
+from email.utils import parsedate_tz, mktime_tz
 
 from ..context import tools
 from ..context.tools import cachedproperty, cachedcalls
@@ -16,6 +17,7 @@ from ..time import types as timetypes
 from ..system import memory
 
 from ..internet import http as protocol
+from ..internet import http2
 from ..internet import media
 from ..internet import ri
 
@@ -33,21 +35,29 @@ def ranges(length, range_header, decode_number=int):
 		# The (http/header)`Content-Length` of the entity body being referenced.
 	# /range_header/
 		# The (http/header)`Range` to be converted to slices.
+
+	# Raises &ValueError when a range specifier is invalid, including
+	# those whose last position precedes the first.
 	"""
 	if range_header is None:
 		yield (0, length)
 		return
 
-	for x in range_header.split():
-		if x.startswith(b'bytes='):
-			break
-	else:
+	unit, delimiter, specifiers = range_header.strip().partition(b'=')
+	if not delimiter or unit.rstrip() != b'bytes':
 		yield (0, length)
 		return
 
-	label, ranges = x.split(b'=')
-	for x in ranges.split(b','):
+	for x in specifiers.split(b','):
+		x = x.strip()
+		if not x:
+			# Empty list elements are permitted.
+			continue
+
 		start, stop = x.split(b'-')
+		start = start.strip()
+		stop = stop.strip()
+
 		if not start:
 			# empty start range
 			if not stop:
@@ -57,12 +67,148 @@ def ranges(length, range_header, decode_number=int):
 				stop = decode_number(stop)
 				yield (length - stop, length)
 		else:
+			start = decode_number(start)
 			if not stop:
 				stop = length
 			else:
-				stop = decode_number(stop) + 1
+				stop = decode_number(stop)
+				if stop < start:
+					raise ValueError("range's last position precedes its first")
+				stop += 1
+
+			yield (start, stop)
+
+def satisfiable(ranges, length:int, limit:int=16):
+	"""
+	# Normalize the ranges produced by &ranges for an entity body of &length bytes.
+	# Stops are limited to &length and unsatisfiable ranges are removed.
+
+	# Returns &None when no range is satisfiable. When more than &limit ranges
+	# or overlapping ranges are requested, the ranges are coalesced.
+	"""
+	selected = []
+	for start, stop in ranges:
+		if start < 0:
+			start = 0
+		if stop > length:
+			stop = length
+		if start < stop:
+			selected.append((start, stop))
+
+	if not selected:
+		return None
+
+	if len(selected) > 1:
+		ordered = sorted(selected)
+		coalesced = [ordered[0]]
+		for start, stop in ordered[1:]:
+			pstart, pstop = coalesced[-1]
+			if start <= pstop:
+				coalesced[-1] = (pstart, max(pstop, stop))
+			else:
+				coalesced.append((start, stop))
+
+		if len(coalesced) != len(selected) or len(coalesced) > limit:
+			selected = coalesced
+			if len(selected) > limit:
+				selected = [(selected[0][0], selected[-1][1])]
+
+	return selected
+
+def content_range(start:int, stop:int, length:int) -> bytes:
+	"""
+	# Construct the (http/header)`Content-Range` value for the exclusive &stop.
+	"""
+	return b'bytes %d-%d/%d' % (start, stop - 1, length)
+
+def byteranges(boundary:bytes, cotype:bytes, ranges, length:int):
+	"""
+	# Construct the part headers of a (http/media)`multipart/byteranges` body.
+
+	# Returns the sequence of part headers, one for each range, the closing
+	# delimiter, and the total length of the body including the ranges' content.
+	"""
+	parts = [
+		b''.join([
+			b'\r\n--', boundary, b'\r\n',
+			b'Content-Type: ', cotype, b'\r\n',
+			b'Content-Range: ', content_range(start, stop, length), b'\r\n\r\n',
+		])
+		for start, stop in ranges
+	]
+	close = b'\r\n--' + boundary + b'--\r\n'
 
-			yield (decode_number(start), stop)
+	total = sum(map(len, parts)) + len(close)
+	total += sum(stop - start for start, stop in ranges)
+	return parts, close, total
+
+def entity_tags(field:bytes) -> frozenset:
+	"""
+	# Interpret an (http/header)`If-Match` or (http/header)`If-None-Match` value.
+	# Weak indicators are removed as only weak comparison is performed.
+	"""
+	tags = set()
+	for x in field.split(b','):
+		x = x.strip()
+		if x[:2] == b'W/':
+			x = x[2:]
+		if x:
+			tags.add(x)
+	return frozenset(tags)
+
+def timestamp(field:bytes, parse=parsedate_tz, convert=mktime_tz) -> typing.Optional[int]:
+	"""
+	# Interpret an HTTP date as seconds since the Unix epoch; &None if invalid.
+	"""
+	try:
+		t = parse(field.decode('ascii'))
+		if t is None:
+			return None
+		return convert(t)
+	except (ValueError, OverflowError, UnicodeDecodeError):
+		return None
+
+def _tag_match(tags, etag):
+	if b'*' in tags:
+		return True
+	if etag[:2] == b'W/':
+		etag = etag[2:]
+	return etag in tags
+
+def precondition(struct, etag:bytes, modified:int) -> typing.Optional[bytes]:
+	"""
+	# Evaluate the conditional request fields of &struct for the representation
+	# identified by &etag last modified at &modified seconds since the Unix epoch.
+
+	# Returns (octets)`304` or (octets)`412` when the request should not be
+	# processed normally; &None if it should.
+	"""
+	c = struct.cache
+
+	im = c.get(b'if-match')
+	if im is not None:
+		if etag[:2] == b'W/' or not _tag_match(entity_tags(im), etag):
+			return b'412'
+	else:
+		ius = c.get(b'if-unmodified-since')
+		if ius is not None:
+			t = timestamp(ius)
+			if t is not None and modified > t:
+				return b'412'
+
+	safe = struct.method in {'GET', 'HEAD'}
+	inm = c.get(b'if-none-match')
+	if inm is not None:
+		if _tag_match(entity_tags(inm), etag):
+			return b'304' if safe else b'412'
+	elif safe:
+		ims = c.get(b'if-modified-since')
+		if ims is not None:
+			t = timestamp(ims)
+			if t is not None and modified <= t:
+				return b'304'
+
+	return None
 
 class Structures(object):
 	"""
@@ -165,9 +311,22 @@ class Structures(object):
 			self.host,
 			self.pathstring, self.querystring, None)
 
+	@staticmethod
+	@cachedcalls(256)
+	def uri_structure_cache(host, path, query):
+		"""
+		# Cached structure of a request URI.
+		# The returned dictionary is shared and *must not* be modified.
+		"""
+		return ri.structure(ri.Parts('authority', 'http', host, path, query, None))
+
 	@cachedproperty
 	def _uri_struct(self):
-		return ri.structure(self._uri_parts)
+		s = dict(self.uri_structure_cache(self.host, self.pathstring, self.querystring))
+		for k in ('path', 'query'):
+			if k in s:
+				s[k] = list(s[k])
+		return s
 
 	@property
 	def path(self) -> typing.Sequence[str]:
@@ -183,6 +342,15 @@ class Structures(object):
 		"""
 		return self._uri_struct.get('query')
 
+	@property
+	def multiplexed(self) -> bool:
+		"""
+		# Whether the message was received from an HTTP/2 stream;
+		# identified by the presence of pseudo-header fields.
+		"""
+		c = self.cache
+		return b':method' in c or b':status' in c
+
 	@property
 	def upgrade(self) -> bool:
 		"""
@@ -226,6 +394,28 @@ class Structures(object):
 		range_str = self.cache.get(b'range')
 		return ranges(length, range_str)
 
+	def range_applies(self, etag:bytes, modified:int) -> bool:
+		"""
+		# Whether the (http/header)`Range` field should be honored
+		# given the (http/header)`If-Range` condition, if any.
+		"""
+		c = self.cache
+		if c.get(b'range') is None:
+			return False
+
+		ir = c.get(b'if-range')
+		if ir is None:
+			return True
+
+		ir = ir.strip()
+		if ir[:1] == b'"':
+			# Strong comparison.
+			return ir == etag
+		elif ir[:2] == b'W/':
+			return False
+
+		return timestamp(ir) == modified
+
 	@cachedproperty
 	def upgrade_insecure(self):
 		"""
@@ -306,6 +496,8 @@ class Structures(object):
 
 			b':Method',
 			b':URI',
+			b':Authority',
+			b':Status',
 		]
 	)
 
@@ -317,8 +509,7 @@ class Structures(object):
 		return self.cache.get(b'connection', b'').strip().lower()
 
 	@staticmethod
-	@cachedcalls(32)
-	def media_range_cache(range_data, parse_range=media.Range.from_bytes):
+	def media_range_cache(range_data, parse_range=media.range_from_bytes):
 		"""
 		# Cached access to a media range header.
 		"""
@@ -362,7 +553,8 @@ class Structures(object):
 		"""
 		# Decoded host header.
 		"""
-		return self.cache.get(b'host', b'').decode('idna')
+		c = self.cache
+		return (c.get(b'host') or c.get(b':authority') or b'').decode('idna')
 
 	@property
 	def encoding(self) -> str:
@@ -375,11 +567,32 @@ class Structures(object):
 	def final(self) -> bool:
 		"""
 		# Whether this is suppoed to be the last transaction in the connection.
+		# Always &False for HTTP/2 as messages do not manage the connection.
 		"""
 
+		if self.multiplexed:
+			return False
+
 		cxn = self.cache.get(b'connection')
 		return cxn == b'close' or not cxn
 
+	def persistent(self, version:bytes) -> bool:
+		"""
+		# Whether the connection remains open after a message of the given HTTP &version.
+		# (internet/protocol)`HTTP/1.1` connections persist unless closed by the
+		# (http/header)`Connection` field, and (internet/protocol)`HTTP/1.0`
+		# connections only persist when (id)`keep-alive` is present.
+		# Always &True for HTTP/2 as messages do not manage the connection.
+		"""
+
+		if self.multiplexed:
+			return True
+
+		options = {x.strip() for x in self.connection.split(b',')}
+		if version == b'HTTP/1.0':
+			return b'keep-alive' in options
+		return b'close' not in options
+
 def _join_send_wire(event, channel_id, transfer_events):
 	assert event == flows.fe_transfer
 	return [(-3, transfer_events)]
@@ -455,6 +668,9 @@ def join(
 	):
 	"""
 	# Join flow events into a proper HTTP stream.
+
+	# The HTTP events of a batch are serialized together so that
+	# pipelined responses are emitted as a single transfer.
 	"""
 
 	serializer = protocol.assembly()
@@ -477,11 +693,14 @@ def join(
 	try:
 		while True:
 			events = (yield transfer)
-			transfer = []
+			messages = []
 			for event in events:
-				transfer += serialize(
-					transformer(event[0])(*event)
-				)
+				messages.extend(transformer(event[0])(*event))
+
+			if messages:
+				transfer = serialize(messages)
+			else:
+				transfer = ()
 	finally:
 		# GeneratorExit
 		commands.clear()
@@ -697,9 +916,10 @@ class RXProtocol(flows.Protocol):
 	def allocate_server_response(parameter):
 		"""
 		# For use by clients receiving the server response.
+		# The version is included in order to identify the persistence of the connection.
 		"""
 		(version, code, description), headers = parameter
-		return (code, description, headers), version
+		return (code, description, headers, version), version
 
 	def p_close(self):
 		pass
@@ -719,6 +939,341 @@ class RXProtocol(flows.Protocol):
 		self.p_transfer = self.p_local.send
 		self.p_transfer(None)
 
+def _v2_fields(headers, exclude=http2.connection_headers):
+	if headers.__class__ is protocol.Fields:
+		headers = headers.complete()
+	return [(k.lower(), v) for k, v in headers if k.lower() not in exclude]
+
+class TXProtocolV2(TXProtocol):
+	"""
+	# Protocol class sending HTTP/2 frames.
+
+	# Joined channels are interleaved; servers use the channel identifier as
+	# the stream identifier, and clients open a stream for each initiated channel.
+	"""
+
+	p_sequenced = False
+
+	@staticmethod
+	def initiate_server_request(state, parameter, fields=_v2_fields):
+		"""
+		# Used by clients to construct the request's header block.
+		"""
+		method, path, headers, length = parameter
+
+		authority = b''
+		for k, v in headers:
+			if k.lower() == b'host':
+				authority = v
+				break
+
+		return [
+			(b':method', method),
+			(b':scheme', state['scheme']),
+			(b':authority', authority),
+			(b':path', path),
+		] + fields(headers)
+
+	@staticmethod
+	def initiate_client_response(state, parameter, fields=_v2_fields):
+		"""
+		# Used by servers to construct the response's header block.
+		"""
+		code, description, headers, length = parameter
+		return [(b':status', code)] + fields(headers)
+
+	def __init__(self, state, initiate, connection):
+		self.p_shared = state
+		self.p_initiate = initiate
+		self.p_connection = connection
+		self.p_transfer = self.p_frames
+
+	def p_select(self, multiplexed:bool):
+		"""
+		# Configure the instance for the protocol identified by an adjustable receive.
+		"""
+		if multiplexed:
+			self.p_connection = http2.Connection(self.p_shared['disposition'])
+			self.f_upstream().cat_interleave()
+		else:
+			TXProtocol.__init__(self, self.p_shared, TXProtocol.initiate_client_response)
+
+	def p_frames(self, events,
+			fc_initiate=flows.fe_initiate,
+			fc_transfer=flows.fe_transfer,
+		):
+		c = self.p_connection
+		streams = self.p_shared.get('streams')
+
+		for event, channel_id, parameter in events:
+			if event == fc_initiate:
+				if parameter is None:
+					raise Exception("raw transfers are not supported by HTTP/2")
+
+				if streams is not None:
+					sid = c.open()
+					streams[channel_id] = sid
+					self.p_shared['channels'][sid] = channel_id
+				else:
+					sid = channel_id
+
+				c.headers(sid, self.p_initiate(self.p_shared, parameter))
+			elif event == fc_transfer:
+				sid = streams[channel_id] if streams is not None else channel_id
+				for x in parameter:
+					c.data(sid, x)
+			else:
+				if streams is not None:
+					sid = streams.pop(channel_id)
+				else:
+					sid = channel_id
+				c.data(sid, b'', True)
+
+		return c.transmit()
+
+	def f_terminate(self):
+		c = self.p_connection
+		if c is not None and not c.c_closed:
+			c.goaway()
+			self.f_emit(c.transmit())
+		self._f_terminated()
+
+class RXProtocolV2(RXProtocol):
+	"""
+	# Protocol class receiving HTTP/2 frames.
+
+	# Holds a strong reference to the corresponding &TXProtocolV2 in order
+	# to send the frames produced by receiving: acknowledgements, window updates,
+	# and data released by window updates.
+
+	# Received DATA is noted as consumed once it has been emitted while the
+	# channel is not obstructed; while obstructed, the octets are withheld
+	# from the peer's windows until the obstruction is cleared.
+
+	# [ Properties ]
+	# /p_withheld/
+		# Octets of emitted DATA by stream that have not been noted as consumed.
+	"""
+
+	def __init__(self, state, allocate, connection, transmit):
+		self.p_shared = state
+		self.p_allocate = allocate
+		self.p_connection = connection
+		self.p_transmit = transmit
+		self.p_initiated = {} # stream to channel
+		self.p_withheld = {}
+		self.p_prefix = b''
+		self.p_transfer = self.p_streams
+
+	def f_transfer(self, event):
+		super().f_transfer(event)
+		if self.p_withheld and not self.f_obstructed:
+			self._p_release()
+
+	def f_clear(self, obstruction):
+		cleared = super().f_clear(obstruction)
+		if cleared and self.p_withheld:
+			self._p_release()
+		return cleared
+
+	def _p_release(self):
+		"""
+		# Note the withheld octets as consumed and send the resulting window updates.
+		"""
+		c = self.p_connection
+		withheld = self.p_withheld
+		self.p_withheld = {}
+
+		for sid, size in withheld.items():
+			c.consumed(sid, size)
+
+		if c.pending:
+			self.p_transmit.p_drain()
+
+	def p_select(self, data, preface=http2.preface):
+		"""
+		# Identify the protocol using the connection preface.
+		# Used by adjustable servers.
+		"""
+		prefix = self.p_prefix + b''.join(data)
+		n = min(len(prefix), len(preface))
+
+		if prefix[:n] != preface[:n]:
+			# HTTP/1.x
+			RXProtocol.__init__(self, self.p_shared, self.p_allocate)
+			self.p_transmit.p_select(False)
+			self.p_prefix = b''
+			return self.p_transfer((prefix,))
+		elif n < len(preface):
+			self.p_prefix = prefix
+			return ()
+
+		self.p_shared['version'] = b'HTTP/2'
+		self.p_transmit.p_select(True)
+		self.p_connection = self.p_transmit.p_connection
+		self.p_transfer = self.p_streams
+		self.p_prefix = b''
+		return self.p_streams((prefix,))
+
+	def _p_initiate(self, sid, headers):
+		fields = dict(x for x in headers if x[0][:1] == b':')
+
+		if self.p_shared['disposition'] == 'client':
+			status = fields.get(b':status')
+			if status is None:
+				self.p_connection.reset(sid, http2.ec_protocol_error)
+				return None
+			if status[:1] == b'1':
+				# Informational.
+				return False
+
+			channel_id = self.p_shared['channels'].pop(sid, None)
+			if channel_id is None:
+				self.p_connection.reset(sid, http2.ec_protocol_error)
+				return None
+			rline = (b'HTTP/2', status, b'')
+		else:
+			method = fields.get(b':method')
+			path = fields.get(b':path')
+			if method is None or path is None:
+				self.p_connection.reset(sid, http2.ec_protocol_error)
+				return None
+
+			channel_id = sid
+			rline = (method, path, b'HTTP/2')
+
+		initiate, version = self.p_allocate((rline, headers))
+		return (flows.fe_initiate, channel_id, initiate)
+
+	def _p_abandon(self, add, sid, error,
+			fc_initiate=flows.fe_initiate,
+			fc_terminate=flows.fe_terminate,
+		):
+		"""
+		# Fault the channel of a client stream that was abandoned before the
+		# response's headers were received; the channel is initiated with
+		# the &http2.Error as its parameter and immediately terminated.
+		"""
+		channel_id = self.p_shared['channels'].pop(sid)
+		add((fc_initiate, channel_id, error))
+		add((fc_terminate, channel_id, None))
+
+	def p_streams(self, data,
+			ev_headers=http2.ev_headers,
+			ev_data=http2.ev_data,
+			ev_goaway=http2.ev_goaway,
+			fc_transfer=flows.fe_transfer,
+			fc_terminate=flows.fe_terminate,
+		):
+		c = self.p_connection
+		initiated = self.p_initiated
+		pending = self.p_shared.get('channels', {}) # Client streams without response headers.
+		withheld = self.p_withheld
+		local = 1 if c.c_client else 0
+		flow_events = []
+		add = flow_events.append
+
+		for x in data:
+			for event in c.receive(x):
+				ev = event[0]
+
+				if ev == ev_headers:
+					sid, headers, end = event[1:]
+					if sid not in initiated:
+						init = self._p_initiate(sid, headers)
+						if not init:
+							continue
+						add(init)
+						initiated[sid] = init[1]
+					if end:
+						add((fc_terminate, initiated.pop(sid), None))
+				elif ev == ev_data:
+					sid, content, end = event[1:]
+					if sid in initiated:
+						if content:
+							add((fc_transfer, initiated[sid], [content]))
+						if end:
+							add((fc_terminate, initiated.pop(sid), None))
+
+					if content:
+						# Released by &f_transfer or &f_clear; discarded content included.
+						withheld[sid] = withheld.get(sid, 0) + len(content)
+				elif ev == ev_goaway:
+					if c.c_closed:
+						# Connection error; no further events will be produced.
+						closed = list(initiated)
+						self.enqueue(self.p_shutdown)
+					else:
+						# Only locally initiated streams are identified by last_stream.
+						last = event[1]
+						closed = [x for x in initiated if x % 2 == local and x > last]
+
+					for sid in closed:
+						add((fc_terminate, initiated.pop(sid), None))
+
+					last = event[1] if not c.c_closed else 0
+					for sid in [x for x in pending if x > last]:
+						error = http2.Error(event[2], 0, "connection closed before the response was received")
+						self._p_abandon(add, sid, error)
+				elif event[1] in initiated:
+					# Reset; truncated message.
+					add((fc_terminate, initiated.pop(event[1]), None))
+				elif event[1] in pending:
+					# Reset before the response; REFUSED_STREAM, for instance.
+					error = http2.Error(event[2], event[1], "stream reset before the response was received")
+					self._p_abandon(add, event[1], error)
+
+		if c.pending:
+			self.p_transmit.p_drain()
+
+		return flow_events
+
+	def p_shutdown(self):
+		"""
+		# Terminate the transport after a connection error.
+		# Sends the GOAWAY frame and closes both directions regardless
+		# of the state of the joined channels.
+		"""
+		tx = self.p_transmit
+		tx.p_drain()
+		tx.terminate()
+
+		xact = self.sector
+		if xact is not None:
+			xact.terminate()
+
+def allocate_client_protocol_v2(scheme:bytes=b'https'):
+	"""
+	# Allocate an HTTP/2 protocol pair for a client using prior knowledge
+	# or an ALPN selected (id)`h2`.
+	"""
+	state = {
+		'version': b'HTTP/2',
+		'disposition': 'client',
+		'scheme': scheme,
+		'streams': {},
+		'channels': {},
+	}
+	c = http2.Connection('client')
+	po = TXProtocolV2(state, TXProtocolV2.initiate_server_request, c)
+	pi = RXProtocolV2(state, RXProtocol.allocate_server_response, c, po)
+	index = ('http', None)
+	return (index, (pi, po))
+
+def allocate_server_protocol_v2():
+	"""
+	# Allocate an HTTP/2 protocol pair for a server using prior knowledge.
+	"""
+	state = {
+		'version': b'HTTP/2',
+		'disposition': 'server',
+	}
+	c = http2.Connection('server')
+	po = TXProtocolV2(state, TXProtocolV2.initiate_client_response, c)
+	pi = RXProtocolV2(state, RXProtocol.allocate_client_request, c, po)
+	index = ('http', None)
+	return (index, (pi, po))
+
 def allocate_client_protocol(version:bytes=b'HTTP/1.1'):
 	state = {
 		'version': version,
@@ -729,7 +1284,7 @@ def allocate_client_protocol(version:bytes=b'HTTP/1.1'):
 	index = ('http', None)
 	return (index, (pi, po))
 
-def allocate_server_protocol(version:bytes=b'HTTP/1.1'):
+def allocate_server_protocol_v1(version:bytes=b'HTTP/1.1'):
 	state = {
 		'version': version,
 		'disposition': 'server',
@@ -739,9 +1294,22 @@ def allocate_server_protocol(version:bytes=b'HTTP/1.1'):
 	index = ('http', None)
 	return (index, (pi, po))
 
-allocate_client_protocol_v1 = allocate_client_protocol
-allocate_server_protocol_v1 = allocate_server_protocol
+def allocate_server_protocol(version:bytes=b'HTTP/1.1'):
+	"""
+	# Allocate an adjustable protocol pair for a server.
+	# HTTP/2 is used when the connection begins with its preface, which
+	# is the case for prior knowledge and ALPN selected (id)`h2` connections;
+	# HTTP/1.x is used otherwise.
+	"""
+	state = {
+		'version': version,
+		'disposition': 'server',
+	}
+	po = TXProtocolV2(state, TXProtocolV2.initiate_client_response, None)
+	po.p_sequenced = True
+	pi = RXProtocolV2(state, RXProtocol.allocate_client_request, None, po)
+	pi.p_transfer = pi.p_select
+	index = ('http', None)
+	return (index, (pi, po))
 
-if False:
-	allocate_client_protocol_v2 = None
-	allocate_server_protocol_v2 = None
+allocate_client_protocol_v1 = allocate_client_protocol
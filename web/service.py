@@ -13,6 +13,7 @@ from ..kernel import io
 
 from ..internet import ri
 from . import http
+from . import encoding
 
 # XXX: Waiting for refactored kio.Interface
 def _prepare_http_transports_v0(ifctx, ports, Protocol=http.allocate_server_protocol):
@@ -21,13 +22,13 @@ def _prepare_http_transports_v0(ifctx, ports, Protocol=http.allocate_server_prot
 def _prepare_http_transports_v1(ifctx, ports, Protocol=http.allocate_server_protocol_v1):
 	return [(x, (), Protocol()) for x in ports]
 
-def _prepare_http_transports_v2(ifctx, ports, Protocol=None):
-	raise Exception("not implemented")
+def _prepare_http_transports_v2(ifctx, ports, Protocol=http.allocate_server_protocol_v2):
+	return [(x, (), Protocol()) for x in ports]
 
 protocols = {
 	'http': _prepare_http_transports_v0, # Adjustable.
 	'http-1': _prepare_http_transports_v1, # Strictly 1.0/1.1 only.
-	'http-2': _prepare_http_transports_v2, # Not implemented
+	'http-2': _prepare_http_transports_v2, # Prior knowledge.
 }
 
 class Controller(object):
@@ -91,6 +92,14 @@ class Controller(object):
 		self.http_response_headers.extend(pairs)
 	extend_headers = http_extend_headers
 
+	def http_set_template(self, template:http.protocol.Template) -> None:
+		"""
+		# Use the precompiled &template as the leading fields of the response.
+		# Headers that were already added follow the template's fields.
+		"""
+		self.http_response_headers = self.response_headers = \
+			http.protocol.Fields(template, self.http_response_headers)
+
 	def http_set_response(self, code:bytes, descr:bytes, length:int, cotype:bytes=None):
 		"""
 		# Assign the status of the response and designate the transfer encoding.
@@ -148,17 +157,38 @@ class Controller(object):
 			lstr = str(length).encode('ascii')
 			rh.append((b'Content-Length', lstr))
 
-	def http_dispatch_output(self, channel):
+	def http_select_coding(self, available=encoding.compressors):
+		"""
+		# Negotiate the content coding of the response using the request's
+		# (http/header)`Accept-Encoding` field. When a coding is selected,
+		# (http/header)`Content-Encoding` is added to the response and the
+		# coding's identifier is returned.
+		"""
+		coding = encoding.select(self.request.cache.get(b'accept-encoding'), available)
+
+		self.http_add_header(b'Vary', b'Accept-Encoding')
+		if coding is not None:
+			self.http_add_header(b'Content-Encoding', coding.encode('ascii'))
+
+		return coding
+
+	def http_dispatch_output(self, channel, coding:str=None):
 		"""
 		# Dispatch the given &channel using a new &io.Transfer instance into &invocations'
 		# &io.Transport transaction.
+
+		# When &coding is not &None, the transfers are compressed by an
+		# &encoding.Compression stage; the response's length should be &None.
 		"""
 		output_source = flows.Relay(self.invocations.i_catenate, self._request_channel_id)
 
 		xf = io.Transfer()
 		ox = core.Transaction.create(xf)
 		self.invocations.sector.dispatch(ox)
-		xf.io_flow([channel, output_source])
+		if coding is None:
+			xf.io_flow([channel, output_source])
+		else:
+			xf.io_flow([channel, encoding.Compression(coding), output_source])
 
 		self.connect(output_source)
 
@@ -411,11 +441,16 @@ class Files(Partition):
 		from . import system
 		self.fs_routes = [files.Path.from_path(x) for x in argv]
 		self.fs_handler = system.select_filesystem_resource
+		self.fs_cache = system.Cache()
 
 	def part_select(self, ctl):
 		ctl.accept(None)
 		rpath = ctl.request.path[self.part_depth:]
-		return self.fs_handler(self.host.h_error, self.fs_routes, ctl, self.part_path, rpath)
+		return self.fs_handler(self.host.h_error, self.fs_routes, ctl, self.part_path, rpath, self.fs_cache)
+
+	def terminate(self):
+		self.fs_cache.clear()
+		super().terminate()
 
 class Host(core.Context):
 	"""
@@ -444,6 +479,9 @@ class Host(core.Context):
 
 	# /h_headers/
 		# Headers added to every response routed to this host.
+	# /h_template/
+		# The precompiled block of &h_headers followed by the (http/header)`Date`.
+		# Rebuilt when &h_headers is assigned or modified.
 
 	# [ Engineering ]
 	# While proper caching should be handled by a proxy, caching of "constants"
@@ -480,6 +518,17 @@ class Host(core.Context):
 	h_allowed_methods = h_defaults['h_allowed_methods']
 	h_redirects = None
 	h_headers = ()
+	_h_template = (h_headers, http.protocol.Template(h_headers))
+
+	@property
+	def h_template(self):
+		source, template = self._h_template
+		headers = self.h_headers
+		if source != headers:
+			template = http.protocol.Template(headers)
+			# Copied so that modifications of &h_headers are identified.
+			self._h_template = (headers[:], template)
+		return template
 
 	def actuate(self):
 		self.provide('host')
@@ -626,7 +675,7 @@ class Host(core.Context):
 		# Route the request to the identified partition.
 		"""
 
-		ctl.http_extend_headers(self.h_headers)
+		ctl.http_set_template(self.h_template)
 		path = ctl.request.pathstring
 		initial = self.h_root.get(path, None)
 
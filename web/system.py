@@ -1,13 +1,26 @@
 """
 # System interfaces supporting web services.
 """
+import os
 import itertools
+import functools
 import typing
+import collections
 
 from ..internet import media
 from ..internet import xml
-from ..system.files import Path
+from ..system import memory
+from ..system.files import Path, Status
+from . import encoding
+from . import http
 
+# Compressed variants of static files no larger than &variant_limit.
+# Larger files are compressed as they are transferred.
+variants = encoding.Variants()
+variant_limit = 1024 * 1024 * 2
+
+# Delimiter of (http/media)`multipart/byteranges` responses.
+boundary = os.urandom(12).hex().encode('ascii')
 
 def calculate_range(ranges, size, list=list, sum=sum):
 	if ranges is not None:
@@ -183,11 +196,406 @@ def materialize_text_index(ctl, root, rpath, rpoints, routes):
 		for row in records
 	]).encode('utf-8')
 
+def etag(st:os.stat_result) -> bytes:
+	"""
+	# Entity tag identifying the version of a file by its size and modification time.
+	"""
+	return b'"%x-%x"' % (st.st_size, st.st_mtime_ns)
+
+def variant_etag(etag:bytes, coding:str) -> bytes:
+	"""
+	# Entity tag of the representation of &etag encoded with &coding.
+	"""
+	if coding is None:
+		return etag
+	return etag[:-1] + b'-' + coding.encode('ascii') + b'"'
+
+class Resource(object):
+	"""
+	# Cached file contents with the fields of its responses prepared.
+
+	# [ Properties ]
+	# /r_path/
+		# The filesystem path of the file.
+	# /r_type/
+		# The media type of the file.
+	# /r_version/
+		# The modification time and size of the file at the time it was read.
+	# /r_modified/
+		# The modification time in seconds since the Unix epoch.
+	# /r_last_modified/
+		# The (http/header)`Last-Modified` value.
+	# /r_etag/
+		# The entity tag of the cached version.
+	# /r_compressible/
+		# Whether content codings should be negotiated.
+	# /r_variants/
+		# Mapping of content codings to the prepared fields, body, and entity tag.
+		# &None identifies the unencoded content.
+	"""
+
+	__slots__ = (
+		'r_path',
+		'r_type',
+		'r_version',
+		'r_modified',
+		'r_last_modified',
+		'r_etag',
+		'r_compressible',
+		'r_variants',
+		'_r_fields',
+	)
+
+	def __init__(self, path:str, cotype:str, status:Status, body:bytes):
+		st = status.system
+		self.r_path = path
+		self.r_type = media.type_from_string(cotype)
+		self.r_version = (st.st_mtime_ns, st.st_size)
+		self.r_modified = int(st.st_mtime)
+		self.r_etag = etag(st)
+		self.r_compressible = encoding.compressible_type(cotype)
+
+		self.r_last_modified = status.last_modified.select('rfc').encode('utf-8')
+		self.r_variants = {}
+		self._r_fields = [
+			(b'Last-Modified', self.r_last_modified),
+			(b'Content-Type', cotype.encode('utf-8')),
+		]
+		self.r_variants[None] = (
+			self._r_fields + [
+				(b'ETag', self.r_etag),
+				(b'Accept-Ranges', b'bytes'),
+				(b'Content-Length', str(len(body)).encode('ascii')),
+			],
+			body,
+			self.r_etag,
+		)
+
+	@property
+	def r_size(self) -> int:
+		"""
+		# The number of bytes held by the resource.
+		"""
+		return sum(len(x[1]) for x in self.r_variants.values())
+
+	@staticmethod
+	def compress(body:bytes, coding:str, compressors=encoding.compressors) -> bytes:
+		"""
+		# Encode &body using &coding. Used by worker threads to prepare variants.
+		"""
+		c = compressors[coding]()
+		return c.compress(body) + c.flush()
+
+	def store(self, coding:str, body:bytes):
+		"""
+		# Prepare the fields and entity tag of the variant &body encoded with &coding.
+		"""
+		tag = variant_etag(self.r_etag, coding)
+		v = self.r_variants[coding] = (
+			self._r_fields + [
+				(b'ETag', tag),
+				(b'Content-Length', str(len(body)).encode('ascii')),
+			],
+			body,
+			tag,
+		)
+		return v
+
+	def select(self, coding:str=None):
+		"""
+		# Retrieve the prepared fields, body, and entity tag for the given content &coding.
+		# Encoded variants are given distinct entity tags.
+		"""
+		v = self.r_variants.get(coding)
+		if v is None:
+			v = self.store(coding, self.compress(self.r_variants[None][1], coding))
+		return v
+
+class Cache(object):
+	"""
+	# Bounded, least recently used, cache of small files.
+
+	# Entries are validated on every retrieval by comparing the status of the file
+	# with the cached version; the status is normally the one already retrieved
+	# while resolving the request's path.
+
+	# [ Properties ]
+	# /c_limit/
+		# The maximum number of bytes held by the cache.
+	# /c_entry_limit/
+		# The maximum size of a file that will be cached.
+	# /c_size/
+		# The number of bytes currently held.
+	# /c_entries/
+		# Ordered mapping of keys, normally resolved file paths, to &Resource instances;
+		# least recently used first.
+	# /c_pending/
+		# The keys of entries and variants being read or compressed by workers.
+	"""
+
+	def __init__(self, limit:int=1024*1024*64, entry_limit:int=1024*256):
+		self.c_limit = limit
+		self.c_entry_limit = entry_limit
+		self.c_size = 0
+		self.c_entries = collections.OrderedDict()
+		self.c_pending = set()
+
+	def get(self, key, status:Status=None, stat=os.stat) -> Resource:
+		"""
+		# Retrieve the cached &Resource for &key; &None if not present or changed.
+		# When given, &status is the current status of the file and is used in place
+		# of inspecting it.
+		"""
+		r = self.c_entries.get(key)
+		if r is None:
+			return None
+
+		try:
+			st = stat(r.r_path) if status is None else status.system
+		except OSError:
+			self.discard(key)
+			return None
+
+		if (st.st_mtime_ns, st.st_size) != r.r_version:
+			self.discard(key)
+			return None
+
+		self.c_entries.move_to_end(key)
+		return r
+
+	def load(self, key, path:str, cotype:str, status:Status) -> Resource:
+		"""
+		# Read and cache the file at &path identified by &key.
+		"""
+		with open(path, 'rb') as f:
+			body = f.read()
+
+		return self.insert(key, path, cotype, status, body)
+
+	@staticmethod
+	def read(path:str) -> bytes:
+		"""
+		# Read the file at &path. Performed by worker threads for &prepare.
+		"""
+		with open(path, 'rb') as f:
+			return f.read()
+
+	def prepare(self, system, key, path:str, cotype:str, status:Status):
+		"""
+		# Read the file at &path using the worker pool of the &system context
+		# and cache it when the read completes.
+		"""
+		pkey = (key, None)
+		if pkey in self.c_pending:
+			return
+		self.c_pending.add(pkey)
+
+		def complete(body):
+			self.c_pending.discard(pkey)
+			self.insert(key, path, cotype, status, body)
+
+		system.submit(self, complete, self.read, path,
+			failure=(lambda exception: self.c_pending.discard(pkey)))
+
+	def prepare_variant(self, system, key, r:Resource, coding:str):
+		"""
+		# Compress the content of &r with &coding using the worker pool of the
+		# &system context and store the variant when it completes.
+		"""
+		pkey = (key, coding)
+		if pkey in self.c_pending:
+			return
+		self.c_pending.add(pkey)
+
+		def complete(body):
+			self.c_pending.discard(pkey)
+			if coding not in r.r_variants:
+				v = r.store(coding, body)
+				if self.c_entries.get(key) is r:
+					self.c_size += len(v[1])
+					self._c_reduce()
+
+		system.submit(self, complete, r.compress, r.r_variants[None][1], coding,
+			failure=(lambda exception: self.c_pending.discard(pkey)))
+
+	def insert(self, key, path:str, cotype:str, status:Status, body:bytes) -> Resource:
+		"""
+		# Cache the &body read from the file at &path identified by &key.
+		"""
+		self.discard(key)
+
+		r = Resource(path, cotype, status, body)
+		if len(body) != status.size:
+			# Modified while being read; serve, but do not cache.
+			return r
+
+		self.c_entries[key] = r
+		self.c_size += len(body)
+		self._c_reduce()
+		return r
+
+	def _c_reduce(self):
+		while self.c_size > self.c_limit and self.c_entries:
+			self.discard(next(iter(self.c_entries)))
+
+	def select(self, key, r:Resource, coding:str=None):
+		"""
+		# Retrieve the prepared fields, body, and entity tag of &r accounting for new variants.
+		"""
+		if coding in r.r_variants:
+			return r.r_variants[coding]
+
+		v = r.select(coding)
+		if self.c_entries.get(key) is r:
+			self.c_size += len(v[1])
+			self._c_reduce()
+		return v
+
+	def discard(self, key):
+		"""
+		# Remove the entry identified by &key.
+		"""
+		r = self.c_entries.pop(key, None)
+		if r is None:
+			return
+
+		self.c_size -= r.r_size
+
+	def clear(self):
+		"""
+		# Remove all entries from the cache.
+		"""
+		for key in list(self.c_entries):
+			self.discard(key)
+
+def requested_ranges(req, length:int):
+	"""
+	# The satisfiable ranges of the request's (http/header)`Range` field.
+	# &None if none are satisfiable, and an empty list if the field is
+	# invalid and should be ignored.
+	"""
+	if b'bytes=' not in req.cache.get(b'range', b''):
+		# Unsupported range unit.
+		return []
+
+	try:
+		return http.satisfiable(req.byte_ranges(length), length)
+	except ValueError:
+		return []
+
+def send_precondition(error, ctl, status:bytes, etag:bytes, last_modified:bytes):
+	"""
+	# Respond to a request whose preconditions were not met.
+	"""
+	if status == b'304':
+		ctl.http_extend_headers([
+			(b'ETag', etag),
+			(b'Last-Modified', last_modified),
+		])
+		ctl.http_set_response(b'304', b'NOT MODIFIED', None)
+		ctl.connect(None)
+	else:
+		error(ctl, 412, None)
+
+def send_ranges(error, ctl, method, cotype:bytes, length:int, ranges, select):
+	"""
+	# Respond with the &ranges of a representation of &length bytes.
+	# &select is called with the start and stop of a range and
+	# returns an iterable of buffers holding its content.
+	"""
+	if ranges is None:
+		ctl.http_add_header(b'Content-Range', b'bytes */%d' % (length,))
+		error(ctl, 416, None)
+		return
+
+	if len(ranges) == 1:
+		start, stop = ranges[0]
+		ctl.http_add_header(b'Content-Range', http.content_range(start, stop, length))
+		ctl.http_set_response(b'206', b'PARTIAL CONTENT', stop - start, cotype=cotype)
+		body = ((x,) for x in select(start, stop))
+	else:
+		parts, close, total = http.byteranges(boundary, cotype, ranges, length)
+		mcotype = b'multipart/byteranges; boundary=' + boundary
+		ctl.http_set_response(b'206', b'PARTIAL CONTENT', total, cotype=mcotype)
+		body = _byteranges(parts, close, ranges, select)
+
+	if method == 'GET':
+		ctl.http_iterate_output(body)
+	else:
+		ctl.connect(None)
+
+def _byteranges(parts, close, ranges, select):
+	for part, (start, stop) in zip(parts, ranges):
+		yield (part,)
+		for x in select(start, stop):
+			yield (x,)
+	yield (close,)
+
+def select_coding(ctl, ranged:bool, available, prepare):
+	"""
+	# Select the content coding of the response to a compressible resource.
+
+	# Ranges address the identity representation, so ranged responses only note
+	# the variance. Codings that are not &available are compressed by a worker
+	# using &prepare, and the identity coding is served until they are ready.
+	"""
+	if ranged:
+		ctl.http_add_header(b'Vary', b'Accept-Encoding')
+		return None
+
+	coding = encoding.select(ctl.request.cache.get(b'accept-encoding'))
+	if coding is not None and not available(coding):
+		prepare(ctl.invocations.system, coding)
+		coding = None
+
+	return ctl.http_select_coding(() if coding is None else (coding,))
+
+def send_cached_resource(error, ctl, cache, key, r:Resource, method):
+	"""
+	# Respond with the content of a &Resource held by &cache.
+	"""
+	req = ctl.request
+	ranged = req.range_applies(r.r_etag, r.r_modified)
+
+	coding = None
+	if r.r_compressible:
+		coding = select_coding(ctl, ranged, r.r_variants.__contains__,
+			(lambda system, coding: cache.prepare_variant(system, key, r, coding)))
+
+	fields, body, tag = cache.select(key, r, coding)
+
+	status = http.precondition(req, tag, r.r_modified)
+	if status is not None:
+		send_precondition(error, ctl, status, tag, r.r_last_modified)
+		return
+
+	if ranged:
+		ranges = requested_ranges(req, len(body))
+		if ranges != []:
+			ctl.http_extend_headers([
+				(b'Last-Modified', r.r_last_modified),
+				(b'ETag', tag),
+				(b'Accept-Ranges', b'bytes'),
+			])
+			cotype = r._r_fields[1][1]
+			view = memoryview(body)
+			send_ranges(error, ctl, method, cotype, len(body), ranges, (lambda x, y: (view[x:y],)))
+			return
+
+	ctl.http_extend_headers(fields)
+	ctl.http_set_response(b'200', b'OK', len(body))
+
+	if method == 'GET':
+		ctl.http_iterate_output([(body,)])
+	else:
+		ctl.connect(None)
+
 supported_directory_types = (
-	media.type_from_bytes(b'application/json'),
-	media.type_from_bytes(b'text/xml'),
 	media.type_from_bytes(b'text/plain'),
+	media.type_from_bytes(b'text/xml'),
+	media.type_from_bytes(b'application/json'),
 )
+directory_index = media.Index(supported_directory_types)
 
 directory_materialization = {
 	media.type_from_bytes(b'application/json'): materialize_json_index,
@@ -195,9 +603,13 @@ directory_materialization = {
 	media.type_from_bytes(b'text/plain'): materialize_text_index,
 }
 
-def select_filesystem_resource(error, routes, ctl, root, rpath):
+def select_filesystem_resource(error, routes, ctl, root, rpath, cache=None):
 	"""
 	# Identify a target resource and materialize a response.
+
+	# When &cache is given, small files are held in memory keyed by the resolved
+	# file path. Files not yet cached are read by a worker while the request is
+	# answered from the file.
 	"""
 	req = ctl.request
 
@@ -213,6 +625,8 @@ def select_filesystem_resource(error, routes, ctl, root, rpath):
 	mrange = req.media_range
 	selection_status = None
 
+	cacheable = cache is not None and method != 'OPTIONS'
+
 	# Find file.
 	try:
 		if rpoints:
@@ -253,7 +667,7 @@ def select_filesystem_resource(error, routes, ctl, root, rpath):
 			selection += ['.index', 'default.html']
 			selection_status = selection.fs_status()
 		else:
-			preferred_media_type = mrange.query(*supported_directory_types)
+			preferred_media_type = directory_index.query(mrange)
 
 			if preferred_media_type is None:
 				error(ctl, 406, None)
@@ -279,34 +693,79 @@ def select_filesystem_resource(error, routes, ctl, root, rpath):
 			error(ctl, 406, None)
 			return
 
-		if req.has(b'range'):
-			req_ranges = list(ctl.request.byte_ranges(cosize))
-			res = b'206'
-			descr = b'PARTIAL CONTENT'
-			cr = b'bytes %d-%d/%d' %(req_ranges[0][0], req_ranges[0][1], cosize)
-			ctl.http_add_header(b'Content-Range', cr)
-		else:
-			req_ranges = None
-			res = b'200'
-			descr = b'OK'
-		ranges, rsize = calculate_range(req_ranges, cosize)
+		if cacheable and cosize <= cache.c_entry_limit and selection_status.type == 'data':
+			key = str(selection)
+			r = cache.get(key, selection_status)
+			if r is not None:
+				send_cached_resource(error, ctl, cache, key, r, method)
+				return
+			cache.prepare(ctl.invocations.system, key, key, cotype, selection_status)
+
+		st = selection_status.system
+		modified = int(st.st_mtime)
+		tag = etag(st)
+		ranged = req.range_applies(tag, modified)
+
+		coding = None
+		if encoding.compressible_type(cotype):
+			# Larger resources are compressed as they are sent.
+			def available(coding):
+				return cosize > variant_limit or variants.lookup(str(selection), coding, st) is not None
+			def prepare(system, coding):
+				variants.prepare(system, str(selection), coding, st)
+
+			coding = select_coding(ctl, ranged, available, prepare)
+			tag = variant_etag(tag, coding)
 
 		ct = cotype.encode('utf-8')
-		lm = selection_status.last_modified
+		lm = selection_status.last_modified.select('rfc').encode('utf-8')
+
+		# Evaluated before the file is opened.
+		status = http.precondition(req, tag, modified)
+		if status is not None:
+			send_precondition(error, ctl, status, tag, lm)
+			return
 
 		ctl.http_extend_headers([
-			(b'Last-Modified', lm.select('rfc').encode('utf-8')),
+			(b'Last-Modified', lm),
+			(b'ETag', tag),
 			(b'Accept-Ranges', b'bytes'),
 		])
 
-		if method == 'GET':
-			start, stop = ranges[0]
-			channel = ctl.invocations.system.read_file_range(str(selection), start, stop)
-			ctl.http_set_response(res, descr, rsize, cotype=ct)
+		if ranged:
+			ranges = requested_ranges(req, cosize)
+			if ranges != []:
+				if ranges is not None:
+					segments = memory.Segments.open(str(selection))
+					select = functools.partial(segments.select, size=1024*16)
+				else:
+					select = None
+				send_ranges(error, ctl, method, ct, cosize, ranges, select)
+				return
+
+		if coding is not None:
+			if cosize <= variant_limit:
+				data = variant
+				ctl.http_set_response(b'200', b'OK', len(data), cotype=ct)
+				if method == 'GET':
+					ctl.http_iterate_output([(data,)])
+				else:
+					ctl.connect(None)
+			else:
+				ctl.http_set_response(b'200', b'OK', None, cotype=ct)
+				if method == 'GET':
+					channel = ctl.invocations.system.read_file_range(str(selection), 0, cosize)
+					ctl.http_dispatch_output(channel, coding)
+					channel.f_transfer(None)
+				else:
+					ctl.connect(None)
+		elif method == 'GET':
+			channel = ctl.invocations.system.read_file_range(str(selection), 0, cosize)
+			ctl.http_set_response(b'200', b'OK', cosize, cotype=ct)
 			ctl.http_dispatch_output(channel)
 			channel.f_transfer(None)
 		elif method == 'HEAD':
-			ctl.http_set_response(res, descr, rsize, cotype=ct)
+			ctl.http_set_response(b'200', b'OK', cosize, cotype=ct)
 			ctl.connect(None)
 	except PermissionError:
 		error(ctl, 403, None)